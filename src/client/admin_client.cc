@@ -0,0 +1,88 @@
+#include <grpcpp/grpcpp.h>
+#include <grpcpp/generic/generic_stub.h>
+#include <grpcpp/support/byte_buffer.h>
+
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 调用 AdminService 的文本接口，例如：
+//   CCcloud_admin get-filter
+//   CCcloud_admin set-filter level=WARN upload.sample=0.1 all.tail=1
+//   CCcloud_admin stats
+//   CCcloud_admin rollups last=60 group=op,code merge=1
+//   CCcloud_admin hot by=client k=20 window=60
+int main(int argc, char** argv) {
+    std::string server = "localhost:9527";
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--server=", 0) == 0) {
+            server = arg.substr(9);
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    std::string method;
+    if (!args.empty() && args[0] == "get-filter") {
+        method = "/CCcloud.Admin/GetLogFilter";
+    } else if (!args.empty() && args[0] == "set-filter" && args.size() > 1) {
+        method = "/CCcloud.Admin/SetLogFilter";
+    } else if (!args.empty() && args[0] == "stats") {
+        method = "/CCcloud.Admin/GetLoggerStats";
+    } else if (!args.empty() && args[0] == "rollups") {
+        method = "/CCcloud.Admin/GetRollups";
+    } else if (!args.empty() && args[0] == "hot") {
+        method = "/CCcloud.Admin/GetHotKeys";
+    } else {
+        std::cerr << "Usage: " << argv[0] << " [--server=host:port] <command>\n"
+                  << "  get-filter\n"
+                  << "  set-filter key=value...   (level=INFO|WARN|ERROR, <op>.enabled|sample|slow_ms|tail=...,\n"
+                  << "                             <op> = upload|download|delete|all)\n"
+                  << "  stats                     logger queue depth, batch sizes, flush latency, bytes/s\n"
+                  << "  rollups [key=value...]    per-second access rollups (last=N, group=op,code,client, merge=0|1)\n"
+                  << "  hot [key=value...]        hottest files or clients (by=file|client, k=N, window=N)" << std::endl;
+        return 1;
+    }
+
+    std::string body;
+    for (size_t i = 1; i < args.size(); ++i) {
+        body += args[i] + "\n";
+    }
+    grpc::Slice slice(body);
+    grpc::ByteBuffer request(&slice, 1);
+    grpc::ByteBuffer response;
+
+    auto channel = grpc::CreateChannel(server, grpc::InsecureChannelCredentials());
+    grpc::GenericStub stub(channel);
+    grpc::ClientContext context;
+    context.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(5));
+
+    std::mutex mu;
+    std::condition_variable cv;
+    bool done = false;
+    grpc::Status status;
+    stub.UnaryCall(&context, method, grpc::StubOptions(), &request, &response, [&](grpc::Status s) {
+        std::lock_guard<std::mutex> lock(mu);
+        status = std::move(s);
+        done = true;
+        cv.notify_one();
+    });
+    std::unique_lock<std::mutex> lock(mu);
+    cv.wait(lock, [&]() { return done; });
+
+    if (!status.ok()) {
+        std::cerr << "Admin call failed: " << status.error_message() << std::endl;
+        return 2;
+    }
+    std::vector<grpc::Slice> slices;
+    if (response.Dump(&slices).ok()) {
+        for (const auto& s : slices) {
+            std::cout.write(reinterpret_cast<const char*>(s.begin()), static_cast<std::streamsize>(s.size()));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,687 @@
+#include <grpcpp/grpcpp.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "generated/file.grpc.pb.h"
+#include "logger/LogFileReader.hpp"
+#include "logger/LogFormatter.hpp"
+#include "logger/LogIndex.hpp"
+#include "logger/MmapLogQueue.hpp"
+
+namespace fs = std::filesystem;
+
+static constexpr size_t REPLAY_CHUNK_SIZE = 409600;                 // 与 CCCloudClient 上传的块大小一致
+static constexpr uint64_t REPLAY_MAX_SYNTH_SIZE = 64ull << 20;      // 合成大小的上限
+static constexpr int REPLAY_SEED_THREADS = 16;
+static constexpr size_t REPLAY_DEFAULT_MAX_THREADS = 256;   // 回放工作线程总数的默认上限
+
+
+struct ReplayOptions {
+    std::string server = "localhost:9527";
+    double speed = 1.0;                 // 2 表示以两倍速度回放
+    uint64_t size = 64 * 1024;          // 日志里没有 size= 时合成大小的中位数
+    size_t max_client_concurrency = 32;
+    size_t max_threads = REPLAY_DEFAULT_MAX_THREADS;     // 所有客户端共用的工作线程数上限
+    int64_t from = INT64_MIN;
+    int64_t to = INT64_MAX;
+    bool dry_run = false;
+};
+
+// 从访问日志还原出的一次请求
+struct ReplayOp {
+    int64_t start_us = 0;               // PREPARE 的时间；缺 PREPARE 时由 COMMIT 时间减去耗时推出
+    OperationType op = OperationType::UPLOAD;
+    std::string client;                 // 客户端 IP，不含端口
+    std::string filename;
+    uint64_t size = 0;
+    long long orig_ms = 0;
+    bool orig_ok = true;
+};
+
+struct ReplayResult {
+    OperationType op;
+    double ms;
+    double lag_ms;                      // 实际发出时间比计划晚了多少
+    bool ok;
+};
+
+
+// ----------------- 解析 -----------------
+
+// "key=value key2=value2" 中 key 的值
+static std::string_view param_of(std::string_view params, std::string_view key) {
+    size_t pos = 0;
+    while ((pos = params.find(key, pos)) != std::string_view::npos) {
+        if ((pos == 0 || params[pos - 1] == ' ') && pos + key.size() < params.size() && params[pos + key.size()] == '=') {
+            std::string_view value = params.substr(pos + key.size() + 1);
+            return value.substr(0, value.find(' '));
+        }
+        pos += key.size();
+    }
+    return {};
+}
+
+// 方括号中的下一个字段，pos 移到 ']' 之后
+static std::string_view next_bracket(std::string_view line, size_t& pos) {
+    size_t open = line.find('[', pos);
+    size_t close = open == std::string_view::npos ? open : line.find(']', open);
+    if (close == std::string_view::npos) {
+        pos = line.size();
+        return {};
+    }
+    pos = close + 1;
+    return line.substr(open + 1, close - open - 1);
+}
+
+// 文本日志的一行，见 LogFormatter；EVENT 等非访问记录返回 false
+struct ParsedLine {
+    int64_t us;
+    std::string_view uuid;
+    LogType type;
+    OperationType op;
+    std::string_view client;
+    std::string_view params;
+    long long ms = 0;
+    bool ok = true;
+
+    bool parse(std::string_view line) {
+        int64_t second;
+        if (!LogLine::time_of(line, second) || line.size() < 27 || line[20] != '.') {
+            return false;
+        }
+        int64_t micro = 0;
+        for (size_t i = 21; i < 27; ++i) {
+            if (line[i] < '0' || line[i] > '9') {
+                return false;
+            }
+            micro = micro * 10 + (line[i] - '0');
+        }
+        us = second * 1000000 + micro;
+        uuid = LogLine::uuid_of(line);
+        if (uuid.empty()) {
+            return false;
+        }
+
+        size_t pos = LOG_LINE_UUID_POS + LOG_LINE_UUID_LEN + 1;
+        next_bracket(line, pos);    // level
+        std::string_view type_text = next_bracket(line, pos);
+        std::string_view op_text = next_bracket(line, pos);
+        if (type_text == "PREPARE") {
+            type = LogType::PREPARE;
+        } else if (type_text == "COMMIT") {
+            type = LogType::COMMIT;
+        } else if (type_text == "ABORT") {
+            type = LogType::ABORT;
+        } else {
+            return false;
+        }
+        if (op_text == "UPLOAD") {
+            op = OperationType::UPLOAD;
+        } else if (op_text == "DOWNLOAD") {
+            op = OperationType::DOWNLOAD;
+        } else if (op_text == "DELETE") {
+            op = OperationType::DELETE;
+        } else {
+            return false;
+        }
+
+        std::string_view rest = line.substr(pos);
+        std::string_view endpoint = param_of(rest, "client");
+        client = endpoint.substr(0, endpoint.rfind(':'));    // IPv6 地址本身带冒号，端口在最后一个冒号之后
+        params = {};
+        size_t params_pos = rest.find(" params=");
+        if (params_pos != std::string_view::npos) {
+            params = rest.substr(params_pos + 8);
+            params = params.substr(0, params.find(" result="));
+        }
+        if (type != LogType::PREPARE) {
+            ok = param_of(rest, "result") == "OK";
+            std::string_view time = param_of(rest, "time");
+            ms = 0;
+            for (char c : time) {
+                if (c < '0' || c > '9') {
+                    break;
+                }
+                ms = ms * 10 + (c - '0');
+            }
+        }
+        return true;
+    }
+};
+
+class TraceBuilder {
+public:
+    explicit TraceBuilder(const ReplayOptions& options) : options_(options) {}
+
+    void add_line(std::string_view line) {
+        ParsedLine p;
+        if (!p.parse(line) || p.us / 1000000 < options_.from || p.us / 1000000 > options_.to) {
+            return;
+        }
+        std::string uuid(p.uuid);
+        if (p.type == LogType::PREPARE) {
+            ReplayOp& op = pending_[uuid];
+            op.start_us = p.us;
+            op.op = p.op;
+            op.client = p.client;
+            take_params(op, p.params);
+            return;
+        }
+        auto it = pending_.find(uuid);
+        ReplayOp op;
+        if (it != pending_.end()) {
+            op = std::move(it->second);
+            pending_.erase(it);
+        } else {
+            op.start_us = p.us - p.ms * 1000;
+            op.op = p.op;
+            op.client = p.client;
+        }
+        take_params(op, p.params);
+        op.orig_ms = p.ms;
+        op.orig_ok = p.ok;
+        if (op.filename.empty()) {
+            op.filename = "replay_" + uuid.substr(0, 8);    // 旧日志没有 filename=
+        }
+        ops_.push_back(std::move(op));
+    }
+
+    // 文本日志 (.txt / .txt.zst) 逐块读取，块尾不完整的行留到下一块
+    void add_log_file(const std::string& path) {
+        LogFileReader reader(path);
+        std::string carry;
+        constexpr size_t chunk = 4 * 1024 * 1024;
+        for (uint64_t pos = 0; pos < reader.size(); pos += chunk) {
+            std::string data = carry + reader.read_at(pos, chunk);
+            size_t begin = 0;
+            size_t end;
+            while ((end = data.find('\n', begin)) != std::string::npos) {
+                add_line(std::string_view(data).substr(begin, end - begin));
+                begin = end + 1;
+            }
+            carry = data.substr(begin);
+        }
+        if (!carry.empty()) {
+            add_line(carry);
+        }
+    }
+
+    // 二进制的崩溃安全环 (MmapLogQueue) 中尚未落盘的记录，按相同的文本格式解析
+    void add_ring_file(const std::string& path) {
+        std::vector<LogEntry> entries;
+        MmapLogQueue::read_unflushed(path, entries);
+        std::string text;
+        for (const auto& e : entries) {
+            text.clear();
+            LogFormatter::append(text, e);
+            text.pop_back();
+            add_line(text);
+        }
+    }
+
+    // 按开始时间排序，补上日志中没有的对象大小
+    std::vector<ReplayOp> finish() {
+        std::sort(ops_.begin(), ops_.end(), [](const ReplayOp& a, const ReplayOp& b) { return a.start_us < b.start_us; });
+        std::unordered_map<std::string, uint64_t> sizes;
+        for (auto& op : ops_) {
+            if (op.size == 0 && op.op != OperationType::DELETE) {
+                auto it = sizes.find(op.filename);
+                op.size = it != sizes.end() ? it->second : synth_size(op.filename);
+            }
+            if (op.op == OperationType::UPLOAD) {
+                sizes[op.filename] = op.size;
+            }
+        }
+        return std::move(ops_);
+    }
+
+private:
+    static void take_params(ReplayOp& op, std::string_view params) {
+        std::string_view filename = param_of(params, "filename");
+        if (!filename.empty()) {
+            op.filename = filename;
+        }
+        std::string_view size = param_of(params, "size");
+        if (!size.empty()) {
+            try {
+                op.size = std::stoull(std::string(size));
+            } catch (const std::exception&) {
+            }
+        }
+    }
+
+    // 同名文件总得到相同的大小：以文件名为种子的对数正态分布，中位数为 options_.size
+    uint64_t synth_size(const std::string& filename) const {
+        std::mt19937_64 rng(std::hash<std::string>{}(filename));
+        std::lognormal_distribution<double> dist(std::log(static_cast<double>(options_.size)), 1.0);
+        return std::clamp<uint64_t>(static_cast<uint64_t>(dist(rng)), 1, REPLAY_MAX_SYNTH_SIZE);
+    }
+
+    const ReplayOptions& options_;
+    std::unordered_map<std::string, ReplayOp> pending_;
+    std::vector<ReplayOp> ops_;
+};
+
+static void collect(const fs::path& path, std::vector<fs::path>& files) {
+    std::error_code ec;
+    if (!fs::is_directory(path, ec)) {
+        files.push_back(path);
+        return;
+    }
+    for (const auto& entry : fs::recursive_directory_iterator(path, ec)) {
+        std::string name = entry.path().filename().string();
+        if (entry.is_regular_file() && (name.ends_with(".txt") || name.ends_with(".txt.zst"))) {
+            files.push_back(entry.path());
+        }
+    }
+}
+
+
+// ----------------- 回放 -----------------
+
+static const std::string& payload() {
+    static const std::string data = [] {
+        std::string s(REPLAY_CHUNK_SIZE, '\0');
+        for (size_t i = 0; i < s.size(); ++i) {
+            s[i] = static_cast<char>('a' + i % 26);
+        }
+        return s;
+    }();
+    return data;
+}
+
+static bool run_op(CCcloud::FileService::Stub& stub, OperationType op, const std::string& filename, uint64_t size) {
+    grpc::ClientContext context;
+    switch (op) {
+        case OperationType::UPLOAD: {
+            CCcloud::UploadResponse response;
+            auto writer = stub.Upload(&context, &response);
+            uint64_t sent = 0;
+            do {
+                CCcloud::UploadChunk chunk;
+                if (sent == 0) {
+                    chunk.set_filename(filename);
+                }
+                size_t n = static_cast<size_t>(std::min<uint64_t>(REPLAY_CHUNK_SIZE, size - sent));
+                chunk.set_data(payload().data(), n);
+                if (!writer->Write(chunk)) {
+                    break;
+                }
+                sent += n;
+            } while (sent < size);
+            writer->WritesDone();
+            return writer->Finish().ok() && response.success();
+        }
+        case OperationType::DOWNLOAD: {
+            CCcloud::DownloadRequest request;
+            request.set_filename(filename);
+            auto reader = stub.Download(&context, request);
+            CCcloud::DownloadChunk chunk;
+            while (reader->Read(&chunk)) {
+            }
+            return reader->Finish().ok();
+        }
+        case OperationType::DELETE: {
+            CCcloud::DeleteRequest request;
+            CCcloud::DeleteResponse response;
+            request.set_filename(filename);
+            return stub.Delete(&context, request, &response).ok() && response.success();
+        }
+    }
+    return false;
+}
+
+// 每个客户端独占一条连接，否则 gRPC 会让同一进程内的 channel 共用子通道
+static std::shared_ptr<grpc::Channel> client_channel(const std::string& server) {
+    grpc::ChannelArguments args;
+    args.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+    args.SetMaxReceiveMessageSize(-1);
+    return grpc::CreateCustomChannel(server, grpc::InsecureChannelCredentials(), args);
+}
+
+// 原始日志中该客户端同时在途的最大请求数
+static size_t max_overlap(const std::vector<const ReplayOp*>& ops) {
+    std::vector<std::pair<int64_t, int>> events;
+    events.reserve(ops.size() * 2);
+    for (const ReplayOp* op : ops) {
+        events.emplace_back(op->start_us, 1);
+        events.emplace_back(op->start_us + std::max<long long>(op->orig_ms, 0) * 1000 + 1, -1);
+    }
+    std::sort(events.begin(), events.end());
+    int current = 0;
+    int best = 0;
+    for (const auto& e : events) {
+        current += e.second;
+        best = std::max(best, current);
+    }
+    return static_cast<size_t>(std::max(best, 1));
+}
+
+// 回放开始前就要存在的文件：第一次出现就是成功的下载或删除；原本就失败的请求照样让它失败
+static std::map<std::string, uint64_t> seed_files(const std::vector<ReplayOp>& ops) {
+    std::unordered_set<std::string> seen;
+    std::map<std::string, uint64_t> seeds;
+    for (const auto& op : ops) {
+        if (seen.insert(op.filename).second && op.op != OperationType::UPLOAD && op.orig_ok) {
+            seeds[op.filename] = op.size ? op.size : 1;
+        }
+    }
+    return seeds;
+}
+
+static double percentile(std::vector<double>& values, double p) {
+    if (values.empty()) {
+        return 0;
+    }
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * static_cast<double>(values.size())));
+    return values[std::min(values.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+static const char* op_name(OperationType op) {
+    switch (op) {
+        case OperationType::UPLOAD: return "UPLOAD";
+        case OperationType::DOWNLOAD: return "DOWNLOAD";
+        case OperationType::DELETE: return "DELETE";
+    }
+    return "?";
+}
+
+static void report(const std::vector<ReplayOp>& ops, const std::vector<ReplayResult>& results, double wall_sec) {
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "\n" << std::left << std::setw(10) << "op" << std::right << std::setw(8) << "count" << std::setw(8)
+              << "errors" << std::setw(10) << "p50" << std::setw(10) << "p90" << std::setw(10) << "p99"
+              << std::setw(10) << "p99.9" << std::setw(10) << "max" << std::setw(12) << "orig_p50" << std::setw(12)
+              << "orig_p99" << "   (ms)\n";
+    for (OperationType op : {OperationType::UPLOAD, OperationType::DOWNLOAD, OperationType::DELETE}) {
+        std::vector<double> ms;
+        std::vector<double> orig;
+        size_t errors = 0;
+        for (const auto& r : results) {
+            if (r.op == op) {
+                ms.push_back(r.ms);
+                errors += !r.ok;
+            }
+        }
+        for (const auto& o : ops) {
+            if (o.op == op) {
+                orig.push_back(static_cast<double>(o.orig_ms));
+            }
+        }
+        if (ms.empty()) {
+            continue;
+        }
+        std::sort(ms.begin(), ms.end());
+        std::sort(orig.begin(), orig.end());
+        std::cout << std::left << std::setw(10) << op_name(op) << std::right << std::setw(8) << ms.size()
+                  << std::setw(8) << errors << std::setw(10) << percentile(ms, 50) << std::setw(10)
+                  << percentile(ms, 90) << std::setw(10) << percentile(ms, 99) << std::setw(10)
+                  << percentile(ms, 99.9) << std::setw(10) << ms.back() << std::setw(12) << percentile(orig, 50)
+                  << std::setw(12) << percentile(orig, 99) << "\n";
+    }
+    std::vector<double> lag;
+    for (const auto& r : results) {
+        lag.push_back(r.lag_ms);
+    }
+    std::sort(lag.begin(), lag.end());
+    std::cout << "schedule lag ms: p50=" << percentile(lag, 50) << " p99=" << percentile(lag, 99)
+              << " max=" << (lag.empty() ? 0 : lag.back()) << "\n";
+    std::cout << results.size() << " requests in " << wall_sec << " s ("
+              << static_cast<double>(results.size()) / std::max(wall_sec, 1e-9) << " req/s)" << std::endl;
+}
+
+/*
+    按原始时间线回放：每个客户端 IP 一条连接，同时在途的请求数不超过原日志中该客户端的最大在途请求数
+    (也不超过 max_client_concurrency)。所有客户端共用 max_threads 个工作线程和一个按计划时刻
+    (start - first_start) / speed 排序的堆：堆里是还有请求、在途数没到上限的客户端，以其下一个请求的
+    开始时间为键。空闲的工作线程等到堆顶的计划时刻取出请求发出；线程或该客户端的并发都用满时请求推迟，
+    推迟量记为 schedule lag。线程数与客户端数无关。
+*/
+static std::vector<ReplayResult> replay(const std::vector<ReplayOp>& ops, const ReplayOptions& options) {
+    std::map<std::string, std::vector<const ReplayOp*>> by_client;
+    for (const auto& op : ops) {
+        by_client[op.client].push_back(&op);
+    }
+
+    struct Client {
+        std::vector<const ReplayOp*> ops;
+        size_t next = 0;                // 以下两项由 mutex 保护
+        size_t in_flight = 0;
+        size_t limit = 1;
+        std::unique_ptr<CCcloud::FileService::Stub> stub;
+    };
+    std::vector<std::unique_ptr<Client>> clients;
+    size_t wanted = 0;
+    for (auto& [ip, list] : by_client) {
+        auto client = std::make_unique<Client>();
+        client->ops = std::move(list);
+        client->stub = CCcloud::FileService::NewStub(client_channel(options.server));
+        client->limit = std::min(max_overlap(client->ops), options.max_client_concurrency);
+        wanted += client->limit;
+        std::cout << "client " << (ip.empty() ? "?" : ip) << ": " << client->ops.size() << " requests, "
+                  << client->limit << " concurrent" << std::endl;
+        clients.push_back(std::move(client));
+    }
+
+    int64_t first_us = ops.front().start_us;
+    auto t0 = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+    auto due_of = [&](const ReplayOp& op) {
+        return t0 + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double, std::micro>(static_cast<double>(op.start_us - first_us) / options.speed));
+    };
+
+    // 堆顶为下一个请求最早的客户端
+    using Ready = std::pair<int64_t, Client*>;
+    auto later = [](const Ready& a, const Ready& b) { return a.first > b.first; };
+    std::vector<Ready> ready;
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t remaining = ops.size();
+    auto push_ready = [&](Client* c) {
+        ready.emplace_back(c->ops[c->next]->start_us, c);
+        std::push_heap(ready.begin(), ready.end(), later);
+        if (ready.front().second == c) {
+            cv.notify_all();            // 新的堆顶更早，等待旧堆顶的线程要提前醒来
+        }
+    };
+    for (auto& client : clients) {
+        push_ready(client.get());
+    }
+
+    std::mutex results_mutex;
+    std::vector<ReplayResult> results;
+    results.reserve(ops.size());
+    size_t threads = std::min(options.max_threads, wanted);
+    std::cout << clients.size() << " clients, " << threads << " worker threads" << std::endl;
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < threads; ++i) {
+        workers.emplace_back([&]() {
+            std::vector<ReplayResult> local;
+            std::unique_lock<std::mutex> lock(mutex);
+            while (remaining > 0) {
+                if (ready.empty()) {
+                    cv.wait(lock);      // 剩下的客户端并发都已用满
+                    continue;
+                }
+                Client* c = ready.front().second;
+                const ReplayOp& op = *c->ops[c->next];
+                auto due = due_of(op);
+                if (std::chrono::steady_clock::now() < due) {
+                    cv.wait_until(lock, due);
+                    continue;
+                }
+                std::pop_heap(ready.begin(), ready.end(), later);
+                ready.pop_back();
+                ++c->next;
+                ++c->in_flight;
+                --remaining;
+                if (c->next < c->ops.size() && c->in_flight < c->limit) {
+                    push_ready(c);
+                }
+                lock.unlock();
+
+                auto begin = std::chrono::steady_clock::now();
+                bool ok = run_op(*c->stub, op.op, op.filename, op.size);
+                auto end = std::chrono::steady_clock::now();
+                local.push_back({op.op, std::chrono::duration<double, std::milli>(end - begin).count(),
+                                 std::chrono::duration<double, std::milli>(begin - due).count(), ok});
+
+                lock.lock();
+                if (c->in_flight-- == c->limit && c->next < c->ops.size()) {
+                    push_ready(c);      // 并发用满时不在堆里，空出一个位置后放回
+                }
+            }
+            cv.notify_all();            // 最后一个请求已发出，唤醒还在等的线程退出
+            lock.unlock();
+            std::lock_guard<std::mutex> results_lock(results_mutex);
+            results.insert(results.end(), local.begin(), local.end());
+        });
+    }
+    for (auto& t : workers) {
+        t.join();
+    }
+    return results;
+}
+
+// 回放访问日志，例如：
+//   CCcloud_replay /var/log/cccloud/2025-01-01
+//   CCcloud_replay --speed=4 --from=2025-01-01_12:00:00 --to=2025-01-01_13:00:00 /var/log/cccloud
+//   CCcloud_replay --dry-run access.ring
+int main(int argc, char** argv) {
+    ReplayOptions options;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        try {
+            if (arg.rfind("--server=", 0) == 0) {
+                options.server = arg.substr(9);
+            } else if (arg.rfind("--speed=", 0) == 0) {
+                options.speed = std::stod(arg.substr(8));
+                if (options.speed <= 0) {
+                    throw std::invalid_argument("speed must be positive");
+                }
+            } else if (arg.rfind("--size=", 0) == 0) {
+                options.size = std::max<uint64_t>(std::stoull(arg.substr(7)), 1);
+            } else if (arg.rfind("--max-client-concurrency=", 0) == 0) {
+                options.max_client_concurrency = std::max<size_t>(std::stoul(arg.substr(25)), 1);
+            } else if (arg.rfind("--max-threads=", 0) == 0) {
+                options.max_threads = std::max<size_t>(std::stoul(arg.substr(14)), 1);
+            } else if (arg.rfind("--from=", 0) == 0 || arg.rfind("--to=", 0) == 0) {
+                bool from = arg[2] == 'f';
+                std::string value = arg.substr(from ? 7 : 5);
+                int64_t second;
+                if (!LogLine::parse_time(value, second)) {
+                    throw std::invalid_argument("expected YYYY-MM-DD[_HH:MM:SS]");
+                }
+                if (from) {
+                    options.from = second;
+                } else {
+                    options.to = value.size() == 10 ? second + 86399 : second;
+                }
+            } else if (arg == "--dry-run") {
+                options.dry_run = true;
+            } else {
+                paths.push_back(arg);
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Invalid argument '" << arg << "': " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    if (paths.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [options] <log_dir|log_file|ring_file>...\n"
+                  << "  --server=host:port            target server (default localhost:9527)\n"
+                  << "  --speed=X                     replay X times faster than recorded (default 1)\n"
+                  << "  --size=BYTES                  median synthesized object size when the log has no size= (default 65536)\n"
+                  << "  --max-client-concurrency=N    cap on in-flight requests per client (default 32)\n"
+                  << "  --max-threads=N               cap on worker threads shared by all clients (default 256)\n"
+                  << "  --from=T --to=T               only replay requests in this range (YYYY-MM-DD[_HH:MM:SS])\n"
+                  << "  --dry-run                     print the reconstructed trace without sending requests\n"
+                  << "  files: <n>.txt, <n>.txt.zst, or a crash-safe ring file (*.ring*)" << std::endl;
+        return 1;
+    }
+
+    TraceBuilder builder(options);
+    std::vector<fs::path> files;
+    for (const auto& path : paths) {
+        collect(path, files);
+    }
+    for (const auto& file : files) {
+        try {
+            if (file.filename().string().find(".ring") != std::string::npos) {
+                builder.add_ring_file(file.string());
+            } else {
+                builder.add_log_file(file.string());
+            }
+        } catch (const std::exception& e) {
+            std::cerr << file.string() << ": " << e.what() << std::endl;
+        }
+    }
+    std::vector<ReplayOp> ops = builder.finish();
+    if (ops.empty()) {
+        std::cerr << "No completed requests found." << std::endl;
+        return 2;
+    }
+    std::map<std::string, uint64_t> seeds = seed_files(ops);
+    double span_sec = static_cast<double>(ops.back().start_us - ops.front().start_us) / 1e6;
+    std::cout << ops.size() << " requests over " << span_sec << " s, replay at " << options.speed << "x to "
+              << options.server << ", " << seeds.size() << " files to seed" << std::endl;
+
+    if (options.dry_run) {
+        for (const auto& op : ops) {
+            std::cout << (op.start_us - ops.front().start_us) / 1000 << "ms " << op_name(op.op) << " "
+                      << op.client << " " << op.filename << " size=" << op.size << " orig=" << op.orig_ms << "ms"
+                      << (op.orig_ok ? "" : " FAILED") << "\n";
+        }
+        return 0;
+    }
+
+    // 预先上传下载/删除要用到的文件，不计入结果
+    {
+        auto stub = CCcloud::FileService::NewStub(client_channel(options.server));
+        std::vector<std::pair<std::string, uint64_t>> list(seeds.begin(), seeds.end());
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> failed{0};
+        std::vector<std::thread> threads;
+        for (int i = 0; i < REPLAY_SEED_THREADS; ++i) {
+            threads.emplace_back([&]() {
+                size_t index;
+                while ((index = next.fetch_add(1)) < list.size()) {
+                    if (!run_op(*stub, OperationType::UPLOAD, list[index].first, list[index].second)) {
+                        failed++;
+                    }
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        if (failed > 0) {
+            std::cerr << failed << " of " << list.size() << " seed uploads failed" << std::endl;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<ReplayResult> results = replay(ops, options);
+    double wall_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report(ops, results, wall_sec);
+    return 0;
+}
@@ -1,109 +1,263 @@
 #pragma once
 
+#include <algorithm>
+#include <charconv>
 #include <chrono>
+#include <functional>
+#include <iostream>
 #include <string>
+#include <string_view>
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_generators.hpp>
 #include <boost/uuid/uuid_io.hpp>
 #include <grpcpp/server_context.h>
 
 #include "async_logger.hpp"
+#include "LogAggregator.hpp"
+#include "LogFilter.hpp"
+#include "LogHeavyHitters.hpp"
+#ifdef CCCLOUD_CRASH_SAFE_LOG
+#include "MmapLogQueue.hpp"
+#define ACCESS_LOG_RING_PATH DEFAULT_LOG_PATH "/access.ring"  // 访问日志的崩溃安全队列文件
+#endif
+#define ACCESS_ROLLUP_PATH DEFAULT_LOG_PATH "/rollups"          // 按秒聚合结果的落盘目录
 
 
 template <typename _Tp>
-concept CTX = is_base_of_v<grpc::ServerContextBase, _Tp>;
+concept CTX = std::is_base_of_v<grpc::ServerContextBase, _Tp>;
+
+/*
+    访问日志的 params。文件名和大小分开传入，记录通过 LogFilter 之后才在栈上格式化为
+    "filename=<name>[ size=<bytes>]" 写进 LogText，被过滤的调用不做任何分配。
+    也可以直接传入一段文本（如 "upload started"），原样写入。
+*/
+class AccessParams {
+public:
+    AccessParams(std::string_view text = {}) : text_(text) {}
+    AccessParams(const char* text) : text_(text) {}
+
+    static AccessParams file(std::string_view filename) {
+        AccessParams p;
+        p.filename_ = filename;
+        p.is_file_ = true;
+        return p;
+    }
+
+    static AccessParams file(std::string_view filename, uint64_t size) {
+        AccessParams p = file(filename);
+        p.size_ = size;
+        p.has_size_ = true;
+        return p;
+    }
+
+    // 写入 text，过长时截断（与 LogText::assign 一致）
+    void assign_to(LogText& text, std::string_view error) const {
+        if (!is_file_) {
+            text.assign(text_, error);
+            return;
+        }
+        char buf[LogTextSlab::BLOCK_PAYLOAD];
+        char* const end = buf + sizeof(buf);
+        char* out = append(buf, end, "filename=");
+        out = append(out, end, filename_);
+        if (has_size_) {
+            out = append(out, end, " size=");
+            auto [ptr, ec] = std::to_chars(out, end, size_);
+            out = ec == std::errc() ? ptr : out;
+        }
+        text.assign(std::string_view(buf, static_cast<size_t>(out - buf)), error);
+    }
+
+private:
+    static char* append(char* out, char* end, std::string_view s) {
+        size_t n = std::min(s.size(), static_cast<size_t>(end - out));
+        return std::copy_n(s.data(), n, out);
+    }
+
+    std::string_view text_;
+    std::string_view filename_;
+    uint64_t size_ = 0;
+    bool is_file_ = false;
+    bool has_size_ = false;
+};
 
 class AccessLogger {
 public:
-    static std::string generate_uuid() {
+    static LogUuid generate_uuid() {
         static thread_local boost::uuids::random_generator gen;
-        return boost::uuids::to_string(gen());
+        boost::uuids::uuid id = gen();
+        return LogUuid::from_bytes(id.data);
     }
 
     template <typename _CT>
-    static void log_prepare(const std::string& uuid,
+    static void log_prepare(const LogUuid& uuid,
                             _CT* context,
                             OperationType op,
-                            const std::string& params) {
+                            const AccessParams& params) {
+        if (!LogFilter::instance().keep_prepare(op, uuid)) {
+            return;
+        }
         LogEntry log;
         log.uuid = uuid;
-        log.timestamp = std::chrono::system_clock::now();
         log.log_type = LogType::PREPARE;
         log.level = Level::INFO;
         log.operation = op;
         parse_context_info(context, log);
-        log.params = params;
+        params.assign_to(log.text, {});
         log.status_code = grpc::StatusCode::OK;
 
-        AsyncLogger<>::instance().append(std::move(log));
+        logger().append(std::move(log));
     }
 
     template <typename _CT>
-    static void log_commit(const std::string& uuid,
+    static void log_commit(const LogUuid& uuid,
                            _CT* context,
                            OperationType op,
-                           const std::string& params,
+                           const AccessParams& params,
                            grpc::StatusCode code,
                            long long duration_ms,
-                           const std::string& error_msg = "") {
+                           std::string_view error_msg = {}) {
         LogEntry log;
-        log.uuid = uuid;
-        log.timestamp = std::chrono::system_clock::now();
-        log.log_type = LogType::COMMIT;
-        log.level = code == grpc::StatusCode::OK ? Level::INFO : Level::ERROR;
-        log.operation = op;
-        parse_context_info(context, log);
-        log.params = params;
-        log.status_code = code;
-        log.duration_ms = duration_ms;
-        log.error_message = error_msg;
+        if (make_commit(log, uuid, context, op, params, code, duration_ms, error_msg)) {
+            logger().append(std::move(log));
+        }
+    }
 
-        AsyncLogger<>::instance().append(std::move(log));
+    /*
+        与 log_commit 相同，但 on_durable 要等记录按 durability 写出/落盘后才在 flush 线程上调用，
+        用于删除、错误等需要先持久化审计日志再应答的请求。参数为 false 表示记录没能写入或落盘，
+        调用方应当让请求失败。审计记录不经过 LogFilter 的级别过滤和采样，总是写出。
+    */
+    template <typename _CT>
+    static void log_commit_durable(const LogUuid& uuid,
+                                   _CT* context,
+                                   OperationType op,
+                                   const AccessParams& params,
+                                   grpc::StatusCode code,
+                                   long long duration_ms,
+                                   std::string_view error_msg,
+                                   Durability durability,
+                                   std::function<void(bool)> on_durable) {
+        LogEntry log;
+        make_commit(log, uuid, context, op, params, code, duration_ms, error_msg, true);
+        logger().append(std::move(log), durability, std::move(on_durable));
     }
 
     template <typename _CT>
-    static void log_abort(const std::string& uuid,
+    static void log_abort(const LogUuid& uuid,
                           _CT* context,
                           OperationType op,
                           grpc::StatusCode code,
-                          const std::string& reason,
+                          std::string_view reason,
                           long long duration_ms) {
         log_commit(uuid, context, op, "", code, duration_ms, reason);
     }
 
 private:
+    // 定义 CCCLOUD_CRASH_SAFE_LOG 时访问日志经过 mmap 环形文件，进程崩溃后未落盘的记录在下次启动时补写
+    // 第一次使用时挂上按秒聚合 (LogAggregator) 与热点统计 (LogHeavyHitters)，
+    // 可通过 CCcloud_admin rollups / hot 查询
+    static auto& logger() {
+#ifdef CCCLOUD_CRASH_SAFE_LOG
+        static auto& instance = with_observers(AsyncLogger<MmapLogQueue>::instance(DEFAULT_LOG_PATH, std::string(ACCESS_LOG_RING_PATH)));
+#else
+        static auto& instance = with_observers(AsyncLogger<>::instance());
+#endif
+        return instance;
+    }
+
+    template <typename L>
+    static L& with_observers(L& logger) {
+        logger.add_observer(std::make_shared<LogAggregator>(ACCESS_ROLLUP_PATH));
+        logger.add_observer(std::make_shared<LogHeavyHitters>());
+        return logger;
+    }
+
+    // 过滤并填充 COMMIT 记录，被过滤时返回 false。durable 为 true 时不过滤，只补写缺少的 PREPARE
+    template <typename _CT>
+    static bool make_commit(LogEntry& log,
+                            const LogUuid& uuid,
+                            _CT* context,
+                            OperationType op,
+                            const AccessParams& params,
+                            grpc::StatusCode code,
+                            long long duration_ms,
+                            std::string_view error_msg,
+                            bool durable = false) {
+        bool with_prepare = false;
+        uint32_t sample_ppm = 0;
+        if (durable) {
+            with_prepare = LogFilter::instance().prepare_skipped(op, uuid);
+        } else if (!LogFilter::instance().keep_commit(op, uuid, code, duration_ms, with_prepare, sample_ppm)) {
+            return false;
+        }
+        if (with_prepare) {
+            // 尾部采样推迟（或审计记录的 PREPARE 被过滤）了 PREPARE，按请求开始的时间补写
+            LogEntry prepare;
+            prepare.timestamp = TscClock::minus(prepare.timestamp, std::chrono::milliseconds(duration_ms));
+            prepare.uuid = uuid;
+            prepare.log_type = LogType::PREPARE;
+            prepare.level = Level::INFO;
+            prepare.operation = op;
+            parse_context_info(context, prepare);
+            params.assign_to(prepare.text, {});
+            logger().append(std::move(prepare));
+        }
+
+        log.uuid = uuid;
+        log.log_type = LogType::COMMIT;
+        log.level = code == grpc::StatusCode::OK ? Level::INFO : Level::ERROR;
+        log.operation = op;
+        parse_context_info(context, log);
+        params.assign_to(log.text, error_msg);
+        log.status_code = code;
+        log.duration_ms = LogEntry::clamp_ms(duration_ms);
+        log.sample_ppm = sample_ppm;
+        return true;
+    }
+
     template <typename _CT>
     static void parse_context_info(_CT* context, LogEntry& log) {
-        std::string peer = context->peer();  // 例如: "ipv4:192.168.1.5:5000"
+        static const NetAddr server_addr = NetAddr::any(9527);
+        const std::string peer = context->peer();  // 例如: "ipv4:192.168.1.5:5000" / "ipv6:[::1]:5000"
+        std::string_view view(peer);
 
-        log.client_ip = "0.0.0.0"; // 解析失败时设为默认IP
-        log.client_port = 0;       // 解析失败时设为默认端口
+        log.client = NetAddr::any(0);  // 解析失败时设为默认IP和端口
+        log.server = server_addr;
 
-        size_t first_colon_pos = peer.find(':');
+        size_t first_colon_pos = view.find(':');
+        if (first_colon_pos == std::string_view::npos) {
+            std::cerr << "Peer 字符串格式不正确，找不到协议分隔符: " << peer << std::endl;
+            return;
+        }
 
-        if (first_colon_pos != std::string::npos) {
-            size_t last_colon_pos = peer.rfind(':');
+        size_t last_colon_pos = view.rfind(':');
+        if (last_colon_pos == std::string_view::npos || last_colon_pos <= first_colon_pos) {
+            std::cerr << "Peer 字符串格式不正确，找不到端口分隔符或格式错误: " << peer << std::endl;
+            return;
+        }
 
-            if (last_colon_pos != std::string::npos && last_colon_pos > first_colon_pos) {
-                try {
-                    log.client_ip = peer.substr(first_colon_pos + 1, last_colon_pos - (first_colon_pos + 1));
+        std::string_view host = view.substr(first_colon_pos + 1, last_colon_pos - (first_colon_pos + 1));
+        std::string_view port_str = view.substr(last_colon_pos + 1);
 
-                    std::string port_str = peer.substr(last_colon_pos + 1);
-                    log.client_port = std::stoi(port_str);
+        // IPv6 地址带方括号，部分 gRPC 版本会做 URL 编码 (%5B / %5D)
+        if (host.size() >= 2 && host.front() == '[' && host.back() == ']') {
+            host = host.substr(1, host.size() - 2);
+        } else if (host.size() >= 6 && host.starts_with("%5B") && host.ends_with("%5D")) {
+            host = host.substr(3, host.size() - 6);
+        }
 
-                } catch (const std::invalid_argument& ia) {
-                    std::cerr << "端口转换错误 (peer: " << peer << "): " << ia.what() << std::endl;
-                } catch (const std::exception& e) {
-                    std::cerr << "解析 peer 字符串时发生未知错误 (peer: " << peer << "): " << e.what() << std::endl;
-                }
-            } else {
-                std::cerr << "Peer 字符串格式不正确，找不到端口分隔符或格式错误: " << peer << std::endl;
-            }
-        } else {
-            std::cerr << "Peer 字符串格式不正确，找不到协议分隔符: " << peer << std::endl;
+        uint16_t port = 0;
+        auto [ptr, ec] = std::from_chars(port_str.data(), port_str.data() + port_str.size(), port);
+        if (ec != std::errc() || ptr != port_str.data() + port_str.size()) {
+            std::cerr << "端口转换错误 (peer: " << peer << ")" << std::endl;
+            return;
         }
 
-        log.server_ip = "0.0.0.0";
-        log.server_port = 9527;
+        if (!log.client.parse_ip(host)) {
+            std::cerr << "解析 peer 字符串时发生未知错误 (peer: " << peer << "): 无效的 IP 地址" << std::endl;
+            return;
+        }
+        log.client.port = port;
     }
 };
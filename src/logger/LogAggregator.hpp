@@ -0,0 +1,533 @@
+/*
+    访问日志的实时聚合：按秒统计每个 (操作, 状态码, 客户端 IP) 的请求数和耗时直方图。
+
+    作为 LogObserver 挂在 AsyncLogger 上，在 flush 线程上消费 COMMIT / ABORT 记录，不解析文本。
+    内存中保留最近 LOG_ROLLUP_SECONDS 秒，每秒最多 LOG_ROLLUP_KEYS 个组合，超出的客户端合并为 client=other
+    （保留操作和状态码）；连这样的组合也放不下时，其余请求合并到最后预留的一行 op=other code=other client=other，
+    占用的内存固定。耗时直方图按 2 的幂分桶，可以直接相加，任意时间段 / 维度合并后再估算分位数。
+
+    一秒结束 LOG_ROLLUP_GRACE_SEC 之后该秒封存，追加写入 <dir>/<YYYY-MM-DD>.rollup（紧凑的变长编码，
+    可用 cclog_query rollups 读取）。比已封存的秒更早到达的记录只计入 late 计数。
+    被 LogFilter 采样保留的记录按 LogEntry::sample_weight（1 / 采样率）计数，采样时的 QPS、错误率和耗时分布
+    仍是无偏估计；被级别过滤或整类关闭的请求不进入日志，也就不计入聚合。
+*/
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "LogEntry.hpp"
+#include "LogQuery.hpp"
+#include "LogSchema.hpp"
+#include "LogSink.hpp"
+
+static constexpr size_t LOG_ROLLUP_SECONDS = 300;       // 内存中保留的秒数
+static constexpr size_t LOG_ROLLUP_KEYS = 64;           // 每秒最多的组合数，最后一个位置留给全部为 other 的合并行
+static constexpr uint8_t LOG_ROLLUP_OTHER = 0xFF;       // 合并行的操作和状态码（不是合法的 OperationType / grpc 状态码）
+static constexpr size_t LOG_LATENCY_BUCKETS = 20;       // 0ms, 1ms, [2,3], [4,7], ... [2^18, +inf)
+static constexpr int64_t LOG_ROLLUP_GRACE_SEC = 2;      // 晚到的记录在这么久之内仍计入对应的秒
+
+
+struct LatencyHistogram {
+    std::array<uint32_t, LOG_LATENCY_BUCKETS> counts{};
+
+    static size_t bucket(long long ms) {
+        if (ms <= 0) {
+            return 0;
+        }
+        return std::min<size_t>(std::bit_width(static_cast<uint64_t>(ms)), LOG_LATENCY_BUCKETS - 1);
+    }
+
+    // 桶的上界，作为分位数的估计值
+    static uint64_t upper_bound(size_t b) {
+        return b == 0 ? 0 : (uint64_t{1} << b) - 1;
+    }
+
+    void add(long long ms, uint64_t weight = 1) {
+        counts[bucket(ms)] += static_cast<uint32_t>(weight);
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < LOG_LATENCY_BUCKETS; ++i) {
+            counts[i] += other.counts[i];
+        }
+    }
+
+    uint64_t quantile(double q) const {
+        uint64_t total = 0;
+        for (uint32_t c : counts) {
+            total += c;
+        }
+        uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total) + 0.5);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < LOG_LATENCY_BUCKETS; ++i) {
+            seen += counts[i];
+            if (seen >= rank && seen > 0) {
+                return upper_bound(i);
+            }
+        }
+        return 0;
+    }
+};
+
+struct RollupKey {
+    OperationType op = OperationType::UPLOAD;
+    uint8_t code = 0;                   // grpc::StatusCode
+    NetAddr::Family family = NetAddr::Family::NONE;     // NONE 表示 client=other
+    std::array<uint8_t, 16> addr{};
+
+    bool operator==(const RollupKey&) const = default;
+
+    // 每秒的组合用完之后，其余请求都计入这一行
+    static RollupKey other() {
+        RollupKey k;
+        k.op = static_cast<OperationType>(LOG_ROLLUP_OTHER);
+        k.code = LOG_ROLLUP_OTHER;
+        return k;
+    }
+
+    std::string op_name() const {
+        return static_cast<uint8_t>(op) == LOG_ROLLUP_OTHER ? "other" : std::string(operation_name(op));
+    }
+
+    std::string code_name() const {
+        return code == LOG_ROLLUP_OTHER ? "other" : std::to_string(code);
+    }
+
+    std::string client() const {
+        if (family == NetAddr::Family::NONE) {
+            return "other";
+        }
+        NetAddr a;
+        a.family = family;
+        a.addr = addr;
+        return a.ip_string();
+    }
+};
+
+struct RollupRow {
+    int64_t second = 0;                 // unix 秒
+    RollupKey key;
+    uint64_t count = 0;
+    uint64_t latency_sum_ms = 0;
+    uint64_t max_ms = 0;
+    LatencyHistogram latency;
+
+    // weight 为这条记录代表的请求数（采样保留的记录大于 1）
+    void add(long long ms, uint64_t weight = 1) {
+        count += weight;
+        uint64_t v = ms > 0 ? static_cast<uint64_t>(ms) : 0;
+        latency_sum_ms += v * weight;
+        max_ms = std::max(max_ms, v);
+        latency.add(ms, weight);
+    }
+
+    void merge(const RollupRow& other) {
+        count += other.count;
+        latency_sum_ms += other.latency_sum_ms;
+        max_ms = std::max(max_ms, other.max_ms);
+        latency.merge(other.latency);
+    }
+};
+
+
+class LogAggregator : public LogObserver {
+public:
+    // persist_dir 为空时不落盘
+    explicit LogAggregator(std::string persist_dir = "") : persist_dir_(std::move(persist_dir)) {
+        for (auto& slot : slots_) {
+            slot.second = -1;
+        }
+        LogQueryRegistry<LogAggregator>::add(this);
+    }
+
+    ~LogAggregator() override {
+        LogQueryRegistry<LogAggregator>::remove(this);
+        flush();
+    }
+
+    void observe(const std::vector<LogEntry>& batch) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& e : batch) {
+            if (e.log_type != LogType::COMMIT && e.log_type != LogType::ABORT) {
+                continue;
+            }
+            int64_t second = std::chrono::duration_cast<std::chrono::seconds>(TscClock::to_system(e.timestamp).time_since_epoch()).count();
+            if (second <= sealed_until_) {
+                late_++;
+                continue;
+            }
+            newest_ = std::max(newest_, second);
+            RollupKey key;
+            key.op = e.operation;
+            key.code = static_cast<uint8_t>(e.status_code);
+            key.family = e.client.family;
+            key.addr = e.client.addr;
+            row_for(second, key).add(e.duration_ms, e.sample_weight());
+        }
+        seal_until(newest_ - LOG_ROLLUP_GRACE_SEC);
+    }
+
+    // 停止时封存全部
+    void flush() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        seal_until(newest_);
+        if (out_.is_open()) {
+            out_.flush();
+        }
+    }
+
+    /*
+        查询最近的聚合结果。spec 为以空白分隔的 key=value 列表：
+            last=N          最近 N 秒（默认 60，最多 LOG_ROLLUP_SECONDS）
+            group=op,code,client    保留的维度，其余维度合并（默认全部保留）
+            merge=0|1       为 1 时把各秒合并为一行，并给出 qps
+        出错时返回 false 并写入 error。
+    */
+    bool query(std::string_view spec, std::string& out, std::string& error) const {
+        int64_t last = 60;
+        bool by_op = true, by_code = true, by_client = true, merge = false;
+        bool parsed = parse_query(spec, [&](std::string_view k, std::string_view v) {
+            if (k == "last") {
+                try {
+                    last = std::stoll(std::string(v));
+                } catch (const std::exception&) {
+                    last = 0;
+                }
+                if (last <= 0 || last > static_cast<int64_t>(LOG_ROLLUP_SECONDS)) {
+                    error = "last must be within [1, " + std::to_string(LOG_ROLLUP_SECONDS) + "]";
+                    return false;
+                }
+            } else if (k == "group") {
+                by_op = by_code = by_client = false;
+                size_t p = 0;
+                while (p <= v.size()) {
+                    size_t e = v.find(',', p);
+                    std::string_view dim = v.substr(p, e == std::string_view::npos ? std::string_view::npos : e - p);
+                    if (dim == "op") {
+                        by_op = true;
+                    } else if (dim == "code") {
+                        by_code = true;
+                    } else if (dim == "client") {
+                        by_client = true;
+                    } else if (!dim.empty()) {
+                        error = "unknown group dimension: " + std::string(dim);
+                        return false;
+                    }
+                    if (e == std::string_view::npos) {
+                        break;
+                    }
+                    p = e + 1;
+                }
+            } else if (k == "merge") {
+                merge = v == "1";
+            } else {
+                error = "unknown key: " + std::string(k);
+                return false;
+            }
+            return true;
+        });
+        if (!parsed) {
+            return false;
+        }
+
+        int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        std::vector<RollupRow> rows = snapshot(now - last);
+
+        // (秒, 操作, 状态码, 客户端) -> 合并后的行
+        std::map<std::tuple<int64_t, int, int, std::string>, RollupRow> merged;
+        for (const auto& r : rows) {
+            auto key = std::make_tuple(merge ? 0 : r.second,
+                                       by_op ? static_cast<int>(r.key.op) : -1,
+                                       by_code ? static_cast<int>(r.key.code) : -1,
+                                       by_client ? r.key.client() : std::string());
+            auto it = merged.try_emplace(key, RollupRow{}).first;
+            it->second.key = r.key;
+            it->second.merge(r);
+        }
+
+        std::ostringstream oss;
+        oss << std::fixed << std::setprecision(1);
+        for (const auto& [k, r] : merged) {
+            if (merge) {
+                oss << "last=" << last << "s";
+            } else {
+                oss << format_second(std::get<0>(k));
+            }
+            if (by_op) {
+                oss << " op=" << r.key.op_name();
+            }
+            if (by_code) {
+                oss << " code=" << r.key.code_name();
+            }
+            if (by_client) {
+                oss << " client=" << std::get<3>(k);
+            }
+            oss << " count=" << r.count;
+            if (merge) {
+                oss << " qps=" << static_cast<double>(r.count) / static_cast<double>(last);
+            }
+            write_latency(oss, r);
+        }
+        out = oss.str();
+        return true;
+    }
+
+    // 完整的一行，供 cclog_query 输出落盘的结果
+    static std::string describe(const RollupRow& r) {
+        std::ostringstream oss;
+        oss << std::fixed << std::setprecision(1);
+        oss << format_second(r.second) << " op=" << r.key.op_name() << " code=" << r.key.code_name()
+            << " client=" << r.key.client() << " count=" << r.count;
+        write_latency(oss, r);
+        return oss.str();
+    }
+
+    uint64_t late() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return late_;
+    }
+
+    // 进程内全部聚合器的查询结果
+    static bool query_all(std::string_view spec, std::string& out, std::string& error) {
+        return LogQueryRegistry<LogAggregator>::query_all(spec, out, error);
+    }
+
+    // ----------------- 落盘格式 -----------------
+    // 每行：int64 秒, op, code, family, 地址 (4/16/0 字节), varint count / sum / max,
+    //       uint32 非零桶掩码, 每个非零桶一个 varint
+
+    static void encode(std::string& out, const RollupRow& r) {
+        out.append(reinterpret_cast<const char*>(&r.second), sizeof(r.second));
+        out.push_back(static_cast<char>(r.key.op));
+        out.push_back(static_cast<char>(r.key.code));
+        out.push_back(static_cast<char>(r.key.family));
+        out.append(reinterpret_cast<const char*>(r.key.addr.data()), addr_len(r.key.family));
+        put_varint(out, r.count);
+        put_varint(out, r.latency_sum_ms);
+        put_varint(out, r.max_ms);
+        uint32_t mask = 0;
+        for (size_t i = 0; i < LOG_LATENCY_BUCKETS; ++i) {
+            if (r.latency.counts[i]) {
+                mask |= uint32_t{1} << i;
+            }
+        }
+        out.append(reinterpret_cast<const char*>(&mask), sizeof(mask));
+        for (size_t i = 0; i < LOG_LATENCY_BUCKETS; ++i) {
+            if (r.latency.counts[i]) {
+                put_varint(out, r.latency.counts[i]);
+            }
+        }
+    }
+
+    // 读取 .rollup 文件，末尾不完整的一行（写入时崩溃）被忽略
+    static std::vector<RollupRow> read_file(const std::string& path) {
+        std::ifstream ifs(path, std::ios::binary);
+        if (!ifs.is_open()) {
+            throw std::runtime_error("Failed to open rollup file: " + path);
+        }
+        std::string data((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+        std::vector<RollupRow> rows;
+        size_t pos = 0;
+        while (pos < data.size()) {
+            RollupRow r;
+            if (!decode(data, pos, r)) {
+                break;
+            }
+            rows.push_back(r);
+        }
+        return rows;
+    }
+
+    static std::string format_second(int64_t second) {
+        std::time_t t = static_cast<std::time_t>(second);
+        std::tm tm_time;
+        localtime_r(&t, &tm_time);
+        char buf[32];
+        std::strftime(buf, sizeof(buf), "%Y-%m-%d_%H:%M:%S", &tm_time);
+        return buf;
+    }
+
+private:
+    struct Slot {
+        int64_t second;
+        size_t used = 0;
+        std::array<RollupRow, LOG_ROLLUP_KEYS> rows;
+    };
+
+    RollupRow& row_for(int64_t second, const RollupKey& key) {
+        Slot& slot = slots_[static_cast<size_t>(second) % LOG_ROLLUP_SECONDS];
+        if (slot.second != second) {
+            // 旧的秒早已封存
+            slot.second = second;
+            slot.used = 0;
+        }
+        // 依次尝试：原样、client=other、全部为 other；最后一行只留给全部为 other 的合并行，它总能放下
+        RollupKey k = key;
+        while (true) {
+            for (size_t i = 0; i < slot.used; ++i) {
+                if (slot.rows[i].key == k) {
+                    return slot.rows[i];
+                }
+            }
+            bool other = k == RollupKey::other();
+            if (slot.used + 1 < LOG_ROLLUP_KEYS || (other && slot.used < LOG_ROLLUP_KEYS)) {
+                RollupRow& row = slot.rows[slot.used++];
+                row = RollupRow{};
+                row.second = second;
+                row.key = k;
+                return row;
+            }
+            if (k.family != NetAddr::Family::NONE) {
+                k.family = NetAddr::Family::NONE;
+                k.addr = {};
+            } else {
+                k = RollupKey::other();
+            }
+        }
+    }
+
+    // 封存 (sealed_until_, until] 之间的秒
+    void seal_until(int64_t until) {
+        if (until <= sealed_until_) {
+            return;
+        }
+        if (sealed_until_ < until - static_cast<int64_t>(LOG_ROLLUP_SECONDS)) {
+            sealed_until_ = until - static_cast<int64_t>(LOG_ROLLUP_SECONDS);
+        }
+        std::string buffer;
+        for (int64_t s = sealed_until_ + 1; s <= until; ++s) {
+            const Slot& slot = slots_[static_cast<size_t>(s) % LOG_ROLLUP_SECONDS];
+            if (slot.second != s || slot.used == 0 || persist_dir_.empty()) {
+                continue;
+            }
+            for (size_t i = 0; i < slot.used; ++i) {
+                encode(buffer, slot.rows[i]);
+            }
+            write(s, buffer);
+            buffer.clear();
+        }
+        sealed_until_ = until;
+    }
+
+    void write(int64_t second, const std::string& data) {
+        std::string date = format_second(second).substr(0, 10);
+        if (date != out_date_ || !out_.is_open()) {
+            out_.close();
+            std::error_code ec;
+            std::filesystem::create_directories(persist_dir_, ec);
+            out_.open(std::filesystem::path(persist_dir_) / (date + ".rollup"), std::ios::app | std::ios::binary);
+            out_date_ = date;
+            if (!out_.is_open()) {
+                std::cerr << "Failed to open rollup file in " << persist_dir_ << std::endl;
+                return;
+            }
+        }
+        out_.write(data.data(), static_cast<std::streamsize>(data.size()));
+        out_.flush();
+    }
+
+    std::vector<RollupRow> snapshot(int64_t after) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<RollupRow> rows;
+        for (const auto& slot : slots_) {
+            if (slot.second > after) {
+                rows.insert(rows.end(), slot.rows.begin(), slot.rows.begin() + static_cast<std::ptrdiff_t>(slot.used));
+            }
+        }
+        return rows;
+    }
+
+    static void write_latency(std::ostream& os, const RollupRow& r) {
+        os << " avg_ms=" << (r.count ? static_cast<double>(r.latency_sum_ms) / static_cast<double>(r.count) : 0.0)
+           << " p50_ms<=" << std::min(r.latency.quantile(0.5), r.max_ms)
+           << " p99_ms<=" << std::min(r.latency.quantile(0.99), r.max_ms)
+           << " max_ms=" << r.max_ms << "\n";
+    }
+
+    static size_t addr_len(NetAddr::Family family) {
+        return family == NetAddr::Family::V4 ? 4 : family == NetAddr::Family::V6 ? 16 : 0;
+    }
+
+    static void put_varint(std::string& out, uint64_t v) {
+        while (v >= 0x80) {
+            out.push_back(static_cast<char>(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<char>(v));
+    }
+
+    static bool get_varint(const std::string& in, size_t& pos, uint64_t& v) {
+        v = 0;
+        for (int shift = 0; shift < 64 && pos < in.size(); shift += 7) {
+            uint8_t b = static_cast<uint8_t>(in[pos++]);
+            v |= static_cast<uint64_t>(b & 0x7f) << shift;
+            if (!(b & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool decode(const std::string& in, size_t& pos, RollupRow& r) {
+        if (in.size() - pos < sizeof(r.second) + 3) {
+            return false;
+        }
+        std::memcpy(&r.second, in.data() + pos, sizeof(r.second));
+        pos += sizeof(r.second);
+        r.key.op = static_cast<OperationType>(in[pos++]);
+        r.key.code = static_cast<uint8_t>(in[pos++]);
+        r.key.family = static_cast<NetAddr::Family>(in[pos++]);
+        size_t len = addr_len(r.key.family);
+        if (in.size() - pos < len) {
+            return false;
+        }
+        std::memcpy(r.key.addr.data(), in.data() + pos, len);
+        pos += len;
+        uint32_t mask = 0;
+        if (!get_varint(in, pos, r.count) || !get_varint(in, pos, r.latency_sum_ms) ||
+            !get_varint(in, pos, r.max_ms) || in.size() - pos < sizeof(mask)) {
+            return false;
+        }
+        std::memcpy(&mask, in.data() + pos, sizeof(mask));
+        pos += sizeof(mask);
+        for (size_t i = 0; i < LOG_LATENCY_BUCKETS; ++i) {
+            if (mask & (uint32_t{1} << i)) {
+                uint64_t c;
+                if (!get_varint(in, pos, c)) {
+                    return false;
+                }
+                r.latency.counts[i] = static_cast<uint32_t>(c);
+            }
+        }
+        return true;
+    }
+
+    mutable std::mutex mutex_;
+    std::array<Slot, LOG_ROLLUP_SECONDS> slots_;
+    int64_t newest_ = 0;
+    int64_t sealed_until_ = 0;      // 不大于该秒的记录已封存
+    uint64_t late_ = 0;
+    std::string persist_dir_;
+    std::ofstream out_;
+    std::string out_date_;
+};
@@ -0,0 +1,169 @@
+/*
+    后台压缩已经滚动出去的日志文件：<n>.txt -> <n>.txt.zst (seekable 格式)。
+
+    压缩线程以最低 CPU 优先级和 idle I/O 调度类运行，并按 bytes_per_sec 做令牌桶限速，
+    保证不会和正在写入的 flush 线程争抢磁盘。压缩先写 .zst.tmp，完成后 rename 再删除原文件，
+    中途退出只会留下可以安全删除的 .tmp。
+*/
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "ZstdSeekable.hpp"
+
+static constexpr size_t LOG_COMPRESS_BYTES_PER_SEC = 16 * 1024 * 1024; // 默认压缩读盘限速 16MB/s
+static constexpr int IOPRIO_CLASS_IDLE_VALUE = 3;
+static constexpr int IOPRIO_CLASS_SHIFT_VALUE = 13;
+static constexpr int IOPRIO_WHO_PROCESS_VALUE = 1;
+
+
+class LogCompressor {
+public:
+    explicit LogCompressor(size_t bytes_per_sec = LOG_COMPRESS_BYTES_PER_SEC)
+        : bytes_per_sec_(std::max<size_t>(bytes_per_sec, ZSTD_SEEKABLE_FRAME_SIZE)) {
+        worker_ = std::thread(&LogCompressor::run, this);
+    }
+
+    ~LogCompressor() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_ = false;
+        }
+        cv_.notify_one();
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+    }
+
+    LogCompressor(const LogCompressor&) = delete;
+    LogCompressor& operator=(const LogCompressor&) = delete;
+
+    // 提交一个已经不再写入的日志文件
+    void submit(const std::string& path) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_.push_back(path);
+        }
+        cv_.notify_one();
+    }
+
+    // 提交 root 下除 active_date 以外所有日期目录中尚未压缩的 .txt，用于进程重启后补压
+    void submit_stale(const std::string& root, const std::string& active_date) {
+        namespace fs = std::filesystem;
+        std::error_code ec;
+        for (const auto& dir : fs::directory_iterator(root, ec)) {
+            if (!dir.is_directory() || dir.path().filename() == active_date) {
+                continue;
+            }
+            for (const auto& file : fs::directory_iterator(dir.path(), ec)) {
+                if (file.is_regular_file() && file.path().extension() == ".txt") {
+                    submit(file.path().string());
+                }
+            }
+        }
+    }
+
+    uint64_t compressed_files() const {
+        return compressed_files_.load(std::memory_order_relaxed);
+    }
+
+    uint64_t saved_bytes() const {
+        return saved_bytes_.load(std::memory_order_relaxed);
+    }
+
+private:
+    static void lower_thread_priority() {
+#if defined(__linux__)
+        pid_t tid = static_cast<pid_t>(::syscall(SYS_gettid));
+        ::setpriority(PRIO_PROCESS, static_cast<id_t>(tid), 19);
+        ::syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS_VALUE, tid, IOPRIO_CLASS_IDLE_VALUE << IOPRIO_CLASS_SHIFT_VALUE);
+#endif
+    }
+
+    // 令牌桶：每读入一段前扣除对应字节数，不足时睡到够为止；停止时返回 false
+    bool throttle(size_t bytes) {
+        using namespace std::chrono;
+        auto now = steady_clock::now();
+        double elapsed = duration<double>(now - last_refill_).count();
+        last_refill_ = now;
+        tokens_ = std::min<double>(tokens_ + elapsed * static_cast<double>(bytes_per_sec_),
+                                   static_cast<double>(bytes_per_sec_));
+        if (tokens_ < static_cast<double>(bytes)) {
+            auto wait = duration<double>((static_cast<double>(bytes) - tokens_) / static_cast<double>(bytes_per_sec_));
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (cv_.wait_for(lock, duration_cast<steady_clock::duration>(wait), [this]() { return !running_; })) {
+                return false;
+            }
+            lock.unlock();
+            last_refill_ = steady_clock::now();
+            tokens_ = static_cast<double>(bytes);
+        }
+        tokens_ -= static_cast<double>(bytes);
+        return true;
+    }
+
+    void compress_one(const std::string& path) {
+        namespace fs = std::filesystem;
+        std::error_code ec;
+        if (!fs::is_regular_file(path, ec)) {
+            return;
+        }
+        uintmax_t raw_size = fs::file_size(path, ec);
+        std::string target = path + ".zst";
+        std::string tmp = target + ".tmp";
+        try {
+            if (!ZstdSeekable::compress_file(path, tmp, [this](size_t n) { return throttle(n); })) {
+                return;
+            }
+            fs::rename(tmp, target);
+            uintmax_t packed_size = fs::file_size(target, ec);
+            fs::remove(path);
+            compressed_files_.fetch_add(1, std::memory_order_relaxed);
+            if (!ec && packed_size < raw_size) {
+                saved_bytes_.fetch_add(raw_size - packed_size, std::memory_order_relaxed);
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to compress log file " << path << ": " << e.what() << std::endl;
+            fs::remove(tmp, ec);
+        }
+    }
+
+    void run() {
+        lower_thread_priority();
+        last_refill_ = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            cv_.wait(lock, [this]() { return !running_ || !pending_.empty(); });
+            if (!running_) {
+                break;  // 未压缩的文件留给下次启动时的 submit_stale
+            }
+            std::string path = std::move(pending_.front());
+            pending_.pop_front();
+            lock.unlock();
+            compress_one(path);
+            lock.lock();
+        }
+    }
+
+    const size_t bytes_per_sec_;
+    double tokens_ = 0;
+    std::chrono::steady_clock::time_point last_refill_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::string> pending_;
+    bool running_ = true;
+    std::atomic<uint64_t> compressed_files_{0};
+    std::atomic<uint64_t> saved_bytes_{0};
+    std::thread worker_;
+};
@@ -0,0 +1,279 @@
+/*
+    日志持久化等级与完成通知。
+
+    flush 线程的每一轮 (pass) 有一个递增编号，生产者入队后读取当前轮号 s，等到编号大于 s 的某一轮完成即可，
+    不需要在记录里携带任何标记。一轮开始时取一个快照：到此为止开始入队的记录条数 (生产者在入队之前计数)。
+    队列按 FIFO 出队、每个分片只有一个消费者，在快照之前已经入队完成的记录，排在它前面的记录也都在快照之前
+    开始入队，因此 flush 线程累计写出的条数达到快照时，这些记录都已写出；队列为空同样说明它们都已写出。
+    一轮可以跨越多批，持续高负载、队列始终不空时也能完成。
+
+    需要 fdatasync 的等待者只登记“最晚需要同步到哪一轮”，flush 线程每轮最多同步一次，
+    同一时间段内的多个持久化请求共享一次 fdatasync（组提交）。
+
+    某一批没能写入日志文件（写失败或没有文件 sink），或者需要的 fdatasync 失败时，记下失败的轮号，
+    written_ / synced_ 不前进。生产者在入队之前读取当前轮号 since，记录只可能在 since 及之后的轮次写出，
+    因此 since 及之后有失败的等待者都以失败结束。这是保守的判断：失败发生在记录写出之后时也报告失败，
+    但不会把没有落盘的记录报告为成功。
+*/
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+static constexpr size_t DURABILITY_APPEND_STRIPES = 16;   // 入队计数的分散槽数
+
+enum class Durability : uint8_t {
+    NONE,       // 入队即返回
+    WRITTEN,    // 所在批次已写入日志文件 (进入内核页缓存)
+    SYNCED      // 所在批次已写入并 fdatasync
+};
+
+enum class DurabilityState : uint8_t {
+    PENDING,
+    DONE,
+    FAILED      // 所在批次可能没有写入或没有同步成功
+};
+
+
+class DurabilityTracker {
+public:
+    // 生产者：每条记录入队之前调用（包括不需要持久化的记录），stripe 用来分散到不同缓存行
+    void on_append(size_t stripe) {
+        appended_[stripe % DURABILITY_APPEND_STRIPES].value.fetch_add(1, std::memory_order_seq_cst);
+    }
+
+    // 构造时队列里已有的记录（如 MmapLogQueue 恢复的记录），同样计入快照
+    void on_preloaded(size_t count) {
+        appended_[0].value.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    // 生产者：需要持久化的记录入队之前调用，返回记录可能写出的最早轮号
+    uint64_t current_pass() const {
+        return std::max<uint64_t>(1, pass_started_.load(std::memory_order_seq_cst));
+    }
+
+    // 生产者：记录入队之后调用，返回需要等待的轮号
+    uint64_t request(Durability level) {
+        uint64_t target = pass_started_.load(std::memory_order_seq_cst) + 1;
+        std::atomic<uint64_t>& wanted = level == Durability::SYNCED ? wanted_synced_ : wanted_written_;
+        uint64_t current = wanted.load(std::memory_order_relaxed);
+        while (current < target && !wanted.compare_exchange_weak(current, target, std::memory_order_seq_cst)) {
+        }
+        return target;
+    }
+
+    // 生产者：完成时在 flush 线程上回调，参数为是否成功；已经完成则立即在当前线程回调
+    void on_complete(uint64_t since, uint64_t target, Durability level, std::function<void(bool)> callback) {
+        DurabilityState result;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            result = state(since, target, level);
+            if (result == DurabilityState::PENDING) {
+                callbacks_.push_back(Callback{since, target, level, std::move(callback)});
+                has_callbacks_.store(true, std::memory_order_relaxed);
+                return;
+            }
+        }
+        callback(result == DurabilityState::DONE);
+    }
+
+    DurabilityState state(uint64_t since, uint64_t target, Durability level) const {
+        if (write_failed_.load(std::memory_order_acquire) >= since ||
+            (level == Durability::SYNCED && sync_failed_.load(std::memory_order_acquire) >= since)) {
+            return DurabilityState::FAILED;
+        }
+        const std::atomic<uint64_t>& done = level == Durability::SYNCED ? synced_ : written_;
+        return done.load(std::memory_order_acquire) >= target ? DurabilityState::DONE : DurabilityState::PENDING;
+    }
+
+    DurabilityState wait(uint64_t since, uint64_t target, Durability level) {
+        DurabilityState result = state(since, target, level);
+        if (result != DurabilityState::PENDING) {
+            return result;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        ++waiters_;
+        cv_.wait(lock, [&]() { return (result = state(since, target, level)) != DurabilityState::PENDING; });
+        --waiters_;
+        return result;
+    }
+
+    // 超时返回 PENDING
+    DurabilityState wait_for(uint64_t since, uint64_t target, Durability level, std::chrono::nanoseconds timeout) {
+        DurabilityState result = state(since, target, level);
+        if (result != DurabilityState::PENDING) {
+            return result;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        ++waiters_;
+        cv_.wait_for(lock, timeout, [&]() { return (result = state(since, target, level)) != DurabilityState::PENDING; });
+        --waiters_;
+        return result;
+    }
+
+    // flush 线程：是否有等待者尚未满足，有则不能挂起
+    bool pending() const {
+        return wanted_written_.load(std::memory_order_seq_cst) > resolved(Durability::WRITTEN) ||
+               wanted_synced_.load(std::memory_order_seq_cst) > resolved(Durability::SYNCED);
+    }
+
+    // flush 线程：开始新的一轮，返回轮号，同时记下这一轮需要写出的记录条数
+    uint64_t begin_pass() {
+        uint64_t pass = pass_started_.fetch_add(1, std::memory_order_seq_cst) + 1;
+        uint64_t goal = 0;
+        for (const auto& stripe : appended_) {
+            goal += stripe.value.load(std::memory_order_seq_cst);
+        }
+        pass_goal_ = goal;
+        return pass;
+    }
+
+    // flush 线程：一批记录已写出
+    void on_written(size_t count) {
+        records_written_ += count;
+    }
+
+    // flush 线程：当前这一轮开始之前入队的记录是否都已写出
+    bool pass_covered() const {
+        return records_written_ >= pass_goal_;
+    }
+
+    // flush 线程：这一轮结束时是否需要 fdatasync
+    bool sync_wanted() const {
+        return wanted_synced_.load(std::memory_order_seq_cst) > resolved(Durability::SYNCED);
+    }
+
+    // flush 线程：编号为 pass 的一轮中有一批没能写入日志文件 (WRITTEN)，或这一轮需要的 fdatasync 失败 (SYNCED)
+    void fail(uint64_t pass, Durability level) {
+        std::atomic<uint64_t>& failed = level == Durability::SYNCED ? sync_failed_ : write_failed_;
+        failed.store(pass, std::memory_order_release);
+    }
+
+    // flush 线程：编号为 pass 的一轮开始前入队的记录已写出 (并在 synced 为 true 时已同步)，失败的部分不前进
+    void complete(uint64_t pass, bool synced) {
+        if (write_failed_.load(std::memory_order_relaxed) != pass) {
+            written_.store(pass, std::memory_order_release);
+            if (synced && sync_failed_.load(std::memory_order_relaxed) != pass) {
+                synced_.store(pass, std::memory_order_release);
+            }
+        }
+        wake();
+    }
+
+    // 停止时队列已经清空，唤醒所有等待者
+    void complete_all() {
+        written_.store(std::numeric_limits<uint64_t>::max(), std::memory_order_release);
+        synced_.store(std::numeric_limits<uint64_t>::max(), std::memory_order_release);
+        wake();
+    }
+
+private:
+    struct Callback {
+        uint64_t since;
+        uint64_t target;
+        Durability level;
+        std::function<void(bool)> fn;
+    };
+
+    // 不大于返回值的轮号都已有结论（完成或失败），只由 flush 线程调用
+    uint64_t resolved(Durability level) const {
+        uint64_t write_failed = write_failed_.load(std::memory_order_relaxed);
+        if (level == Durability::SYNCED) {
+            return std::max({synced_.load(std::memory_order_relaxed), sync_failed_.load(std::memory_order_relaxed),
+                             write_failed});
+        }
+        return std::max(written_.load(std::memory_order_relaxed), write_failed);
+    }
+
+    void wake() {
+        std::vector<Callback> ready;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (has_callbacks_.load(std::memory_order_relaxed)) {
+                auto it = std::partition(callbacks_.begin(), callbacks_.end(), [this](const Callback& c) {
+                    return state(c.since, c.target, c.level) == DurabilityState::PENDING;
+                });
+                std::move(it, callbacks_.end(), std::back_inserter(ready));
+                callbacks_.erase(it, callbacks_.end());
+                has_callbacks_.store(!callbacks_.empty(), std::memory_order_relaxed);
+            }
+            if (waiters_ > 0) {
+                cv_.notify_all();
+            }
+        }
+        // 失败和完成都只由 flush 线程（即这里）推进，结论与上面分拣时一致
+        for (auto& c : ready) {
+            c.fn(state(c.since, c.target, c.level) == DurabilityState::DONE);
+        }
+    }
+
+    struct alignas(64) Stripe {
+        std::atomic<uint64_t> value{0};
+    };
+
+    std::array<Stripe, DURABILITY_APPEND_STRIPES> appended_;
+    alignas(64) std::atomic<uint64_t> pass_started_{0};
+    std::atomic<uint64_t> wanted_written_{0};
+    std::atomic<uint64_t> wanted_synced_{0};
+    alignas(64) std::atomic<uint64_t> written_{0};
+    std::atomic<uint64_t> synced_{0};
+    std::atomic<uint64_t> write_failed_{0};     // 最近一次写失败的轮号
+    std::atomic<uint64_t> sync_failed_{0};      // 最近一次同步失败的轮号
+    std::atomic<bool> has_callbacks_{false};
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    uint64_t pass_goal_ = 0;            // 只由 flush 线程访问
+    uint64_t records_written_ = 0;      // 只由 flush 线程访问
+    int waiters_ = 0;                   // 受 mutex_ 保护
+    std::vector<Callback> callbacks_;   // 受 mutex_ 保护
+};
+
+/*
+    append 返回的完成句柄。默认构造的句柄表示已经成功完成。
+    句柄引用 logger 内部的状态，不能比 logger 活得更久。
+*/
+class LogCompletion {
+public:
+    LogCompletion() = default;
+
+    LogCompletion(DurabilityTracker* tracker, uint64_t since, uint64_t target, Durability level)
+        : tracker_(tracker), since_(since), target_(target), level_(level) {}
+
+    DurabilityState state() const {
+        return tracker_ ? tracker_->state(since_, target_, level_) : DurabilityState::DONE;
+    }
+
+    // 已有结论（成功或失败）
+    bool ready() const {
+        return state() != DurabilityState::PENDING;
+    }
+
+    bool failed() const {
+        return state() == DurabilityState::FAILED;
+    }
+
+    // 等到有结论，返回是否成功
+    bool wait() const {
+        return !tracker_ || tracker_->wait(since_, target_, level_) == DurabilityState::DONE;
+    }
+
+    // 超时返回 false；返回 true 之后用 failed() 区分成功与失败
+    bool wait_for(std::chrono::nanoseconds timeout) const {
+        return !tracker_ || tracker_->wait_for(since_, target_, level_, timeout) != DurabilityState::PENDING;
+    }
+
+private:
+    DurabilityTracker* tracker_ = nullptr;
+    uint64_t since_ = 0;
+    uint64_t target_ = 0;
+    Durability level_ = Durability::NONE;
+};
@@ -0,0 +1,415 @@
+/*
+    紧凑的访问日志记录。
+
+    LogEntry 固定为两个 cache line (128 字节)，RPC 路径上构造一条记录不做任何堆分配：
+      - 时间戳是一次 rdtsc (TscClock)，由 flush 线程换算成墙上时间；
+      - uuid 以 16 字节二进制保存，格式化推迟到 flush 线程；
+      - 客户端/服务端地址打包成 NetAddr (IPv4/IPv6 + 端口)；
+      - params / error_message 共用一块 36 字节的内联缓冲区，放不下时溢出到
+        当前线程的 LogTextSlab 块中，由消费线程归还；
+      - 被 LogFilter 采样保留的记录带上采样率 (sample_ppm)，统计 (LogAggregator 等) 按 1 / 采样率加权。
+    记录内部没有指向自身的指针，按字节搬移 (memcpy) 后源对象直接丢弃是安全的。
+*/
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <arpa/inet.h>
+#include <grpcpp/support/status_code_enum.h>
+
+#include "tools/TscClock.hpp"
+
+static constexpr size_t LOG_TEXT_INLINE_CAPACITY = 36;      // params + error_message 内联容量
+static constexpr size_t LOG_TEXT_BLOCK_SIZE = 1024;         // 溢出块大小（含块头）
+static constexpr size_t LOG_TEXT_BLOCKS_PER_CHUNK = 64;     // slab 每次向系统申请的块数
+static constexpr uint32_t LOG_SAMPLE_SCALE = 1000000;       // 采样率精度：百万分之一
+
+
+enum class Level : uint8_t {
+    INFO,
+    WARN,
+    ERROR
+};
+
+enum class LogType : uint8_t {
+    PREPARE,
+    COMMIT,
+    ABORT,
+    EVENT       // 应用自定义事件，二进制负载放在 params 区，见 LogSchema.hpp
+};
+
+enum class OperationType : uint8_t {
+    UPLOAD,
+    DOWNLOAD,
+    DELETE
+};
+
+struct LogUuid {
+    std::array<uint8_t, 16> bytes{};
+
+    static LogUuid from_bytes(const void* data) {
+        LogUuid id;
+        std::memcpy(id.bytes.data(), data, id.bytes.size());
+        return id;
+    }
+
+    // 写出 36 个字符的 8-4-4-4-12 形式，返回写入结束位置
+    char* format_to(char* out) const {
+        static constexpr char hex[] = "0123456789abcdef";
+        for (size_t i = 0; i < bytes.size(); ++i) {
+            if (i == 4 || i == 6 || i == 8 || i == 10) {
+                *out++ = '-';
+            }
+            *out++ = hex[bytes[i] >> 4];
+            *out++ = hex[bytes[i] & 0x0f];
+        }
+        return out;
+    }
+
+    std::string to_string() const {
+        char buf[36];
+        format_to(buf);
+        return std::string(buf, sizeof(buf));
+    }
+
+    bool operator==(const LogUuid&) const = default;
+};
+
+struct NetAddr {
+    enum class Family : uint8_t {
+        NONE,
+        V4,
+        V6
+    };
+
+    std::array<uint8_t, 16> addr{};   // IPv4 只使用前 4 字节
+    uint16_t port = 0;
+    Family family = Family::NONE;
+
+    static NetAddr any(uint16_t port) {
+        NetAddr a;
+        a.family = Family::V4;
+        a.port = port;
+        return a;
+    }
+
+    // 解析点分十进制或 IPv6 文本地址，失败时保持原值并返回 false
+    bool parse_ip(std::string_view ip) {
+        char buf[INET6_ADDRSTRLEN];
+        if (ip.empty() || ip.size() >= sizeof(buf)) {
+            return false;
+        }
+        std::memcpy(buf, ip.data(), ip.size());
+        buf[ip.size()] = '\0';
+
+        std::array<uint8_t, 16> tmp{};
+        if (inet_pton(AF_INET, buf, tmp.data()) == 1) {
+            addr = tmp;
+            family = Family::V4;
+            return true;
+        }
+        if (inet_pton(AF_INET6, buf, tmp.data()) == 1) {
+            addr = tmp;
+            family = Family::V6;
+            return true;
+        }
+        return false;
+    }
+
+    std::string ip_string() const {
+        char buf[INET6_ADDRSTRLEN];
+        switch (family) {
+            case Family::V4:
+                return inet_ntop(AF_INET, addr.data(), buf, sizeof(buf)) ? buf : "0.0.0.0";
+            case Family::V6:
+                return inet_ntop(AF_INET6, addr.data(), buf, sizeof(buf)) ? buf : "::";
+            default:
+                return "0.0.0.0";
+        }
+    }
+
+    bool operator==(const NetAddr&) const = default;
+};
+
+/*
+    params / error_message 的溢出存储。
+
+    每个线程持有一个 slab，只有所属线程从中取块；任何线程都可以通过 release 把块
+    推回所属 slab 的归还栈（多生产者、单消费者的 Treiber 栈，所属线程一次性 exchange
+    取走整条链，因此不存在 ABA）。slab 以引用计数管理：所属线程本身占一个引用，
+    每个借出的块占一个引用，线程退出后由最后归还的块负责释放。
+*/
+class LogTextSlab {
+public:
+    struct Block {
+        LogTextSlab* owner;
+        Block* next;
+        char data[LOG_TEXT_BLOCK_SIZE - 2 * sizeof(void*)];
+    };
+
+    static constexpr size_t BLOCK_PAYLOAD = sizeof(Block::data);
+
+    static Block* acquire() {
+        return local().slab->pop();
+    }
+
+    static void release(Block* block) {
+        LogTextSlab* owner = block->owner;
+        Block* head = owner->returned_.load(std::memory_order_relaxed);
+        do {
+            block->next = head;
+        } while (!owner->returned_.compare_exchange_weak(
+                    head, block, std::memory_order_release, std::memory_order_relaxed));
+        owner->drop_ref();
+    }
+
+    LogTextSlab(const LogTextSlab&) = delete;
+    LogTextSlab& operator=(const LogTextSlab&) = delete;
+
+private:
+    struct LocalHandle {
+        LogTextSlab* slab;
+        LocalHandle() : slab(new LogTextSlab()) {}
+        ~LocalHandle() { slab->drop_ref(); }
+    };
+
+    static LocalHandle& local() {
+        static thread_local LocalHandle handle;
+        return handle;
+    }
+
+    LogTextSlab() = default;
+
+    ~LogTextSlab() {
+        for (void* chunk : chunks_) {
+            ::operator delete(chunk);
+        }
+    }
+
+    Block* pop() {
+        if (!free_) {
+            free_ = returned_.exchange(nullptr, std::memory_order_acquire);
+        }
+        if (!free_) {
+            grow();
+        }
+        Block* block = free_;
+        free_ = block->next;
+        refs_.fetch_add(1, std::memory_order_relaxed);
+        return block;
+    }
+
+    void grow() {
+        void* chunk = ::operator new(sizeof(Block) * LOG_TEXT_BLOCKS_PER_CHUNK);
+        chunks_.push_back(chunk);
+        Block* blocks = static_cast<Block*>(chunk);
+        for (size_t i = 0; i < LOG_TEXT_BLOCKS_PER_CHUNK; ++i) {
+            blocks[i].owner = this;
+            blocks[i].next = free_;
+            free_ = &blocks[i];
+        }
+    }
+
+    void drop_ref() {
+        if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+
+    std::atomic<Block*> returned_{nullptr};  // 其他线程归还的块
+    std::atomic<size_t> refs_{1};
+    Block* free_ = nullptr;                  // 仅所属线程访问
+    std::vector<void*> chunks_;
+};
+
+/*
+    params 与 error_message 连续存放：[params][error_message]。
+    总长度不超过 LOG_TEXT_INLINE_CAPACITY 时放在内联缓冲区，否则整体放进一个溢出块；
+    超过溢出块容量的部分会被截断（先截 error_message 再截 params）。
+*/
+class LogText {
+public:
+    LogText() noexcept = default;
+
+    LogText(const LogText& other) {
+        assign(other.params(), other.error_message());
+    }
+
+    LogText(LogText&& other) noexcept {
+        steal(other);
+    }
+
+    LogText& operator=(const LogText& other) {
+        if (this != &other) {
+            assign(other.params(), other.error_message());
+        }
+        return *this;
+    }
+
+    LogText& operator=(LogText&& other) noexcept {
+        if (this != &other) {
+            reset();
+            steal(other);
+        }
+        return *this;
+    }
+
+    ~LogText() {
+        reset();
+    }
+
+    void assign(std::string_view params, std::string_view error) {
+        size_t limit = LogTextSlab::BLOCK_PAYLOAD;
+        if (params.size() > limit) {
+            params = params.substr(0, limit);
+        }
+        if (error.size() > limit - params.size()) {
+            error = error.substr(0, limit - params.size());
+        }
+
+        // 先写入新的存储再释放旧存储，params/error 可以指向自身
+        size_t total = params.size() + error.size();
+        if (total <= LOG_TEXT_INLINE_CAPACITY) {
+            char tmp[LOG_TEXT_INLINE_CAPACITY];
+            std::copy_n(params.data(), params.size(), tmp);
+            std::copy_n(error.data(), error.size(), tmp + params.size());
+            reset();
+            std::copy_n(tmp, total, inline_);
+        } else {
+            LogTextSlab::Block* block = LogTextSlab::acquire();
+            std::copy_n(params.data(), params.size(), block->data);
+            std::copy_n(error.data(), error.size(), block->data + params.size());
+            reset();
+            overflow_ = block;
+        }
+        params_len_ = static_cast<uint16_t>(params.size());
+        error_len_ = static_cast<uint16_t>(error.size());
+    }
+
+    std::string_view params() const {
+        return {storage(), params_len_};
+    }
+
+    std::string_view error_message() const {
+        return {storage() + params_len_, error_len_};
+    }
+
+    bool overflowed() const {
+        return overflow_ != nullptr;
+    }
+
+    void reset() {
+        if (overflow_) {
+            LogTextSlab::release(overflow_);
+            overflow_ = nullptr;
+        }
+        params_len_ = 0;
+        error_len_ = 0;
+    }
+
+private:
+    const char* storage() const {
+        return overflow_ ? overflow_->data : inline_;
+    }
+
+    void steal(LogText& other) {
+        overflow_ = other.overflow_;
+        params_len_ = other.params_len_;
+        error_len_ = other.error_len_;
+        if (!overflow_) {
+            std::memcpy(inline_, other.inline_, params_len_ + error_len_);
+        }
+        other.overflow_ = nullptr;
+        other.params_len_ = 0;
+        other.error_len_ = 0;
+    }
+
+    LogTextSlab::Block* overflow_ = nullptr;
+    uint16_t params_len_ = 0;
+    uint16_t error_len_ = 0;
+    char inline_[LOG_TEXT_INLINE_CAPACITY];
+};
+
+struct alignas(64) LogEntry {
+    TscClock::time_point timestamp;     // 写出时经 TscClock::to_system 换算
+    int32_t duration_ms;                // 超出 int32 的耗时截断 (clamp_ms)
+    uint32_t sample_ppm;                // 按此采样率 (百万分之一) 被采样保留；0 表示未经采样
+    LogUuid uuid;
+    NetAddr client;
+    NetAddr server;
+    Level level;                    // INFO, WARN, ERROR
+    LogType log_type;
+    OperationType operation;        // Upload / Download / Delete
+    grpc::StatusCode status_code;
+    LogText text;                   // params: filename=abc.jpg size=2048, error_message
+
+    LogEntry()
+    : timestamp(TscClock::now()),
+      duration_ms(0),
+      sample_ppm(0),
+      level(Level::INFO),
+      log_type(LogType::PREPARE),
+      operation(OperationType::UPLOAD),
+      status_code(grpc::StatusCode::OK) {}
+
+    LogEntry(Level lvl,
+            const LogUuid& id,
+            const NetAddr& caddr,
+            const NetAddr& saddr,
+            OperationType op,
+            std::string_view param,
+            LogType ltype,
+            grpc::StatusCode code,
+            std::string_view errmsg,
+            long long dur)
+        : timestamp(TscClock::now()),
+          duration_ms(clamp_ms(dur)),
+          sample_ppm(0),
+          uuid(id),
+          client(caddr),
+          server(saddr),
+          level(lvl),
+          log_type(ltype),
+          operation(op),
+          status_code(code) {
+        text.assign(param, errmsg);
+    }
+
+    LogEntry(const LogEntry&) = default;
+    LogEntry(LogEntry&&) noexcept = default;
+    LogEntry& operator=(const LogEntry&) = default;
+    LogEntry& operator=(LogEntry&&) noexcept = default;
+
+    std::string_view params() const { return text.params(); }
+    std::string_view error_message() const { return text.error_message(); }
+
+    void set_params(std::string_view p) { text.assign(p, text.error_message()); }
+    void set_error_message(std::string_view e) { text.assign(text.params(), e); }
+
+    static int32_t clamp_ms(long long ms) {
+        return static_cast<int32_t>(std::clamp<long long>(ms, INT32_MIN, INT32_MAX));
+    }
+
+    /*
+        这条记录代表的请求数，期望值为 1 / 采样率。取整按 uuid 的第 4~7 字节随机进位
+        （采样判断只用前 4 字节，两者独立），累加后的计数是无偏估计。
+    */
+    uint64_t sample_weight() const {
+        if (sample_ppm == 0 || sample_ppm >= LOG_SAMPLE_SCALE) {
+            return 1;
+        }
+        uint32_t h = static_cast<uint32_t>(uuid.bytes[4]) | (static_cast<uint32_t>(uuid.bytes[5]) << 8) |
+                     (static_cast<uint32_t>(uuid.bytes[6]) << 16) | (static_cast<uint32_t>(uuid.bytes[7]) << 24);
+        return LOG_SAMPLE_SCALE / sample_ppm + (h % sample_ppm < LOG_SAMPLE_SCALE % sample_ppm ? 1 : 0);
+    }
+};
+
+static_assert(sizeof(LogEntry) == 128, "LogEntry should occupy exactly two cache lines");
+static_assert(std::is_nothrow_move_constructible_v<LogEntry>);
@@ -0,0 +1,184 @@
+/*
+    透明读取日志文件：普通的 <n>.txt，或 LogCompressor 产生的 <n>.txt.zst。
+
+    偏移量始终指未压缩内容中的位置。seekable 格式的 .zst 按帧随机访问，只解压用到的帧；
+    没有寻址表的普通 .zst 第一次访问时整体解压到内存。
+*/
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <zstd.h>
+
+#include "ZstdSeekable.hpp"
+
+
+class LogFileReader {
+public:
+    explicit LogFileReader(const std::string& path)
+        : path_(path), ifs_(path, std::ios::binary) {
+        if (!ifs_.is_open()) {
+            throw std::runtime_error("Failed to open log file: " + path);
+        }
+        compressed_ = path.size() > 4 && path.compare(path.size() - 4, 4, ".zst") == 0;
+        if (compressed_) {
+            if (ZstdSeekable::read_seek_table(ifs_, frames_)) {
+                size_ = frames_.empty() ? 0 : frames_.back().decompressed_offset + frames_.back().decompressed_size;
+            } else {
+                load_whole_stream();
+            }
+        } else {
+            ifs_.seekg(0, std::ios::end);
+            size_ = static_cast<uint64_t>(ifs_.tellg());
+        }
+    }
+
+    bool compressed() const {
+        return compressed_;
+    }
+
+    // 未压缩内容的总长度
+    uint64_t size() const {
+        return size_;
+    }
+
+    const std::string& path() const {
+        return path_;
+    }
+
+    // 读取未压缩内容 [offset, offset + len)，越界部分截断
+    std::string read_at(uint64_t offset, size_t len) {
+        std::string out;
+        if (offset >= size_) {
+            return out;
+        }
+        len = static_cast<size_t>(std::min<uint64_t>(len, size_ - offset));
+        out.reserve(len);
+
+        if (!compressed_) {
+            out.resize(len);
+            ifs_.clear();
+            ifs_.seekg(static_cast<std::streamoff>(offset));
+            ifs_.read(out.data(), static_cast<std::streamsize>(len));
+            out.resize(static_cast<size_t>(ifs_.gcount()));
+            return out;
+        }
+
+        if (frames_.empty()) {
+            out.assign(whole_, static_cast<size_t>(offset), len);
+            return out;
+        }
+
+        while (out.size() < len) {
+            uint64_t pos = offset + out.size();
+            const std::string& frame = frame_containing(pos);
+            uint64_t in_frame = pos - frames_[cached_frame_].decompressed_offset;
+            size_t take = std::min<size_t>(len - out.size(), frame.size() - static_cast<size_t>(in_frame));
+            if (take == 0) {
+                break;
+            }
+            out.append(frame, static_cast<size_t>(in_frame), take);
+        }
+        return out;
+    }
+
+    // 定位到未压缩偏移 offset，之后 next_line 从这里开始
+    void seek(uint64_t offset) {
+        position_ = std::min(offset, size_);
+        line_buffer_.clear();
+        line_buffer_offset_ = position_;
+    }
+
+    uint64_t tell() const {
+        return position_;
+    }
+
+    // 顺序读取下一行（不含 '\n'），读到末尾返回 false
+    bool next_line(std::string& line) {
+        while (true) {
+            size_t start = static_cast<size_t>(position_ - line_buffer_offset_);
+            size_t nl = line_buffer_.find('\n', start);
+            if (nl != std::string::npos) {
+                line.assign(line_buffer_, start, nl - start);
+                position_ = line_buffer_offset_ + nl + 1;
+                return true;
+            }
+            uint64_t next = line_buffer_offset_ + line_buffer_.size();
+            if (next >= size_) {
+                if (start < line_buffer_.size()) {
+                    line.assign(line_buffer_, start, std::string::npos);
+                    position_ = size_;
+                    return true;
+                }
+                return false;
+            }
+            // 丢弃已消费的部分，再补一块
+            line_buffer_.erase(0, start);
+            line_buffer_offset_ = position_;
+            line_buffer_ += read_at(next, READ_CHUNK);
+        }
+    }
+
+private:
+    static constexpr size_t READ_CHUNK = 256 * 1024;
+
+    const std::string& frame_containing(uint64_t offset) {
+        auto it = std::upper_bound(frames_.begin(), frames_.end(), offset,
+            [](uint64_t off, const SeekableFrame& f) { return off < f.decompressed_offset; });
+        size_t index = static_cast<size_t>(std::distance(frames_.begin(), it)) - 1;
+        if (index == cached_frame_) {
+            return frame_cache_;
+        }
+
+        const SeekableFrame& f = frames_[index];
+        std::string packed(f.compressed_size, '\0');
+        ifs_.clear();
+        ifs_.seekg(static_cast<std::streamoff>(f.compressed_offset));
+        ifs_.read(packed.data(), static_cast<std::streamsize>(packed.size()));
+        frame_cache_.assign(f.decompressed_size, '\0');
+        size_t n = ZSTD_decompress(frame_cache_.data(), frame_cache_.size(), packed.data(), packed.size());
+        if (ZSTD_isError(n)) {
+            throw std::runtime_error("Corrupted zstd frame in " + path_ + ": " + ZSTD_getErrorName(n));
+        }
+        frame_cache_.resize(n);
+        cached_frame_ = index;
+        return frame_cache_;
+    }
+
+    void load_whole_stream() {
+        ifs_.clear();
+        ifs_.seekg(0);
+        std::string packed((std::istreambuf_iterator<char>(ifs_)), std::istreambuf_iterator<char>());
+
+        ZSTD_DStream* ds = ZSTD_createDStream();
+        std::vector<char> out(ZSTD_DStreamOutSize());
+        ZSTD_inBuffer in{packed.data(), packed.size(), 0};
+        while (in.pos < in.size) {
+            ZSTD_outBuffer ob{out.data(), out.size(), 0};
+            size_t r = ZSTD_decompressStream(ds, &ob, &in);
+            if (ZSTD_isError(r)) {
+                ZSTD_freeDStream(ds);
+                throw std::runtime_error("Corrupted zstd stream in " + path_ + ": " + ZSTD_getErrorName(r));
+            }
+            whole_.append(out.data(), ob.pos);
+        }
+        ZSTD_freeDStream(ds);
+        size_ = whole_.size();
+    }
+
+    std::string path_;
+    std::ifstream ifs_;
+    bool compressed_ = false;
+    uint64_t size_ = 0;
+    std::vector<SeekableFrame> frames_;
+    size_t cached_frame_ = SIZE_MAX;
+    std::string frame_cache_;
+    std::string whole_;
+    uint64_t position_ = 0;
+    std::string line_buffer_;
+    uint64_t line_buffer_offset_ = 0;
+};
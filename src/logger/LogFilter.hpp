@@ -0,0 +1,261 @@
+/*
+    访问日志的运行时过滤与采样。
+
+    AccessLogger 在构造 LogEntry 之前询问 LogFilter，被过滤的调用只做几次原子读取，没有任何分配。
+    所有配置都是原子变量，可以在运行中通过管理接口 (AdminService) 修改：
+        level=INFO|WARN|ERROR        低于该级别的记录丢弃（失败的 COMMIT/ABORT 为 ERROR）
+        <op>.enabled=0|1             关闭某类操作的全部访问日志
+        <op>.sample=0.0~1.0          成功且不慢的请求按比例采样
+        <op>.slow_ms=N               耗时不少于 N 毫秒的请求视为慢请求，总是保留
+        <op>.tail=0|1                尾部采样：不在开始时写 PREPARE，只有失败或慢的请求在结束时补写
+    <op> 为 upload / download / delete，或 all 表示全部操作。
+    采样按 uuid 决定，同一请求的 PREPARE 与 COMMIT 要么都保留要么都丢弃；失败和慢请求不参与采样。
+    因采样保留的 COMMIT 带上当时的采样率，进程内统计据此把它计为 1 / 采样率 个请求。
+    需要持久化的 COMMIT/ABORT（如删除的审计记录）不经过 keep_commit，总是写出。
+*/
+#pragma once
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <grpcpp/support/status_code_enum.h>
+
+#include "LogEntry.hpp"
+
+static constexpr int64_t LOG_FILTER_DEFAULT_SLOW_MS = 1000;
+
+
+class LogFilter {
+public:
+    static LogFilter& instance() {
+        static LogFilter filter;
+        return filter;
+    }
+
+    bool keep_prepare(OperationType op, const LogUuid& uuid) const {
+        const Policy& p = policy(op);
+        if (!level_enabled(Level::INFO) || !p.enabled.load(std::memory_order_relaxed) ||
+            p.tail.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        return sampled(p.sample_ppm.load(std::memory_order_relaxed), uuid);
+    }
+
+    /*
+        是否写出 COMMIT/ABORT。with_prepare 为 true 时调用方需要补写一条被尾部采样推迟的 PREPARE；
+        sample_ppm 为因采样而保留时的采样率，没有经过采样（全部保留、失败或慢请求）时为 0。
+    */
+    bool keep_commit(OperationType op,
+                     const LogUuid& uuid,
+                     grpc::StatusCode code,
+                     long long duration_ms,
+                     bool& with_prepare,
+                     uint32_t& sample_ppm) const {
+        with_prepare = false;
+        sample_ppm = 0;
+        const Policy& p = policy(op);
+        Level level = code == grpc::StatusCode::OK ? Level::INFO : Level::ERROR;
+        if (!level_enabled(level) || !p.enabled.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        if (code != grpc::StatusCode::OK || duration_ms >= p.slow_ms.load(std::memory_order_relaxed)) {
+            with_prepare = p.tail.load(std::memory_order_relaxed);
+            return true;
+        }
+        uint32_t rate = p.sample_ppm.load(std::memory_order_relaxed);
+        if (rate < LOG_SAMPLE_SCALE) {
+            sample_ppm = rate;
+        }
+        return sampled(rate, uuid);
+    }
+
+    // 开始时的 PREPARE 是否没有写出（被过滤、采样或被尾部采样推迟），与 keep_prepare 的判断一致
+    bool prepare_skipped(OperationType op, const LogUuid& uuid) const {
+        return !keep_prepare(op, uuid);
+    }
+
+    /*
+        应用以空白或逗号分隔的 key=value 列表，全部合法才生效。出错时返回 false 并写入 error。
+    */
+    bool apply(std::string_view spec, std::string& error) {
+        struct Change {
+            std::string_view key;
+            std::string_view value;
+        };
+        std::vector<Change> changes;
+        size_t pos = 0;
+        while (pos < spec.size()) {
+            size_t end = spec.find_first_of(" \t\r\n,", pos);
+            if (end == std::string_view::npos) {
+                end = spec.size();
+            }
+            std::string_view item = spec.substr(pos, end - pos);
+            pos = end + 1;
+            if (item.empty()) {
+                continue;
+            }
+            size_t eq = item.find('=');
+            if (eq == std::string_view::npos) {
+                error = "expected key=value: " + std::string(item);
+                return false;
+            }
+            Change c{item.substr(0, eq), item.substr(eq + 1)};
+            if (!apply_one(c.key, c.value, true, error)) {
+                return false;
+            }
+            changes.push_back(c);
+        }
+        for (const auto& c : changes) {
+            apply_one(c.key, c.value, false, error);
+        }
+        return true;
+    }
+
+    std::string describe() const {
+        std::ostringstream oss;
+        oss << "level=" << level_name(static_cast<Level>(min_level_.load(std::memory_order_relaxed))) << "\n";
+        for (size_t i = 0; i < policies_.size(); ++i) {
+            const Policy& p = policies_[i];
+            std::string_view op = OPERATION_NAMES[i];
+            oss << op << ".enabled=" << (p.enabled.load(std::memory_order_relaxed) ? 1 : 0) << "\n";
+            oss << op << ".sample=" << static_cast<double>(p.sample_ppm.load(std::memory_order_relaxed)) / LOG_SAMPLE_SCALE << "\n";
+            oss << op << ".slow_ms=" << p.slow_ms.load(std::memory_order_relaxed) << "\n";
+            oss << op << ".tail=" << (p.tail.load(std::memory_order_relaxed) ? 1 : 0) << "\n";
+        }
+        return oss.str();
+    }
+
+private:
+    struct Policy {
+        std::atomic<bool> enabled{true};
+        std::atomic<uint32_t> sample_ppm{LOG_SAMPLE_SCALE};
+        std::atomic<int64_t> slow_ms{LOG_FILTER_DEFAULT_SLOW_MS};
+        std::atomic<bool> tail{false};
+    };
+
+    static constexpr std::array<std::string_view, 3> OPERATION_NAMES = {"upload", "download", "delete"};
+
+    LogFilter() = default;
+
+    const Policy& policy(OperationType op) const {
+        return policies_[static_cast<size_t>(op) % policies_.size()];
+    }
+
+    bool level_enabled(Level level) const {
+        return static_cast<uint8_t>(level) >= min_level_.load(std::memory_order_relaxed);
+    }
+
+    // uuid 是随机生成的，取前 4 字节即可均匀分布
+    static bool sampled(uint32_t rate, const LogUuid& uuid) {
+        if (rate >= LOG_SAMPLE_SCALE) {
+            return true;
+        }
+        uint32_t h = static_cast<uint32_t>(uuid.bytes[0]) | (static_cast<uint32_t>(uuid.bytes[1]) << 8) |
+                     (static_cast<uint32_t>(uuid.bytes[2]) << 16) | (static_cast<uint32_t>(uuid.bytes[3]) << 24);
+        return h % LOG_SAMPLE_SCALE < rate;
+    }
+
+    static std::string_view level_name(Level level) {
+        switch (level) {
+            case Level::INFO: return "INFO";
+            case Level::WARN: return "WARN";
+            case Level::ERROR: return "ERROR";
+            default: return "UNKNOWN";
+        }
+    }
+
+    static bool parse_flag(std::string_view v, bool& out) {
+        if (v == "1" || v == "true" || v == "on") {
+            out = true;
+            return true;
+        }
+        if (v == "0" || v == "false" || v == "off") {
+            out = false;
+            return true;
+        }
+        return false;
+    }
+
+    // dry_run 为 true 时只校验
+    bool apply_one(std::string_view key, std::string_view value, bool dry_run, std::string& error) {
+        if (key == "level") {
+            for (Level l : {Level::INFO, Level::WARN, Level::ERROR}) {
+                if (value == level_name(l)) {
+                    if (!dry_run) {
+                        min_level_.store(static_cast<uint8_t>(l), std::memory_order_relaxed);
+                    }
+                    return true;
+                }
+            }
+            error = "unknown level: " + std::string(value);
+            return false;
+        }
+
+        size_t dot = key.find('.');
+        if (dot == std::string_view::npos) {
+            error = "unknown key: " + std::string(key);
+            return false;
+        }
+        std::string_view op = key.substr(0, dot);
+        std::string_view field = key.substr(dot + 1);
+        size_t first = 0;
+        size_t last = policies_.size();
+        if (op != "all") {
+            while (first < OPERATION_NAMES.size() && OPERATION_NAMES[first] != op) {
+                ++first;
+            }
+            if (first == OPERATION_NAMES.size()) {
+                error = "unknown operation: " + std::string(op);
+                return false;
+            }
+            last = first + 1;
+        }
+
+        bool flag = false;
+        if (field == "enabled" || field == "tail") {
+            if (!parse_flag(value, flag)) {
+                error = "expected 0/1 for " + std::string(key);
+                return false;
+            }
+            for (size_t i = first; i < last && !dry_run; ++i) {
+                (field == "enabled" ? policies_[i].enabled : policies_[i].tail).store(flag, std::memory_order_relaxed);
+            }
+            return true;
+        }
+        if (field == "sample") {
+            std::string text(value);
+            char* end = nullptr;
+            double rate = std::strtod(text.c_str(), &end);
+            if (text.empty() || *end != '\0' || !(rate >= 0.0 && rate <= 1.0)) {
+                error = "sample must be within [0, 1]: " + text;
+                return false;
+            }
+            for (size_t i = first; i < last && !dry_run; ++i) {
+                policies_[i].sample_ppm.store(static_cast<uint32_t>(rate * LOG_SAMPLE_SCALE + 0.5), std::memory_order_relaxed);
+            }
+            return true;
+        }
+        if (field == "slow_ms") {
+            int64_t ms = 0;
+            auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), ms);
+            if (ec != std::errc() || ptr != value.data() + value.size() || ms < 0) {
+                error = "slow_ms must be a non-negative integer: " + std::string(value);
+                return false;
+            }
+            for (size_t i = first; i < last && !dry_run; ++i) {
+                policies_[i].slow_ms.store(ms, std::memory_order_relaxed);
+            }
+            return true;
+        }
+        error = "unknown key: " + std::string(key);
+        return false;
+    }
+
+    std::atomic<uint8_t> min_level_{static_cast<uint8_t>(Level::INFO)};
+    std::array<Policy, 3> policies_;
+};
@@ -0,0 +1,30 @@
+/*
+    LogEntry 的文本格式。flush 线程与离线工具 (cclog_recover) 共用，保证输出完全一致：
+    [2025-01-01_12:00:00.000000] [uuid] [INFO] [COMMIT] [UPLOAD] client=ip:port server=ip:port params=filename=a.jpg size=2048 result=OK code=0 time=3ms
+    每种记录的具体布局由 LogSchema.hpp 中的编译期 schema 决定。
+*/
+#pragma once
+#include <string>
+#include <vector>
+
+#include "LogEntry.hpp"
+#include "LogSchema.hpp"
+
+static constexpr size_t LOG_FORMAT_RESERVE_PER_ENTRY = 192;     // 预留的单条记录长度，避免批量格式化时反复扩容
+
+
+class LogFormatter {
+public:
+    static std::string format(const std::vector<LogEntry>& entries) {  //支持到微秒
+        std::string out;
+        out.reserve(entries.size() * LOG_FORMAT_RESERVE_PER_ENTRY);
+        for (const auto& entry : entries) {
+            append(out, entry);
+        }
+        return out;
+    }
+
+    static void append(std::string& out, const LogEntry& entry) {
+        LogSchemaTable::format(out, entry);
+    }
+};
@@ -0,0 +1,344 @@
+/*
+    访问流中的热点：最近一段时间内请求最多的文件名和客户端 IP。
+
+    每个维度用 Space-Saving 算法维护固定数量的计数器：命中则加一，未命中时顶替当前最小的计数器，
+    新键继承被顶替者的计数作为误差上界。真实次数在 [count - error, count] 之间，
+    出现次数超过 N / capacity 的键一定在表中。计数器按最小堆组织，每条记录 O(log capacity)。
+
+    滑动窗口由 LOG_HOT_WINDOWS 个 LOG_HOT_WINDOW_SEC 秒的子窗口组成，查询时合并最近的若干个；
+    某个子窗口中没有出现的键按该子窗口的最小计数补上误差，合并后的上下界仍然成立。
+
+    作为 LogObserver 在 flush 线程上消费 COMMIT / ABORT 记录，文件名取自 params 中的 filename=；
+    被采样保留的记录按 LogEntry::sample_weight 加权，采样不会让计数偏向失败或慢请求多的键。
+    可通过 /CCcloud.Admin/GetHotKeys 查询，也可在进程内调用 top / estimate 用于缓存预热和按客户端限流。
+*/
+#pragma once
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "LogEntry.hpp"
+#include "LogQuery.hpp"
+#include "LogSink.hpp"
+
+static constexpr size_t LOG_HOT_CAPACITY = 128;         // 每个子窗口、每个维度的计数器数
+static constexpr int64_t LOG_HOT_WINDOW_SEC = 10;
+static constexpr size_t LOG_HOT_WINDOWS = 30;           // 最长可查询 5 分钟
+static constexpr size_t LOG_HOT_MAX_KEY = 128;          // 过长的文件名截断，保证内存有界
+
+
+struct HotItem {
+    std::string key;
+    uint64_t count = 0;     // 估计值（上界）
+    uint64_t error = 0;     // 真实次数不少于 count - error
+};
+
+
+class SpaceSaving {
+public:
+    explicit SpaceSaving(size_t capacity = LOG_HOT_CAPACITY) : capacity_(capacity) {
+        heap_.reserve(capacity_);
+        index_.reserve(capacity_ * 2);
+    }
+
+    void add(std::string_view key, uint64_t weight = 1) {
+        if (key.size() > LOG_HOT_MAX_KEY) {
+            key = key.substr(0, LOG_HOT_MAX_KEY);
+        }
+        total_ += weight;
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            heap_[it->second].count += weight;
+            sift_down(it->second);
+            return;
+        }
+        if (heap_.size() < capacity_) {
+            heap_.push_back(HotItem{std::string(key), weight, 0});
+            index_[heap_.back().key] = heap_.size() - 1;
+            sift_up(heap_.size() - 1);
+            return;
+        }
+        // 顶替最小的计数器
+        HotItem& min = heap_[0];
+        index_.erase(min.key);
+        min.error = min.count;
+        min.count += weight;
+        min.key.assign(key);
+        index_[min.key] = 0;
+        sift_down(0);
+    }
+
+    // 表中的计数；不在表中返回 nullptr
+    const HotItem* find(std::string_view key) const {
+        auto it = index_.find(key);
+        return it == index_.end() ? nullptr : &heap_[it->second];
+    }
+
+    // 表满时，不在表中的键的次数上界
+    uint64_t floor() const {
+        return heap_.size() < capacity_ || heap_.empty() ? 0 : heap_[0].count;
+    }
+
+    const std::vector<HotItem>& items() const {
+        return heap_;
+    }
+
+    uint64_t total() const {
+        return total_;
+    }
+
+    void clear() {
+        heap_.clear();
+        index_.clear();
+        total_ = 0;
+    }
+
+private:
+    void swap_nodes(size_t a, size_t b) {
+        std::swap(heap_[a], heap_[b]);
+        index_[heap_[a].key] = a;
+        index_[heap_[b].key] = b;
+    }
+
+    void sift_up(size_t i) {
+        while (i > 0) {
+            size_t parent = (i - 1) / 2;
+            if (heap_[parent].count <= heap_[i].count) {
+                break;
+            }
+            swap_nodes(i, parent);
+            i = parent;
+        }
+    }
+
+    void sift_down(size_t i) {
+        while (true) {
+            size_t smallest = i;
+            size_t l = 2 * i + 1;
+            size_t r = l + 1;
+            if (l < heap_.size() && heap_[l].count < heap_[smallest].count) {
+                smallest = l;
+            }
+            if (r < heap_.size() && heap_[r].count < heap_[smallest].count) {
+                smallest = r;
+            }
+            if (smallest == i) {
+                return;
+            }
+            swap_nodes(i, smallest);
+            i = smallest;
+        }
+    }
+
+    // 允许用 string_view 查找，命中时不分配
+    struct KeyHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view key) const {
+            return std::hash<std::string_view>{}(key);
+        }
+    };
+
+    size_t capacity_;
+    std::vector<HotItem> heap_;                         // 按 count 的最小堆
+    std::unordered_map<std::string, size_t, KeyHash, std::equal_to<>> index_;  // 键 -> 堆中位置
+    uint64_t total_ = 0;
+};
+
+
+class LogHeavyHitters : public LogObserver {
+public:
+    enum class Dimension : uint8_t {
+        FILE,
+        CLIENT
+    };
+
+    LogHeavyHitters() {
+        LogQueryRegistry<LogHeavyHitters>::add(this);
+    }
+
+    ~LogHeavyHitters() override {
+        LogQueryRegistry<LogHeavyHitters>::remove(this);
+    }
+
+    void observe(const std::vector<LogEntry>& batch) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& e : batch) {
+            if (e.log_type != LogType::COMMIT && e.log_type != LogType::ABORT) {
+                continue;
+            }
+            int64_t id = std::chrono::duration_cast<std::chrono::seconds>(TscClock::to_system(e.timestamp).time_since_epoch()).count() /
+                         LOG_HOT_WINDOW_SEC;
+            Window* w = window_for(id);
+            if (!w) {
+                continue;
+            }
+            uint64_t weight = e.sample_weight();
+            std::string_view file = filename_of(e.params());
+            if (!file.empty()) {
+                w->files.add(file, weight);
+            }
+            if (e.client.family != NetAddr::Family::NONE) {
+                w->clients.add(e.client.ip_string(), weight);
+            }
+        }
+    }
+
+    // 最近 window_sec 秒内最热的 k 个键，按 count 降序
+    std::vector<HotItem> top(Dimension dim, size_t k, int64_t window_sec = 60) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<const SpaceSaving*> parts = recent(dim, window_sec);
+        std::unordered_map<std::string, HotItem> merged;
+        for (const SpaceSaving* s : parts) {
+            for (const auto& item : s->items()) {
+                HotItem& m = merged[item.key];
+                m.key = item.key;
+                m.count += item.count;
+                m.error += item.error;
+            }
+        }
+        // 某个子窗口中没有出现的键，在该子窗口的次数不超过其最小计数
+        for (auto& [key, m] : merged) {
+            for (const SpaceSaving* s : parts) {
+                uint64_t floor = s->floor();
+                if (floor > 0 && !s->find(key)) {
+                    m.count += floor;
+                    m.error += floor;
+                }
+            }
+        }
+        std::vector<HotItem> out;
+        out.reserve(merged.size());
+        for (auto& [key, m] : merged) {
+            out.push_back(std::move(m));
+        }
+        std::sort(out.begin(), out.end(), [](const HotItem& a, const HotItem& b) {
+            return a.count != b.count ? a.count > b.count : a.key < b.key;
+        });
+        if (out.size() > k) {
+            out.resize(k);
+        }
+        return out;
+    }
+
+    // key 在最近 window_sec 秒内的次数上界，可作为限流依据
+    uint64_t estimate(Dimension dim, std::string_view key, int64_t window_sec = 60) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t total = 0;
+        for (const SpaceSaving* s : recent(dim, window_sec)) {
+            const HotItem* item = s->find(key);
+            total += item ? item->count : s->floor();
+        }
+        return total;
+    }
+
+    /*
+        文本查询，spec 为以空白分隔的 key=value：
+            by=file|client      维度（默认 file）
+            k=N                 返回的个数（默认 10）
+            window=N            最近 N 秒（默认 60，最多 LOG_HOT_WINDOWS * LOG_HOT_WINDOW_SEC）
+    */
+    bool query(std::string_view spec, std::string& out, std::string& error) const {
+        Dimension dim = Dimension::FILE;
+        size_t k = 10;
+        int64_t window = 60;
+        bool parsed = parse_query(spec, [&](std::string_view key, std::string_view value) {
+            std::string item = value.empty() ? std::string(key) : std::string(key) + "=" + std::string(value);
+            try {
+                if (key == "by" && (value == "file" || value == "client")) {
+                    dim = value == "file" ? Dimension::FILE : Dimension::CLIENT;
+                } else if (key == "k") {
+                    k = std::stoul(std::string(value));
+                } else if (key == "window") {
+                    window = std::stoll(std::string(value));
+                } else {
+                    error = "unknown or invalid key: " + item;
+                    return false;
+                }
+            } catch (const std::exception&) {
+                error = "invalid number: " + item;
+                return false;
+            }
+            return true;
+        });
+        if (!parsed) {
+            return false;
+        }
+        int64_t max_window = static_cast<int64_t>(LOG_HOT_WINDOWS) * LOG_HOT_WINDOW_SEC;
+        if (k == 0 || window <= 0 || window > max_window) {
+            error = "k must be positive and window within [1, " + std::to_string(max_window) + "]";
+            return false;
+        }
+        std::ostringstream oss;
+        for (const auto& item : top(dim, k, window)) {
+            oss << (dim == Dimension::FILE ? "file=" : "client=") << item.key << " count=" << item.count
+                << " error<=" << item.error << "\n";
+        }
+        out = oss.str();
+        return true;
+    }
+
+    static bool query_all(std::string_view spec, std::string& out, std::string& error) {
+        return LogQueryRegistry<LogHeavyHitters>::query_all(spec, out, error);
+    }
+
+    // params 中 filename= 的值（到下一个空格为止）
+    static std::string_view filename_of(std::string_view params) {
+        constexpr std::string_view tag = "filename=";
+        size_t pos = params.find(tag);
+        while (pos != std::string_view::npos && pos > 0 && params[pos - 1] != ' ') {
+            pos = params.find(tag, pos + 1);
+        }
+        if (pos == std::string_view::npos) {
+            return {};
+        }
+        std::string_view value = params.substr(pos + tag.size());
+        return value.substr(0, value.find(' '));
+    }
+
+private:
+    struct Window {
+        int64_t id = -1;        // unix 秒 / LOG_HOT_WINDOW_SEC
+        SpaceSaving files;
+        SpaceSaving clients;
+    };
+
+    Window* window_for(int64_t id) {
+        newest_ = std::max(newest_, id);
+        if (id <= newest_ - static_cast<int64_t>(LOG_HOT_WINDOWS)) {
+            return nullptr;     // 太旧
+        }
+        Window& w = windows_[static_cast<size_t>(id) % LOG_HOT_WINDOWS];
+        if (w.id != id) {
+            w.id = id;
+            w.files.clear();
+            w.clients.clear();
+        }
+        return &w;
+    }
+
+    std::vector<const SpaceSaving*> recent(Dimension dim, int64_t window_sec) const {
+        int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count() / LOG_HOT_WINDOW_SEC;
+        int64_t count = (window_sec + LOG_HOT_WINDOW_SEC - 1) / LOG_HOT_WINDOW_SEC;
+        std::vector<const SpaceSaving*> parts;
+        for (const auto& w : windows_) {
+            if (w.id > now - count && w.id <= now) {
+                parts.push_back(dim == Dimension::FILE ? &w.files : &w.clients);
+            }
+        }
+        return parts;
+    }
+
+    mutable std::mutex mutex_;
+    std::array<Window, LOG_HOT_WINDOWS> windows_;
+    int64_t newest_ = 0;
+};
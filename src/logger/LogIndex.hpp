@@ -0,0 +1,395 @@
+/*
+    日志文件的稀疏索引：<n>.txt 旁边的 <n>.txt.idx，由 flush 线程在写文件的同时维护，cclog_query 使用。
+
+    索引包含两部分：
+      - 时间桶：按写入顺序切分的字节区间，记录区间内最早 / 最晚的秒、行数和 ERROR 行数。
+        时间跨过一秒或区间超过 LOG_INDEX_BUCKET_BYTES 时开始新桶。生产者之间的时间戳可能略有乱序，
+        所以查询按 [min_second, max_second] 与目标区间是否相交来选桶。
+      - 整个文件的 uuid 布隆过滤器，判断“某个请求是否可能在这个文件中”。
+    covered_bytes 之后的内容尚未进入索引（还没保存，或崩溃前没来得及保存），查询时顺序扫描这一段。
+
+    偏移量指未压缩内容，文件被 LogCompressor 压缩成 <n>.txt.zst 后索引依然有效。
+    时间用日志行中的本地时间直接换算成秒，不做时区转换，只用于比较。
+*/
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static constexpr char LOG_INDEX_MAGIC[8] = {'C', 'C', 'L', 'O', 'G', 'I', 'D', 'X'};
+static constexpr uint32_t LOG_INDEX_VERSION = 1;
+static constexpr uint64_t LOG_INDEX_BLOOM_BITS = uint64_t{1} << 20;     // 128KB，约 10 万个 uuid 时误判率 ~1%
+static constexpr uint32_t LOG_INDEX_BLOOM_HASHES = 7;
+static constexpr uint64_t LOG_INDEX_BUCKET_BYTES = 64 * 1024;
+static constexpr auto LOG_INDEX_SAVE_INTERVAL = std::chrono::seconds(5);
+static constexpr size_t LOG_LINE_TIME_LEN = 19;     // YYYY-MM-DD_HH:MM:SS
+static constexpr size_t LOG_LINE_UUID_POS = 30;     // "[<26 字节时间>] [" 之后
+static constexpr size_t LOG_LINE_UUID_LEN = 36;
+
+
+struct LogIndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t bloom_hashes;
+    uint64_t bloom_bits;
+    uint64_t covered_bytes;     // [0, covered_bytes) 已建立索引
+    uint64_t bucket_count;
+};
+
+struct LogIndexBucket {
+    int64_t min_second;
+    int64_t max_second;
+    uint64_t offset;
+    uint64_t length;
+    uint32_t lines;
+    uint32_t errors;
+};
+
+
+// 日志行的解析，写入端和查询端共用
+struct LogLine {
+    // <n>.txt 或 <n>.txt.zst 对应的索引文件
+    static std::string index_path(const std::string& log_path) {
+        std::string base = log_path;
+        if (base.size() > 4 && base.compare(base.size() - 4, 4, ".zst") == 0) {
+            base.resize(base.size() - 4);
+        }
+        return base + ".idx";
+    }
+
+    // "YYYY-MM-DD_HH:MM:SS"（日期与时间之间也可以是空格）换算为秒；只有日期时取当天 0 点。格式不对返回 false
+    static bool parse_time(std::string_view text, int64_t& second) {
+        auto num = [&](size_t pos, size_t len, int& out) {
+            out = 0;
+            for (size_t i = pos; i < pos + len; ++i) {
+                if (text[i] < '0' || text[i] > '9') {
+                    return false;
+                }
+                out = out * 10 + (text[i] - '0');
+            }
+            return true;
+        };
+        int y, mo, d, h = 0, mi = 0, s = 0;
+        if (text.size() < 10 || text[4] != '-' || text[7] != '-' ||
+            !num(0, 4, y) || !num(5, 2, mo) || !num(8, 2, d)) {
+            return false;
+        }
+        if (text.size() >= LOG_LINE_TIME_LEN) {
+            if ((text[10] != '_' && text[10] != ' ') || text[13] != ':' || text[16] != ':' ||
+                !num(11, 2, h) || !num(14, 2, mi) || !num(17, 2, s)) {
+                return false;
+            }
+        } else if (text.size() != 10) {
+            return false;
+        }
+        // days_from_civil (Howard Hinnant)
+        y -= mo <= 2;
+        int era = (y >= 0 ? y : y - 399) / 400;
+        unsigned yoe = static_cast<unsigned>(y - era * 400);
+        unsigned doy = (153 * static_cast<unsigned>(mo + (mo > 2 ? -3 : 9)) + 2) / 5 + static_cast<unsigned>(d) - 1;
+        unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        int64_t days = static_cast<int64_t>(era) * 146097 + static_cast<int64_t>(doe) - 719468;
+        second = days * 86400 + h * 3600 + mi * 60 + s;
+        return true;
+    }
+
+    static bool time_of(std::string_view line, int64_t& second) {
+        return line.size() > LOG_LINE_TIME_LEN && line[0] == '[' && parse_time(line.substr(1, LOG_LINE_TIME_LEN), second);
+    }
+
+    static std::string_view uuid_of(std::string_view line) {
+        if (line.size() < LOG_LINE_UUID_POS + LOG_LINE_UUID_LEN + 1 || line[LOG_LINE_UUID_POS - 1] != '[' ||
+            line[LOG_LINE_UUID_POS + LOG_LINE_UUID_LEN] != ']') {
+            return {};
+        }
+        return line.substr(LOG_LINE_UUID_POS, LOG_LINE_UUID_LEN);
+    }
+
+    static bool is_error(std::string_view line) {
+        constexpr std::string_view tag = "] [ERROR]";
+        return line.size() >= LOG_LINE_UUID_POS + LOG_LINE_UUID_LEN + tag.size() &&
+               line.substr(LOG_LINE_UUID_POS + LOG_LINE_UUID_LEN, tag.size()) == tag;
+    }
+
+    // 布隆过滤器的第 i 个位置 (双重哈希)
+    static uint64_t bloom_hash(std::string_view uuid, uint64_t& step) {
+        uint64_t h = 1469598103934665603ULL;   // FNV-1a
+        for (char c : uuid) {
+            h = (h ^ static_cast<uint8_t>(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c)) * 1099511628211ULL;
+        }
+        uint64_t z = h + 0x9e3779b97f4a7c15ULL;     // splitmix64 作为第二个哈希
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        step = (z ^ (z >> 31)) | 1;
+        return h;
+    }
+};
+
+
+/*
+    写入端：由 FileSink 持有，只在所属 flush 线程上调用。
+*/
+class LogIndexBuilder {
+public:
+    // 开始为 log_path 建索引。文件已有 size 字节时先载入旧索引，再补扫索引之后的部分
+    void open(const std::string& log_path, uint64_t size) {
+        path_ = LogLine::index_path(log_path);
+        buckets_.clear();
+        bloom_.assign(LOG_INDEX_BLOOM_BITS / 64, 0);
+        covered_ = 0;
+        current_ = LogIndexBucket{};
+        dirty_ = false;
+        if (size == 0) {
+            return;
+        }
+        load(size);
+        if (covered_ < size) {
+            catch_up(log_path, size);
+            save();
+        }
+    }
+
+    // batch 由完整的行组成，写在文件偏移 offset 处
+    void add(std::string_view batch, uint64_t offset) {
+        if (path_.empty()) {
+            return;
+        }
+        add_lines(batch, offset);
+        dirty_ = true;
+        if (std::chrono::steady_clock::now() - last_save_ >= LOG_INDEX_SAVE_INTERVAL) {
+            save();
+        }
+    }
+
+    // 写 <n>.txt.idx.tmp 后 rename，读者总能看到完整的索引
+    void save() {
+        if (path_.empty() || !dirty_) {
+            return;
+        }
+        last_save_ = std::chrono::steady_clock::now();
+        dirty_ = false;
+        std::vector<LogIndexBucket> buckets = buckets_;
+        if (current_.lines > 0) {
+            buckets.push_back(current_);
+        }
+        LogIndexHeader header{};
+        std::memcpy(header.magic, LOG_INDEX_MAGIC, sizeof(header.magic));
+        header.version = LOG_INDEX_VERSION;
+        header.bloom_hashes = LOG_INDEX_BLOOM_HASHES;
+        header.bloom_bits = LOG_INDEX_BLOOM_BITS;
+        header.covered_bytes = covered_;
+        header.bucket_count = buckets.size();
+
+        std::string tmp = path_ + ".tmp";
+        std::ofstream ofs(tmp, std::ios::binary | std::ios::trunc);
+        ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        ofs.write(reinterpret_cast<const char*>(buckets.data()), static_cast<std::streamsize>(buckets.size() * sizeof(LogIndexBucket)));
+        ofs.write(reinterpret_cast<const char*>(bloom_.data()), static_cast<std::streamsize>(bloom_.size() * sizeof(uint64_t)));
+        ofs.close();
+        std::error_code ec;
+        if (!ofs) {
+            std::filesystem::remove(tmp, ec);
+            return;
+        }
+        std::filesystem::rename(tmp, path_, ec);
+    }
+
+    // 切换文件前调用
+    void close() {
+        save();
+        path_.clear();
+    }
+
+private:
+    void add_lines(std::string_view batch, uint64_t offset) {
+        size_t pos = 0;
+        while (pos < batch.size()) {
+            size_t nl = batch.find('\n', pos);
+            size_t end = nl == std::string_view::npos ? batch.size() : nl + 1;
+            add_line(batch.substr(pos, end - pos), offset + pos);
+            pos = end;
+        }
+    }
+
+    void add_line(std::string_view line, uint64_t offset) {
+        covered_ = offset + line.size();
+        int64_t second = 0;
+        bool timed = LogLine::time_of(line, second);
+        if (!timed) {
+            second = current_.lines > 0 ? current_.max_second : 0;
+        }
+        if (current_.lines > 0 && (second > current_.max_second || current_.length >= LOG_INDEX_BUCKET_BYTES)) {
+            buckets_.push_back(current_);
+            current_ = LogIndexBucket{};
+        }
+        if (current_.lines == 0) {
+            current_.min_second = current_.max_second = second;
+            current_.offset = offset;
+        }
+        current_.min_second = std::min(current_.min_second, second);
+        current_.max_second = std::max(current_.max_second, second);
+        current_.length = covered_ - current_.offset;
+        current_.lines++;
+        if (LogLine::is_error(line)) {
+            current_.errors++;
+        }
+        std::string_view uuid = LogLine::uuid_of(line);
+        if (!uuid.empty()) {
+            uint64_t step;
+            uint64_t h = LogLine::bloom_hash(uuid, step);
+            for (uint32_t i = 0; i < LOG_INDEX_BLOOM_HASHES; ++i, h += step) {
+                uint64_t bit = h % LOG_INDEX_BLOOM_BITS;
+                bloom_[bit / 64] |= uint64_t{1} << (bit % 64);
+            }
+        }
+    }
+
+    // 载入已有索引，参数不符或比文件还长（文件被截断）时丢弃
+    void load(uint64_t size) {
+        std::ifstream ifs(path_, std::ios::binary);
+        LogIndexHeader header{};
+        if (!ifs.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            std::memcmp(header.magic, LOG_INDEX_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != LOG_INDEX_VERSION || header.bloom_bits != LOG_INDEX_BLOOM_BITS ||
+            header.bloom_hashes != LOG_INDEX_BLOOM_HASHES || header.covered_bytes > size) {
+            return;
+        }
+        std::vector<LogIndexBucket> buckets(header.bucket_count);
+        std::vector<uint64_t> bloom(LOG_INDEX_BLOOM_BITS / 64);
+        if (!ifs.read(reinterpret_cast<char*>(buckets.data()), static_cast<std::streamsize>(buckets.size() * sizeof(LogIndexBucket))) ||
+            !ifs.read(reinterpret_cast<char*>(bloom.data()), static_cast<std::streamsize>(bloom.size() * sizeof(uint64_t)))) {
+            return;
+        }
+        // 最后一个桶可能还没写满，继续往里追加
+        if (!buckets.empty()) {
+            current_ = buckets.back();
+            buckets.pop_back();
+        }
+        buckets_ = std::move(buckets);
+        bloom_ = std::move(bloom);
+        covered_ = header.covered_bytes;
+    }
+
+    // 索引落后于文件（崩溃或没有索引的旧文件）时补扫
+    void catch_up(const std::string& log_path, uint64_t size) {
+        std::ifstream ifs(log_path, std::ios::binary);
+        ifs.seekg(static_cast<std::streamoff>(covered_));
+        uint64_t offset = covered_;
+        std::string buffer;
+        std::vector<char> chunk(1024 * 1024);
+        while (offset + buffer.size() < size) {
+            uint64_t want = std::min<uint64_t>(chunk.size(), size - offset - buffer.size());
+            ifs.read(chunk.data(), static_cast<std::streamsize>(want));
+            size_t got = static_cast<size_t>(ifs.gcount());
+            if (got == 0) {
+                break;
+            }
+            buffer.append(chunk.data(), got);
+            size_t last = buffer.rfind('\n');
+            if (last == std::string::npos) {
+                continue;
+            }
+            add_lines(std::string_view(buffer).substr(0, last + 1), offset);
+            offset += last + 1;
+            buffer.erase(0, last + 1);
+        }
+        if (!buffer.empty()) {
+            add_lines(buffer, offset);
+        }
+        dirty_ = true;
+    }
+
+    std::string path_;                      // 空表示未启用
+    std::vector<LogIndexBucket> buckets_;   // 已封闭的桶
+    LogIndexBucket current_{};
+    std::vector<uint64_t> bloom_;
+    uint64_t covered_ = 0;
+    bool dirty_ = false;
+    std::chrono::steady_clock::time_point last_save_ = std::chrono::steady_clock::now();
+};
+
+
+/*
+    查询端：只读 mmap 索引文件。索引不存在或损坏时 valid() 为 false，调用方应当整体扫描日志文件。
+*/
+class LogIndexView {
+public:
+    explicit LogIndexView(const std::string& log_path) {
+        int fd = ::open(LogLine::index_path(log_path).c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(LogIndexHeader)) {
+            size_ = static_cast<size_t>(st.st_size);
+            void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            base_ = p == MAP_FAILED ? nullptr : static_cast<const char*>(p);
+        }
+        ::close(fd);
+        if (!base_) {
+            return;
+        }
+        std::memcpy(&header_, base_, sizeof(header_));
+        size_t expected = sizeof(LogIndexHeader) + header_.bucket_count * sizeof(LogIndexBucket) + header_.bloom_bits / 8;
+        valid_ = std::memcmp(header_.magic, LOG_INDEX_MAGIC, sizeof(header_.magic)) == 0 &&
+                 header_.version == LOG_INDEX_VERSION && header_.bloom_bits % 64 == 0 &&
+                 header_.bloom_bits > 0 && size_ == expected;
+    }
+
+    ~LogIndexView() {
+        if (base_) {
+            ::munmap(const_cast<char*>(base_), size_);
+        }
+    }
+
+    LogIndexView(const LogIndexView&) = delete;
+    LogIndexView& operator=(const LogIndexView&) = delete;
+
+    bool valid() const {
+        return valid_;
+    }
+
+    uint64_t covered_bytes() const {
+        return valid_ ? header_.covered_bytes : 0;
+    }
+
+    const LogIndexBucket* buckets() const {
+        return reinterpret_cast<const LogIndexBucket*>(base_ + sizeof(LogIndexHeader));
+    }
+
+    size_t bucket_count() const {
+        return valid_ ? header_.bucket_count : 0;
+    }
+
+    // false 表示 uuid 一定不在已索引的部分
+    bool may_contain(std::string_view uuid) const {
+        const uint64_t* bloom = reinterpret_cast<const uint64_t*>(base_ + sizeof(LogIndexHeader) +
+                                                                  header_.bucket_count * sizeof(LogIndexBucket));
+        uint64_t step;
+        uint64_t h = LogLine::bloom_hash(uuid, step);
+        for (uint32_t i = 0; i < header_.bloom_hashes; ++i, h += step) {
+            uint64_t bit = h % header_.bloom_bits;
+            if (!(bloom[bit / 64] & (uint64_t{1} << (bit % 64)))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    const char* base_ = nullptr;
+    size_t size_ = 0;
+    LogIndexHeader header_{};
+    bool valid_ = false;
+};
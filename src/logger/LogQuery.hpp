@@ -0,0 +1,85 @@
+/*
+    进程内统计（LogAggregator、LogHeavyHitters 等）共用的文本查询支持。
+
+    查询参数为以空白分隔的 key=value 列表，由 parse_query 逐个交给调用方处理。
+    LogQueryRegistry<T> 记录进程内 T 的全部实例，query_all 依次调用每个实例的 query 并拼接结果，
+    供 /CCcloud.Admin 的查询接口使用。
+*/
+#pragma once
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+/*
+    依次以 (key, value) 调用 handler，没有 '=' 的项 value 为空；空白项跳过。
+    handler 返回 false（并自行写入错误信息）时停止解析，parse_query 返回 false。
+*/
+template <typename Handler>
+bool parse_query(std::string_view spec, Handler&& handler) {
+    size_t pos = 0;
+    while (pos < spec.size()) {
+        size_t end = spec.find_first_of(" \t\r\n", pos);
+        if (end == std::string_view::npos) {
+            end = spec.size();
+        }
+        std::string_view item = spec.substr(pos, end - pos);
+        pos = end + 1;
+        if (item.empty()) {
+            continue;
+        }
+        size_t eq = item.find('=');
+        std::string_view key = item.substr(0, eq);
+        std::string_view value = eq == std::string_view::npos ? std::string_view() : item.substr(eq + 1);
+        if (!handler(key, value)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/*
+    T 需要提供 bool query(std::string_view spec, std::string& out, std::string& error) const。
+    实例在构造函数体内 add、析构函数一开始 remove，保证 query_all 只看到完整构造的对象。
+*/
+template <typename T>
+class LogQueryRegistry {
+public:
+    static void add(const T* item) {
+        std::lock_guard<std::mutex> lock(mutex());
+        items().push_back(item);
+    }
+
+    static void remove(const T* item) {
+        std::lock_guard<std::mutex> lock(mutex());
+        auto& reg = items();
+        reg.erase(std::remove(reg.begin(), reg.end(), item), reg.end());
+    }
+
+    // 进程内全部实例的查询结果，任一实例出错即返回 false
+    static bool query_all(std::string_view spec, std::string& out, std::string& error) {
+        std::lock_guard<std::mutex> lock(mutex());
+        for (const T* item : items()) {
+            std::string part;
+            if (!item->query(spec, part, error)) {
+                return false;
+            }
+            out += part;
+        }
+        return true;
+    }
+
+private:
+    static std::vector<const T*>& items() {
+        static std::vector<const T*> reg;
+        return reg;
+    }
+
+    static std::mutex& mutex() {
+        static std::mutex m;
+        return m;
+    }
+};
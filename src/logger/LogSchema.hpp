@@ -0,0 +1,437 @@
+/*
+    编译期日志模式 (schema)。
+
+    每种记录 (PREPARE / COMMIT / ABORT / EVENT) 的文本布局由一组字段描述符在编译期给出，
+    格式化函数由模板展开生成，运行时只按 log_type 查表调用，不再有按类型分支的 if 链。
+    字段描述符记录要输出的成员 (成员指针，偏移在编译期确定)、前后缀和写出方式；
+    RecordSchema 静态检查每种记录要求的字段都被输出且没有重复。
+
+    应用自定义事件：定义一个平凡可复制的聚合体并特化 LogEventSchema，
+        struct CacheEvictEvent { uint64_t bytes; uint32_t files; };
+        template <> struct LogEventSchema<CacheEvictEvent> {
+            static constexpr uint8_t id = 1;
+            static constexpr FixedString name = "CACHE_EVICT";
+            using fields = LogEventFields<EventField<" bytes=", &CacheEvictEvent::bytes>,
+                                          EventField<" files=", &CacheEvictEvent::files>>;
+        };
+        AsyncLogger<>::instance().log_event(CacheEvictEvent{4096, 2});
+    记录时整个结构体按字节拷进 LogEntry 的文本区 ([id][结构体字节])，格式化推迟到 flush 线程。
+    编译期检查字段数等于聚合体成员数，漏掉的成员无法通过编译。事件成员限于算术/枚举类型、
+    LogUuid 和 NetAddr（数组成员会干扰成员计数）。
+*/
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <arpa/inet.h>
+
+#include "LogEntry.hpp"
+
+static constexpr size_t LOG_MAX_EVENT_KINDS = 256;
+
+
+template <size_t N>
+struct FixedString {
+    char value[N]{};
+
+    constexpr FixedString(const char (&s)[N]) {
+        std::copy_n(s, N, value);
+    }
+
+    constexpr std::string_view view() const {
+        return {value, N - 1};
+    }
+};
+
+inline std::string_view level_name(Level level) {
+    switch (level) {
+        case Level::INFO: return "INFO";
+        case Level::WARN: return "WARN";
+        case Level::ERROR: return "ERROR";
+        default: return "UNKNOWN";
+    }
+}
+
+inline std::string_view log_type_name(LogType type) {
+    switch (type) {
+        case LogType::PREPARE: return "PREPARE";
+        case LogType::COMMIT: return "COMMIT";
+        case LogType::ABORT: return "ABORT";
+        case LogType::EVENT: return "EVENT";
+        default: return "UNKNOWN";
+    }
+}
+
+inline std::string_view operation_name(OperationType op) {
+    switch (op) {
+        case OperationType::UPLOAD: return "UPLOAD";
+        case OperationType::DOWNLOAD: return "DOWNLOAD";
+        case OperationType::DELETE: return "DELETE";
+        default: return "UNKNOWN";
+    }
+}
+
+// 按值类型写出文本，不经过 iostream
+struct ValueWriter {
+    static void write(std::string& out, std::chrono::system_clock::time_point tp) {
+        // 同一秒内的记录复用日期部分，localtime_r 每秒只调用一次
+        thread_local time_t cached_sec = -1;
+        thread_local char cached[32];
+        thread_local size_t cached_len = 0;
+
+        auto in_time_t = std::chrono::system_clock::to_time_t(tp);
+        auto micros = std::chrono::duration_cast<std::chrono::microseconds>(tp.time_since_epoch()).count() % 1000000;
+        if (in_time_t != cached_sec) {
+            std::tm buf;
+            localtime_r(&in_time_t, &buf);
+            cached_len = std::strftime(cached, sizeof(cached), "%Y-%m-%d_%H:%M:%S", &buf);
+            cached_sec = in_time_t;
+        }
+        out.append(cached, cached_len);
+        char frac[7] = {'.', '0', '0', '0', '0', '0', '0'};
+        for (int i = 6; i >= 1 && micros > 0; --i, micros /= 10) {
+            frac[i] = static_cast<char>('0' + micros % 10);
+        }
+        out.append(frac, sizeof(frac));
+    }
+
+    static void write(std::string& out, TscClock::time_point tp) {
+        write(out, TscClock::to_system(tp));
+    }
+
+    static void write(std::string& out, const LogUuid& uuid) {
+        char buf[36];
+        uuid.format_to(buf);
+        out.append(buf, sizeof(buf));
+    }
+
+    static void write(std::string& out, const NetAddr& addr) {
+        char buf[INET6_ADDRSTRLEN];
+        const char* ip = nullptr;
+        if (addr.family == NetAddr::Family::V6) {
+            ip = inet_ntop(AF_INET6, addr.addr.data(), buf, sizeof(buf));
+        } else if (addr.family == NetAddr::Family::V4) {
+            ip = inet_ntop(AF_INET, addr.addr.data(), buf, sizeof(buf));
+        }
+        out.append(ip ? ip : (addr.family == NetAddr::Family::V6 ? "::" : "0.0.0.0"));
+        out.push_back(':');
+        write(out, addr.port);
+    }
+
+    static void write(std::string& out, Level level) {
+        out.append(level_name(level));
+    }
+
+    static void write(std::string& out, LogType type) {
+        out.append(log_type_name(type));
+    }
+
+    static void write(std::string& out, OperationType op) {
+        out.append(operation_name(op));
+    }
+
+    static void write(std::string& out, grpc::StatusCode code) {
+        write(out, static_cast<int>(code));
+    }
+
+    static void write(std::string& out, std::string_view text) {
+        out.append(text);
+    }
+
+    static void write(std::string& out, bool v) {
+        out.push_back(v ? '1' : '0');
+    }
+
+    template <typename T>
+        requires std::is_arithmetic_v<T>
+    static void write(std::string& out, T v) {
+        char buf[32];
+        auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), v);
+        out.append(buf, static_cast<size_t>(end - buf));
+    }
+
+    template <typename T>
+        requires std::is_enum_v<T>
+    static void write(std::string& out, T v) {
+        write(out, static_cast<std::underlying_type_t<T>>(v));
+    }
+};
+
+// COMMIT/ABORT 的 result=OK|FAILED
+struct ResultWriter {
+    static void write(std::string& out, grpc::StatusCode code) {
+        out.append(code == grpc::StatusCode::OK ? "OK" : "FAILED");
+    }
+};
+
+enum class FieldId : uint32_t {
+    TIMESTAMP,
+    UUID,
+    LEVEL,
+    LOG_TYPE,
+    OPERATION,
+    CLIENT,
+    SERVER,
+    PARAMS,
+    RESULT,
+    STATUS_CODE,
+    ERROR_MESSAGE,
+    DURATION,
+    EVENT_PAYLOAD
+};
+
+constexpr uint32_t field_bit(FieldId id) {
+    return 1u << static_cast<uint32_t>(id);
+}
+
+/*
+    一个输出字段：Prefix + 值 + Suffix。Member 可以是 LogEntry 的数据成员指针，
+    也可以是无参 const 成员函数指针。SkipEmpty 为 true 时值为空则整个字段不输出。
+*/
+template <FieldId Id,
+          FixedString Prefix,
+          auto Member,
+          FixedString Suffix = "",
+          typename Writer = ValueWriter,
+          bool SkipEmpty = false>
+struct LogField {
+    static constexpr FieldId id = Id;
+
+    static void format(std::string& out, const LogEntry& e) {
+        decltype(auto) value = get(e);
+        if constexpr (SkipEmpty) {
+            if (value.empty()) {
+                return;
+            }
+        }
+        out.append(Prefix.view());
+        Writer::write(out, value);
+        out.append(Suffix.view());
+    }
+
+private:
+    static decltype(auto) get(const LogEntry& e) {
+        if constexpr (std::is_member_function_pointer_v<decltype(Member)>) {
+            return (e.*Member)();
+        } else {
+            return (e.*Member);
+        }
+    }
+};
+
+/*
+    一种记录的完整布局。Required 为该类记录必须输出的字段集合，
+    漏掉或重复输出字段都会在编译期报错。
+*/
+template <LogType Kind, uint32_t Required, typename... Fields>
+struct RecordSchema {
+    static constexpr LogType kind = Kind;
+    static constexpr uint32_t emitted = (field_bit(Fields::id) | ...);
+
+    static_assert((emitted & Required) == Required, "log schema does not emit every field of this record kind");
+    static_assert(std::popcount(emitted) == sizeof...(Fields), "log schema emits a field more than once");
+
+    static void format(std::string& out, const LogEntry& e) {
+        (Fields::format(out, e), ...);
+        out.push_back('\n');
+    }
+};
+
+// 所有记录共有的前缀：[时间] [uuid] [级别] [类型]
+using TimestampField = LogField<FieldId::TIMESTAMP, "[", &LogEntry::timestamp, "]">;
+using UuidField = LogField<FieldId::UUID, " [", &LogEntry::uuid, "]">;
+using LevelField = LogField<FieldId::LEVEL, " [", &LogEntry::level, "]">;
+using LogTypeField = LogField<FieldId::LOG_TYPE, " [", &LogEntry::log_type, "]">;
+using OperationField = LogField<FieldId::OPERATION, " [", &LogEntry::operation, "]">;
+using ClientField = LogField<FieldId::CLIENT, " client=", &LogEntry::client>;
+using ServerField = LogField<FieldId::SERVER, " server=", &LogEntry::server>;
+using ParamsField = LogField<FieldId::PARAMS, " params=", &LogEntry::params>;
+using ResultParamsField = LogField<FieldId::PARAMS, " params=", &LogEntry::params, "", ValueWriter, true>;
+using ResultField = LogField<FieldId::RESULT, " result=", &LogEntry::status_code, "", ResultWriter>;
+using StatusCodeField = LogField<FieldId::STATUS_CODE, " code=", &LogEntry::status_code>;
+using ErrorField = LogField<FieldId::ERROR_MESSAGE, " error=", &LogEntry::error_message, "", ValueWriter, true>;
+using DurationField = LogField<FieldId::DURATION, " time=", &LogEntry::duration_ms, "ms">;
+
+static constexpr uint32_t ACCESS_RECORD_FIELDS =
+    field_bit(FieldId::TIMESTAMP) | field_bit(FieldId::UUID) | field_bit(FieldId::LEVEL) |
+    field_bit(FieldId::LOG_TYPE) | field_bit(FieldId::OPERATION) | field_bit(FieldId::CLIENT) |
+    field_bit(FieldId::SERVER);
+static constexpr uint32_t RESULT_RECORD_FIELDS =
+    ACCESS_RECORD_FIELDS | field_bit(FieldId::RESULT) | field_bit(FieldId::STATUS_CODE) |
+    field_bit(FieldId::ERROR_MESSAGE) | field_bit(FieldId::DURATION);
+
+using PrepareSchema = RecordSchema<LogType::PREPARE,
+    ACCESS_RECORD_FIELDS | field_bit(FieldId::PARAMS),
+    TimestampField, UuidField, LevelField, LogTypeField, OperationField, ClientField, ServerField, ParamsField>;
+
+// COMMIT 的 params 带 filename= size=，供回放 (CCcloud_replay) 还原请求；为空时不输出
+template <LogType Kind>
+using ResultSchema = RecordSchema<Kind, RESULT_RECORD_FIELDS,
+    TimestampField, UuidField, LevelField, LogTypeField, OperationField, ClientField, ServerField, ResultParamsField,
+    ResultField, StatusCodeField, ErrorField, DurationField>;
+
+using CommitSchema = ResultSchema<LogType::COMMIT>;
+using AbortSchema = ResultSchema<LogType::ABORT>;
+
+
+// ----------------- 自定义事件 -----------------
+
+template <typename E>
+struct LogEventSchema;
+
+template <FixedString Prefix, auto Member>
+struct EventField {
+    template <typename E>
+    static void format(std::string& out, const E& ev) {
+        out.append(Prefix.view());
+        ValueWriter::write(out, ev.*Member);
+    }
+};
+
+template <typename... Fields>
+struct LogEventFields {
+    static constexpr size_t count = sizeof...(Fields);
+
+    template <typename E>
+    static void format(std::string& out, const E& ev) {
+        (Fields::format(out, ev), ...);
+    }
+};
+
+namespace log_schema_detail {
+    struct AnyField {
+        template <typename T>
+        operator T() const;
+    };
+
+    // 聚合体的成员个数：不断增加初始化器直到无法构造
+    template <typename T, typename... A>
+    constexpr size_t aggregate_arity() {
+        if constexpr (requires { T{A{}..., AnyField{}}; }) {
+            return aggregate_arity<T, A..., AnyField>();
+        } else {
+            return sizeof...(A);
+        }
+    }
+}
+
+// 事件 id -> 格式化函数，每种事件在第一次被记录之前自动登记
+class LogEventRegistry {
+public:
+    using FormatFn = void (*)(std::string&, std::string_view payload);
+
+    static bool add(uint8_t id, std::string_view name, FormatFn fn) {
+        FormatFn expected = nullptr;
+        if (!table()[id].compare_exchange_strong(expected, fn) && expected != fn) {
+            std::cerr << "Log event id " << static_cast<int>(id) << " (" << name
+                      << ") is already registered by another event type" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    static FormatFn find(uint8_t id) {
+        return table()[id].load(std::memory_order_acquire);
+    }
+
+private:
+    static std::array<std::atomic<FormatFn>, LOG_MAX_EVENT_KINDS>& table() {
+        static std::array<std::atomic<FormatFn>, LOG_MAX_EVENT_KINDS> formatters{};
+        return formatters;
+    }
+};
+
+template <typename E>
+struct EventCodec {
+    using Schema = LogEventSchema<E>;
+
+    static_assert(std::is_trivially_copyable_v<E>, "log events are copied byte-wise into the entry");
+    static_assert(std::is_aggregate_v<E>, "log events must be aggregates");
+    static_assert(Schema::fields::count == log_schema_detail::aggregate_arity<E>(),
+                  "LogEventSchema must list every member of the event");
+    static_assert(1 + sizeof(E) <= LogTextSlab::BLOCK_PAYLOAD, "log event is too large");
+
+    // 负载：[id][E 的字节]
+    static void format(std::string& out, std::string_view payload) {
+        E ev;
+        std::memcpy(&ev, payload.data() + 1, std::min(sizeof(E), payload.size() - 1));
+        out.append(" [");
+        out.append(Schema::name.view());
+        out.push_back(']');
+        Schema::fields::format(out, ev);
+    }
+
+    static inline const bool registered = LogEventRegistry::add(Schema::id, Schema::name.view(), &format);
+};
+
+// EVENT 记录：公共前缀之后由事件自己的 schema 输出
+struct EventPayloadField {
+    static constexpr FieldId id = FieldId::EVENT_PAYLOAD;
+
+    static void format(std::string& out, const LogEntry& e) {
+        std::string_view payload = e.params();
+        LogEventRegistry::FormatFn fn = payload.empty()
+            ? nullptr
+            : LogEventRegistry::find(static_cast<uint8_t>(payload[0]));
+        if (fn) {
+            fn(out, payload);
+        } else {
+            out.append(" [UNKNOWN_EVENT]");
+        }
+    }
+};
+
+using EventSchema = RecordSchema<LogType::EVENT,
+    field_bit(FieldId::TIMESTAMP) | field_bit(FieldId::UUID) | field_bit(FieldId::LEVEL) |
+    field_bit(FieldId::LOG_TYPE) | field_bit(FieldId::EVENT_PAYLOAD),
+    TimestampField, UuidField, LevelField, LogTypeField, EventPayloadField>;
+
+// 构造一条事件记录；事件不超过 35 字节时放在内联缓冲区，不做任何分配
+template <typename E>
+LogEntry make_log_event(const E& ev, Level level = Level::INFO) {
+    (void)EventCodec<E>::registered;
+    LogEntry entry;
+    entry.level = level;
+    entry.log_type = LogType::EVENT;
+    char payload[1 + sizeof(E)];
+    payload[0] = static_cast<char>(LogEventSchema<E>::id);
+    std::memcpy(payload + 1, &ev, sizeof(E));
+    entry.text.assign(std::string_view(payload, sizeof(payload)), {});
+    return entry;
+}
+
+
+// 按 log_type 索引的格式化函数表
+struct LogSchemaTable {
+    using FormatFn = void (*)(std::string&, const LogEntry&);
+
+    static constexpr std::array<FormatFn, 4> formatters = {
+        &PrepareSchema::format,
+        &CommitSchema::format,
+        &AbortSchema::format,
+        &EventSchema::format,
+    };
+
+    static_assert(static_cast<size_t>(PrepareSchema::kind) == 0 &&
+                  static_cast<size_t>(CommitSchema::kind) == 1 &&
+                  static_cast<size_t>(AbortSchema::kind) == 2 &&
+                  static_cast<size_t>(EventSchema::kind) == 3,
+                  "formatter table must follow the LogType order");
+
+    static void format(std::string& out, const LogEntry& e) {
+        size_t index = static_cast<size_t>(e.log_type);
+        if (index < formatters.size()) {
+            formatters[index](out, e);
+        }
+    }
+};
@@ -0,0 +1,600 @@
+/*
+    日志输出端 (sink)。
+
+    flush 线程把一批日志格式化成若干完整的行后，依次交给挂在 logger 上的每个 sink。
+    主文件 sink 直接在 flush 线程上写；其他 sink 默认包一层 IsolatedSink，拥有自己的
+    线程和有界缓冲，慢的 sink 只会丢自己的数据，不会拖住 flush 线程或其他 sink。
+    被多个分片共享的 sink 需要自己保证线程安全。
+*/
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "LogEntry.hpp"
+#include "LogIndex.hpp"
+
+static constexpr int MAX_LOG_FILE_SIZE = 32 * 1024 * 1024; // 每个日志文件最大大小 32MB
+static constexpr size_t ISOLATED_SINK_MAX_PENDING = 8 * 1024 * 1024; // 隔离 sink 的缓冲上限
+static constexpr size_t DATAGRAM_MAX_SIZE = 60 * 1024; // 单个数据报的最大长度
+static constexpr int MAX_CRASH_RINGS = 8;
+
+
+class LogSink {
+public:
+    virtual ~LogSink() = default;
+
+    // batch 由若干以 '\n' 结尾的完整日志行组成。这一批被丢弃（计入 dropped）时返回 false
+    virtual bool write(std::string_view batch) = 0;
+
+    virtual void flush() {}
+
+    // 写出的数据落到持久存储，默认等同于 flush。不能确认已落盘时返回 false
+    virtual bool sync() {
+        flush();
+        return true;
+    }
+
+    // 因缓冲满或对端不可用而丢弃的批次数
+    virtual uint64_t dropped() const { return 0; }
+};
+
+/*
+    以 LogEntry 为单位消费日志的观察者（如 LogAggregator），在 flush 线程上、每批写出之后调用。
+    被多个分片共享，需要自己保证线程安全。
+*/
+class LogObserver {
+public:
+    virtual ~LogObserver() = default;
+
+    virtual void observe(const std::vector<LogEntry>& batch) = 0;
+
+    // logger 停止、所有分片都已清空后调用一次
+    virtual void flush() {}
+};
+
+/*
+    按日期分目录、按大小滚动的文本文件：<root>/<YYYY-MM-DD>/<prefix><n>.txt。
+    文件句柄在批次之间保持打开，跨天或超过 MAX_LOG_FILE_SIZE 时切换到下一个文件。
+    只由所属分片的 flush 线程调用，set_directory 除外。
+*/
+class FileSink : public LogSink {
+public:
+    FileSink(const std::string& root, const std::string& prefix = "")
+        : root_(root), prefix_(prefix) {}
+
+    bool write(std::string_view batch) override {
+        if (batch.empty()) {
+            return true;
+        }
+        ensure_open();
+        ofs_.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+        ofs_.flush();
+        bool ok = static_cast<bool>(ofs_);
+        if (!ok) {
+            // 磁盘满等错误：这一批计为丢弃，下一批重试
+            ofs_.clear();
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        } else if (index_enabled_) {
+            index_.add(batch, current_size_);
+        }
+        current_size_ += batch.size();
+        return ok;
+    }
+
+    uint64_t dropped() const override {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+    // 切换到新文件的次数（写满、跨天或更换目录）
+    uint64_t rotations() const {
+        return rotations_.load(std::memory_order_relaxed);
+    }
+
+    void flush() override {
+        if (ofs_.is_open()) {
+            ofs_.flush();
+        }
+    }
+
+    ~FileSink() override {
+        index_.close();
+        if (sync_fd_ >= 0) {
+            ::close(sync_fd_);
+        }
+    }
+
+    // fdatasync 当前文件，以及上次同步后滚动出去的文件。任何一步失败都返回 false
+    bool sync() override {
+        flush();
+        bool ok = true;
+        if (ofs_.is_open() && !ofs_) {
+            ofs_.clear();
+            ok = false;
+        }
+        for (const auto& path : unsynced_rotated_) {
+            ok = sync_path(path.c_str(), O_RDONLY) && ok;
+        }
+        unsynced_rotated_.clear();
+        if (!ofs_.is_open()) {
+            return ok;
+        }
+        if (sync_fd_ < 0) {
+            // ofstream 不暴露描述符，另开一个只用于同步；fdatasync 作用于文件而不是描述符
+            sync_fd_ = ::open(current_path_.c_str(), O_RDONLY | O_CLOEXEC);
+        }
+        if (sync_fd_ < 0 || ::fdatasync(sync_fd_) != 0) {
+            std::cerr << "fdatasync failed for " << current_path_ << ": " << std::strerror(errno) << std::endl;
+            ok = false;
+        }
+        if (sync_dir_) {
+            // 新建的文件还要同步目录项，失败时下次同步再试
+            sync_dir_ = !sync_path(date_dir_.c_str(), O_RDONLY | O_DIRECTORY);
+            ok = ok && !sync_dir_;
+        }
+        return ok;
+    }
+
+    void set_directory(const std::string& root) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        root_ = root;
+        reopen_ = true;
+    }
+
+    // 当前正在写入的文件路径
+    std::string current_path() const {
+        return current_path_.string();
+    }
+
+    // 写入的同时维护 <n>.txt.idx 稀疏索引（见 LogIndex.hpp）。须在第一次 write 之前设置。
+    void enable_index() {
+        index_enabled_ = true;
+    }
+
+    // 文件滚动（写满或跨天）后以旧文件路径回调，用于后台压缩。须在第一次 write 之前设置。
+    void set_rotate_callback(std::function<void(const std::string&)> callback) {
+        on_rotate_ = std::move(callback);
+    }
+
+    // 本地时区的 YYYY-MM-DD，即日期目录名
+    static std::string today() {
+        auto now = std::chrono::system_clock::now();
+        std::time_t t = std::chrono::system_clock::to_time_t(now);
+        std::tm tm_time;
+#if defined(_WIN32) || defined(_WIN64)
+        localtime_s(&tm_time, &t);
+#else
+        localtime_r(&t, &tm_time);
+#endif
+        std::stringstream ss;
+        ss << std::put_time(&tm_time, "%Y-%m-%d");
+        return ss.str();
+    }
+
+private:
+    std::filesystem::path file_path(int index) const {
+        return date_dir_ / (prefix_ + std::to_string(index) + ".txt");
+    }
+
+    void ensure_open() {
+        namespace fs = std::filesystem;
+        std::string date = today();
+        bool reopen;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            reopen = reopen_;
+            reopen_ = false;
+            if (reopen || date != date_ || !ofs_.is_open()) {
+                date_dir_ = fs::path(root_) / date;
+            }
+        }
+
+        if (reopen || date != date_ || !ofs_.is_open()) {
+            std::error_code ec;
+            fs::create_directories(date_dir_, ec);   // 多个分片可能同时创建同一个日期目录
+            if (!fs::is_directory(date_dir_)) {
+                throw std::runtime_error("Failed to create date directory: " + date_dir_.string());
+            }
+            if (date != date_) {
+                if (ofs_.is_open()) {
+                    rotated(current_path_);
+                }
+                current_file_index_ = 1;
+                date_ = date;
+            }
+            // 跳过已经写满或已压缩的文件，进程重启后接着最后一个未满的文件写
+            while (true) {
+                fs::path candidate = file_path(current_file_index_);
+                if (fs::exists(candidate.string() + ".zst", ec)) {
+                    ++current_file_index_;
+                    continue;
+                }
+                std::error_code size_ec;
+                uintmax_t f_size = fs::file_size(candidate, size_ec);
+                if (size_ec || f_size < MAX_LOG_FILE_SIZE) {
+                    current_size_ = size_ec ? 0 : f_size;
+                    break;
+                }
+                rotated(candidate);
+                ++current_file_index_;
+            }
+            open_current();
+        } else if (current_size_ >= MAX_LOG_FILE_SIZE) {
+            fs::path previous = current_path_;
+            ++current_file_index_;
+            current_size_ = 0;
+            open_current();
+            rotated(previous);
+        }
+    }
+
+    static bool sync_path(const char* path, int flags) {
+        int fd = ::open(path, flags | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        bool ok = ((flags & O_DIRECTORY) ? ::fsync(fd) : ::fdatasync(fd)) == 0;
+        ::close(fd);
+        return ok;
+    }
+
+    void rotated(const std::filesystem::path& path) {
+        if (on_rotate_) {
+            on_rotate_(path.string());
+        }
+    }
+
+    void open_current() {
+        if (ofs_.is_open()) {
+            ofs_.close();
+            index_.close();
+            unsynced_rotated_.push_back(current_path_.string());
+            rotations_.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (sync_fd_ >= 0) {
+            ::close(sync_fd_);
+            sync_fd_ = -1;
+        }
+        current_path_ = file_path(current_file_index_);
+        sync_dir_ = !std::filesystem::exists(current_path_);
+        ofs_.open(current_path_, std::ios::app | std::ios::binary);
+        if (!ofs_.is_open()) {
+            throw std::runtime_error("Failed to open log file: " + current_path_.string());
+        }
+        if (index_enabled_) {
+            index_.open(current_path_.string(), current_size_);
+        }
+    }
+
+    std::mutex mutex_;          // 保护 root_ / reopen_
+    std::string root_;
+    bool reopen_ = false;
+    std::string prefix_;
+    std::string date_;
+    std::filesystem::path date_dir_;
+    std::filesystem::path current_path_;
+    std::ofstream ofs_;
+    int current_file_index_ = 1;
+    uintmax_t current_size_ = 0;
+    std::function<void(const std::string&)> on_rotate_;
+    int sync_fd_ = -1;                          // 仅用于 fdatasync 当前文件
+    bool sync_dir_ = false;                     // 当前文件是新建的，同步时连同目录一起
+    std::vector<std::string> unsynced_rotated_; // 上次同步之后关闭的文件
+    std::atomic<uint64_t> rotations_{0};
+    std::atomic<uint64_t> dropped_{0};
+    bool index_enabled_ = false;
+    LogIndexBuilder index_;
+};
+
+class StderrSink : public LogSink {
+public:
+    bool write(std::string_view batch) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return std::fwrite(batch.data(), 1, batch.size(), stderr) == batch.size();
+    }
+
+private:
+    std::mutex mutex_;
+};
+
+/*
+    把日志以 SOCK_DGRAM 发送到本机收集进程监听的 Unix socket。
+    套接字为非阻塞：对端缓冲满或未启动时直接丢弃当前数据报并计数，不做重试；
+    断开后最多每秒尝试重连一次。每个数据报只包含完整的行。
+*/
+class UnixDatagramSink : public LogSink {
+public:
+    explicit UnixDatagramSink(const std::string& socket_path)
+        : socket_path_(socket_path) {
+        if (socket_path.size() >= sizeof(sockaddr_un::sun_path)) {
+            throw std::runtime_error("Unix socket path too long: " + socket_path);
+        }
+        fd_ = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd_ < 0) {
+            throw std::runtime_error("Failed to create unix datagram socket: " + std::string(std::strerror(errno)));
+        }
+        try_connect();
+    }
+
+    ~UnixDatagramSink() override {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    bool write(std::string_view batch) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!connected_ && !try_connect()) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        bool ok = true;
+
+        while (!batch.empty()) {
+            size_t len = batch.size();
+            if (len > DATAGRAM_MAX_SIZE) {
+                size_t cut = batch.rfind('\n', DATAGRAM_MAX_SIZE - 1);
+                len = cut == std::string_view::npos ? DATAGRAM_MAX_SIZE : cut + 1;
+            }
+            if (::send(fd_, batch.data(), len, MSG_NOSIGNAL) < 0) {
+                if (errno == ECONNREFUSED || errno == ENOTCONN || errno == ENOENT) {
+                    connected_ = false;
+                }
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                if (!connected_) {
+                    return false;
+                }
+                ok = false;
+            }
+            batch.remove_prefix(len);
+        }
+        return ok;
+    }
+
+    uint64_t dropped() const override {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+private:
+    bool try_connect() {
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_attempt_ < std::chrono::seconds(1)) {
+            return false;
+        }
+        last_attempt_ = now;
+
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::memcpy(addr.sun_path, socket_path_.c_str(), socket_path_.size() + 1);
+        connected_ = ::connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+        return connected_;
+    }
+
+    std::string socket_path_;
+    int fd_ = -1;
+    bool connected_ = false;
+    std::chrono::steady_clock::time_point last_attempt_{};
+    std::mutex mutex_;
+    std::atomic<uint64_t> dropped_{0};
+};
+
+/*
+    内存环形缓冲，保留最近 capacity 字节的日志，不落盘。
+    install_crash_handler 之后进程收到 SIGSEGV/SIGBUS/SIGFPE/SIGILL/SIGABRT 时，
+    信号处理函数只用 open/write 把所有已注册环的内容追加到 dump 文件，然后按默认方式
+    重新触发该信号。dump 时不加锁，正在写入的那一行可能不完整。
+*/
+class MemoryRingSink : public LogSink {
+public:
+    explicit MemoryRingSink(size_t capacity)
+        : buffer_(capacity) {
+        if (capacity == 0) {
+            throw std::runtime_error("MemoryRingSink capacity must be positive");
+        }
+        for (auto& slot : crash_rings()) {
+            MemoryRingSink* expected = nullptr;
+            if (slot.compare_exchange_strong(expected, this)) {
+                break;
+            }
+        }
+    }
+
+    ~MemoryRingSink() override {
+        for (auto& slot : crash_rings()) {
+            MemoryRingSink* expected = this;
+            slot.compare_exchange_strong(expected, nullptr);
+        }
+    }
+
+    bool write(std::string_view batch) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t cap = buffer_.size();
+        if (batch.size() > cap) {
+            batch.remove_prefix(batch.size() - cap);
+        }
+        size_t pos = written_.load(std::memory_order_relaxed) % cap;
+        size_t first = std::min(batch.size(), cap - pos);
+        std::memcpy(buffer_.data() + pos, batch.data(), first);
+        std::memcpy(buffer_.data(), batch.data() + first, batch.size() - first);
+        written_.fetch_add(batch.size(), std::memory_order_release);
+        return true;
+    }
+
+    // 按时间顺序返回当前保留的内容
+    std::string snapshot() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t cap = buffer_.size();
+        size_t total = written_.load(std::memory_order_relaxed);
+        if (total <= cap) {
+            return std::string(buffer_.data(), total);
+        }
+        size_t pos = total % cap;
+        std::string out(buffer_.data() + pos, cap - pos);
+        out.append(buffer_.data(), pos);
+        return out;
+    }
+
+    // 异步信号安全：只调用 write(2)
+    void dump_to_fd(int fd) const {
+        size_t cap = buffer_.size();
+        size_t total = written_.load(std::memory_order_acquire);
+        if (total <= cap) {
+            write_all(fd, buffer_.data(), total);
+        } else {
+            size_t pos = total % cap;
+            write_all(fd, buffer_.data() + pos, cap - pos);
+            write_all(fd, buffer_.data(), pos);
+        }
+    }
+
+    static void install_crash_handler(const std::string& dump_path) {
+        std::strncpy(dump_path_storage(), dump_path.c_str(), PATH_MAX - 1);
+        dump_path_storage()[PATH_MAX - 1] = '\0';
+        struct sigaction sa{};
+        sa.sa_handler = &MemoryRingSink::on_fatal_signal;
+        sigemptyset(&sa.sa_mask);
+        sa.sa_flags = SA_RESETHAND;
+        for (int sig : {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT}) {
+            sigaction(sig, &sa, nullptr);
+        }
+    }
+
+private:
+    static std::atomic<MemoryRingSink*> (&crash_rings())[MAX_CRASH_RINGS] {
+        static std::atomic<MemoryRingSink*> rings[MAX_CRASH_RINGS];
+        return rings;
+    }
+
+    static char* dump_path_storage() {
+        static char path[PATH_MAX];
+        return path;
+    }
+
+    static void write_all(int fd, const char* data, size_t len) {
+        while (len > 0) {
+            ssize_t n = ::write(fd, data, len);
+            if (n <= 0) {
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                return;
+            }
+            data += n;
+            len -= static_cast<size_t>(n);
+        }
+    }
+
+    static void on_fatal_signal(int sig) {
+        int fd = ::open(dump_path_storage(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd >= 0) {
+            for (auto& slot : crash_rings()) {
+                if (MemoryRingSink* ring = slot.load(std::memory_order_acquire)) {
+                    ring->dump_to_fd(fd);
+                }
+            }
+            ::close(fd);
+        }
+        ::raise(sig);   // SA_RESETHAND 已恢复默认处理
+    }
+
+    std::vector<char> buffer_;
+    std::atomic<size_t> written_{0};
+    mutable std::mutex mutex_;
+};
+
+/*
+    把任意 sink 放到独立线程上执行。write 只拷贝数据进有界队列，超过 max_pending
+    字节时整批丢弃并计数，因此下游再慢也不会反压 flush 线程。
+*/
+class IsolatedSink : public LogSink {
+public:
+    explicit IsolatedSink(std::shared_ptr<LogSink> inner, size_t max_pending = ISOLATED_SINK_MAX_PENDING)
+        : inner_(std::move(inner)), max_pending_(max_pending) {
+        worker_ = std::thread(&IsolatedSink::run, this);
+    }
+
+    ~IsolatedSink() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_ = false;
+        }
+        cv_.notify_one();
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+    }
+
+    // 只表示是否进入了缓冲，下游的写入结果不回传
+    bool write(std::string_view batch) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (pending_bytes_ + batch.size() > max_pending_) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            pending_bytes_ += batch.size();
+            pending_.emplace_back(batch);
+        }
+        cv_.notify_one();
+        return true;
+    }
+
+    uint64_t dropped() const override {
+        return dropped_.load(std::memory_order_relaxed) + inner_->dropped();
+    }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            cv_.wait(lock, [this]() { return !running_ || !pending_.empty(); });
+            if (pending_.empty()) {
+                break;  // 已停止且缓冲已清空
+            }
+            std::string batch = std::move(pending_.front());
+            pending_.pop_front();
+            pending_bytes_ -= batch.size();
+            lock.unlock();
+            try {
+                inner_->write(batch);
+            } catch (const std::exception&) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+            }
+            lock.lock();
+        }
+        inner_->flush();
+    }
+
+    std::shared_ptr<LogSink> inner_;
+    const size_t max_pending_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::string> pending_;
+    size_t pending_bytes_ = 0;
+    bool running_ = true;
+    std::atomic<uint64_t> dropped_{0};
+    std::thread worker_;
+};
@@ -0,0 +1,206 @@
+/*
+    logger 自身的运行指标。
+
+    生产者只在入队时给一个按线程分散的计数器加一 (relaxed)，不会和其他生产者争同一条缓存行；
+    其余指标由 flush 线程在每批结束时更新一次。读取方 (管理接口) 只做原子读取，不影响写入路径。
+    速率按两次采样之间的增量计算，采样间隔不少于 LOG_METRICS_RATE_WINDOW。
+
+    所有实例登记在 LoggerMetrics::describe_all 中，由 AdminService 的 /CCcloud.Admin/GetLoggerStats 输出。
+*/
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static constexpr size_t LOG_METRICS_STRIPES = 16;       // 入队计数的分散槽数
+static constexpr size_t LOG_BATCH_BUCKETS = 10;         // 批大小直方图：[1] [2,3] [4,7] ... [512,+inf)
+static constexpr auto LOG_METRICS_RATE_WINDOW = std::chrono::seconds(1);
+
+
+struct LoggerStats {
+    uint64_t enqueued = 0;
+    uint64_t flushed = 0;       // 已从队列取出并写出的条数
+    uint64_t depth = 0;         // enqueued - flushed，近似的当前队列长度
+    uint64_t batches = 0;
+    std::array<uint64_t, LOG_BATCH_BUCKETS> batch_sizes{};
+    uint64_t format_ns = 0;
+    uint64_t write_ns = 0;
+    uint64_t max_batch_ns = 0;  // 单批格式化加写入的最长耗时
+    uint64_t bytes = 0;
+    uint64_t syncs = 0;
+    uint64_t rotations = 0;
+    uint64_t dropped = 0;
+    double enqueue_per_sec = 0;
+    double bytes_per_sec = 0;
+};
+
+
+class LoggerMetrics {
+public:
+    explicit LoggerMetrics(std::string name) : name_(std::move(name)) {
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        registry().push_back(this);
+    }
+
+    ~LoggerMetrics() {
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        auto& reg = registry();
+        reg.erase(std::remove(reg.begin(), reg.end(), this), reg.end());
+    }
+
+    LoggerMetrics(const LoggerMetrics&) = delete;
+    LoggerMetrics& operator=(const LoggerMetrics&) = delete;
+
+    // 生产者：stripe 取线程序号即可
+    void on_enqueue(size_t stripe) {
+        enqueued_[stripe % LOG_METRICS_STRIPES].value.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // flush 线程：一批写出之后
+    void on_batch(size_t count, size_t bytes, std::chrono::nanoseconds format_time, std::chrono::nanoseconds write_time) {
+        flushed_.fetch_add(count, std::memory_order_relaxed);
+        batches_.fetch_add(1, std::memory_order_relaxed);
+        size_t bucket = std::min<size_t>(std::bit_width(count) - 1, LOG_BATCH_BUCKETS - 1);
+        batch_sizes_[bucket].fetch_add(1, std::memory_order_relaxed);
+        bytes_.fetch_add(bytes, std::memory_order_relaxed);
+        uint64_t format_ns = static_cast<uint64_t>(format_time.count());
+        uint64_t write_ns = static_cast<uint64_t>(write_time.count());
+        format_ns_.fetch_add(format_ns, std::memory_order_relaxed);
+        write_ns_.fetch_add(write_ns, std::memory_order_relaxed);
+        uint64_t total = format_ns + write_ns;
+        uint64_t current = max_batch_ns_.load(std::memory_order_relaxed);
+        while (current < total && !max_batch_ns_.compare_exchange_weak(current, total, std::memory_order_relaxed)) {
+        }
+    }
+
+    void on_sync() {
+        syncs_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // 滚动和丢弃由 sink 自己计数，读取时通过 source 汇总
+    void set_sink_counters(std::function<void(uint64_t& rotations, uint64_t& dropped)> source) {
+        std::lock_guard<std::mutex> lock(rate_mutex_);
+        sink_counters_ = std::move(source);
+    }
+
+    LoggerStats snapshot() {
+        LoggerStats s;
+        for (const auto& stripe : enqueued_) {
+            s.enqueued += stripe.value.load(std::memory_order_relaxed);
+        }
+        s.flushed = flushed_.load(std::memory_order_relaxed);
+        s.depth = s.enqueued > s.flushed ? s.enqueued - s.flushed : 0;  // 恢复的记录不经过 append
+        s.batches = batches_.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < LOG_BATCH_BUCKETS; ++i) {
+            s.batch_sizes[i] = batch_sizes_[i].load(std::memory_order_relaxed);
+        }
+        s.format_ns = format_ns_.load(std::memory_order_relaxed);
+        s.write_ns = write_ns_.load(std::memory_order_relaxed);
+        s.max_batch_ns = max_batch_ns_.load(std::memory_order_relaxed);
+        s.bytes = bytes_.load(std::memory_order_relaxed);
+        s.syncs = syncs_.load(std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(rate_mutex_);
+        if (sink_counters_) {
+            sink_counters_(s.rotations, s.dropped);
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (now - sample_time_ >= LOG_METRICS_RATE_WINDOW) {
+            double seconds = std::chrono::duration<double>(now - sample_time_).count();
+            enqueue_per_sec_ = static_cast<double>(s.enqueued - sample_enqueued_) / seconds;
+            bytes_per_sec_ = static_cast<double>(s.bytes - sample_bytes_) / seconds;
+            sample_time_ = now;
+            sample_enqueued_ = s.enqueued;
+            sample_bytes_ = s.bytes;
+        }
+        s.enqueue_per_sec = enqueue_per_sec_;
+        s.bytes_per_sec = bytes_per_sec_;
+        return s;
+    }
+
+    // 与 LogFilter::describe 相同的 key=value 文本
+    std::string describe() {
+        LoggerStats s = snapshot();
+        std::ostringstream oss;
+        oss << std::fixed << std::setprecision(1);
+        oss << "[" << name_ << "]\n";
+        oss << "enqueued=" << s.enqueued << "\n";
+        oss << "enqueue_per_sec=" << s.enqueue_per_sec << "\n";
+        oss << "depth=" << s.depth << "\n";
+        oss << "flushed=" << s.flushed << "\n";
+        oss << "batches=" << s.batches << "\n";
+        for (size_t i = 0; i < LOG_BATCH_BUCKETS; ++i) {
+            oss << "batch_size." << (uint64_t{1} << i);
+            if (i > 0 && i + 1 < LOG_BATCH_BUCKETS) {
+                oss << "-" << (uint64_t{2} << i) - 1;
+            } else if (i > 0) {
+                oss << "+";
+            }
+            oss << "=" << s.batch_sizes[i] << "\n";
+        }
+        double batches = s.batches ? static_cast<double>(s.batches) : 1.0;
+        oss << "format_us.avg=" << s.format_ns / batches / 1000 << "\n";
+        oss << "write_us.avg=" << s.write_ns / batches / 1000 << "\n";
+        oss << "batch_us.max=" << s.max_batch_ns / 1000.0 << "\n";
+        oss << "bytes=" << s.bytes << "\n";
+        oss << "bytes_per_sec=" << s.bytes_per_sec << "\n";
+        oss << "syncs=" << s.syncs << "\n";
+        oss << "rotations=" << s.rotations << "\n";
+        oss << "dropped=" << s.dropped << "\n";
+        return oss.str();
+    }
+
+    // 进程内全部 logger 的指标
+    static std::string describe_all() {
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        std::string out;
+        for (LoggerMetrics* m : registry()) {
+            out += m->describe();
+        }
+        return out;
+    }
+
+private:
+    struct alignas(64) Stripe {
+        std::atomic<uint64_t> value{0};
+    };
+
+    static std::vector<LoggerMetrics*>& registry() {
+        static std::vector<LoggerMetrics*> reg;
+        return reg;
+    }
+
+    static std::mutex& registry_mutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    std::string name_;
+    std::array<Stripe, LOG_METRICS_STRIPES> enqueued_;
+    // 以下由 flush 线程写入
+    alignas(64) std::atomic<uint64_t> flushed_{0};
+    std::atomic<uint64_t> batches_{0};
+    std::array<std::atomic<uint64_t>, LOG_BATCH_BUCKETS> batch_sizes_{};
+    std::atomic<uint64_t> format_ns_{0};
+    std::atomic<uint64_t> write_ns_{0};
+    std::atomic<uint64_t> max_batch_ns_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> syncs_{0};
+    // 以下只由读取方访问
+    std::mutex rate_mutex_;
+    std::function<void(uint64_t&, uint64_t&)> sink_counters_;
+    std::chrono::steady_clock::time_point sample_time_ = std::chrono::steady_clock::now();
+    uint64_t sample_enqueued_ = 0;
+    uint64_t sample_bytes_ = 0;
+    double enqueue_per_sec_ = 0;
+    double bytes_per_sec_ = 0;
+};
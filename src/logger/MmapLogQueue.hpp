@@ -0,0 +1,507 @@
+/*
+    基于文件 mmap 的崩溃安全日志队列，可作为 AsyncLogger 的队列类型使用：
+        AsyncLogger<MmapLogQueue>::named("access", options, "/var/log/cccloud/access.ring");
+
+    记录直接写进 MAP_SHARED 映射的文件页。进程崩溃或被 SIGKILL 后，内核仍会把这些脏页写回文件，
+    所以入队即持久（不防断电，也不对每条记录 fsync）。
+
+    槽位协议与 Vyukov 有界队列相同：每个槽位带一个序号 seq，生产者等到 seq == pos 时写入，
+    写完发布 seq = pos + 1。不同之处在于消费者取出记录后并不立即归还槽位，而是等 flush 线程把
+    整批记录写进日志文件后调用 commit_dequeued()，才推进文件头中的 flushed_pos 并把槽位交还生产者。
+    因此崩溃时 [flushed_pos, enqueue_pos) 中的记录仍完整保存在文件里：
+      - 以同一文件重新构造队列时，这些记录会重新出现在队列中，由 flush 线程补写；
+      - 也可以用 cclog_recover 离线导出，不需要启动服务。
+    整批写入日志文件之后、commit 之前崩溃，这一批会在恢复时重复出现（至少一次语义）。
+
+    只支持单消费者：dequeue / dequeue_bulk / empty / size / commit_dequeued 只能由同一个 flush 线程调用。
+    环满时生产者按 Wait 策略等待 flush 线程提交（默认 ParkingWait，见 WaitStrategy.hpp），
+    wait_dequeue 同样按策略等待新记录。enqueue_bulk 一次 CAS 占住一段连续的空槽位。
+*/
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "LogEntry.hpp"
+#include "tools/BaseQueue.hpp"
+#include "tools/WaitStrategy.hpp"
+
+static constexpr uint64_t MMAP_LOG_MAGIC = 0x314c474e52434343ULL;   // "CCCRNGL1"
+static constexpr uint32_t MMAP_LOG_VERSION = 1;
+static constexpr size_t MMAP_LOG_DEFAULT_CAPACITY = 16384;          // 槽位数 (2 的幂)，每槽 1152 字节
+static constexpr size_t MMAP_LOG_HEADER_SIZE = 4096;
+
+
+// 槽位中 LogEntry 的定长部分，text 紧随其后
+struct MmapLogRecord {
+    int64_t timestamp_ns;
+    int64_t duration_ms;
+    uint8_t uuid[16];
+    uint8_t client_addr[16];
+    uint8_t server_addr[16];
+    uint16_t client_port;
+    uint16_t server_port;
+    uint8_t client_family;
+    uint8_t server_family;
+    uint8_t level;
+    uint8_t log_type;
+    uint8_t operation;
+    int32_t status_code;
+    uint16_t params_len;
+    uint16_t error_len;
+    uint32_t sample_ppm;        // 原先的结尾填充，旧文件中为 0（未经采样），格式版本不变
+};
+
+// 槽位能容纳一个完整的溢出块，记录不会因为写进文件而被截断
+struct alignas(64) MmapLogSlot {
+    std::atomic<uint64_t> seq;
+    MmapLogRecord record;
+    char text[LogTextSlab::BLOCK_PAYLOAD];
+};
+
+struct MmapLogHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t slot_size;
+    uint64_t capacity;
+    alignas(64) std::atomic<uint64_t> enqueue_pos;
+    alignas(64) std::atomic<uint64_t> flushed_pos;  // 之前的记录都已写入日志文件
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring sequence numbers live in shared memory");
+static_assert(sizeof(MmapLogHeader) <= MMAP_LOG_HEADER_SIZE);
+static_assert(std::is_trivially_copyable_v<MmapLogRecord>);
+static_assert(sizeof(MmapLogRecord) == 88, "ring slot layout is part of MMAP_LOG_VERSION");
+
+
+template <typename Wait = ParkingWait>
+    requires WaitStrategy<Wait>
+class BasicMmapLogQueue {
+public:
+    using value_type = LogEntry;
+
+    /*
+        打开或创建 path 处的环形文件。文件已存在时沿用其中记录的容量，capacity 参数被忽略；
+        多分片 logger 中每个分片使用 <path>.shard<k>。
+    */
+    explicit BasicMmapLogQueue(const std::string& path,
+                          size_t capacity = MMAP_LOG_DEFAULT_CAPACITY,
+                          QueueShard shard = {})
+        : path_(shard.count > 1 ? path + ".shard" + std::to_string(shard.index) : path) {
+        if (capacity < 2 || (capacity & (capacity - 1)) != 0) {
+            throw std::runtime_error("MmapLogQueue capacity must be a power of two: " + std::to_string(capacity));
+        }
+        bool fresh = map_file(capacity);
+        if (fresh) {
+            format();
+        } else {
+            resume();
+        }
+    }
+
+    // 只给出路径时 AsyncLogger 也要能传入分片序号，否则各分片会映射同一个文件
+    BasicMmapLogQueue(const std::string& path, QueueShard shard)
+        : BasicMmapLogQueue(path, MMAP_LOG_DEFAULT_CAPACITY, shard) {}
+
+    ~BasicMmapLogQueue() {
+        if (base_) {
+            ::munmap(base_, map_size_);
+        }
+    }
+
+    BasicMmapLogQueue(const BasicMmapLogQueue&) = delete;
+    BasicMmapLogQueue& operator=(const BasicMmapLogQueue&) = delete;
+
+    // 记录总要编码进文件，右值入队也按 const& 处理
+    void enqueue(const LogEntry& value) {
+        enqueue_until(value, WaitDeadline::max());
+    }
+
+    // 环满时最多等待 timeout，超时返回 false
+    bool enqueue_for(const LogEntry& value, std::chrono::nanoseconds timeout) {
+        return enqueue_until(value, wait_deadline(timeout));
+    }
+
+    // 环满时返回 false
+    bool try_enqueue(const LogEntry& value) {
+        uint64_t pos;
+        if (reserve(1, pos) == 0) {
+            return false;
+        }
+        publish(pos, value);
+        not_empty_.notify();
+        return true;
+    }
+
+    // 每次占住尽可能多的连续空槽位，返回时全部入队
+    template <typename InputIt>
+    void enqueue_bulk(InputIt first, InputIt last) {
+        if constexpr (!std::sized_sentinel_for<InputIt, InputIt>) {
+            for (; first != last; ++first) {
+                enqueue(*first);
+            }
+        } else {
+            uint64_t remaining = static_cast<uint64_t>(last - first);
+            while (remaining > 0) {
+                uint64_t pos;
+                uint64_t n = 0;
+                auto reserved = [&]() {
+                    n = reserve(remaining, pos);
+                    return n > 0;
+                };
+                if (!reserved()) {
+                    not_full_.wait_until(reserved, WaitDeadline::max());
+                }
+                for (uint64_t i = 0; i < n; ++i, ++first) {
+                    publish(pos + i, *first);
+                }
+                remaining -= n;
+                not_empty_.notify();
+            }
+        }
+    }
+
+    // 取出的记录仍占用槽位，直到 commit_dequeued
+    bool dequeue(LogEntry& value) {
+        MmapLogSlot& s = slot(read_pos_);
+        if (s.seq.load(std::memory_order_acquire) != read_pos_ + 1) {
+            return false;
+        }
+        decode(s, value);
+        ++read_pos_;
+        return true;
+    }
+
+    // 单消费者，读指针不需要同步：连续解码已发布的记录，遇到还没写完的槽位就停下
+    template <typename OutputIt>
+    size_t dequeue_bulk(OutputIt out, size_t max) {
+        size_t n = 0;
+        while (n < max && slot(read_pos_).seq.load(std::memory_order_acquire) == read_pos_ + 1) {
+            LogEntry entry;
+            decode(slot(read_pos_), entry);
+            *out++ = std::move(entry);
+            ++read_pos_;
+            ++n;
+        }
+        return n;
+    }
+
+    bool try_dequeue(LogEntry& value) {
+        return dequeue(value);
+    }
+
+    // 阻塞直到取出一条记录
+    void wait_dequeue(LogEntry& value) {
+        if (!dequeue(value)) {
+            not_empty_.wait_until([&]() { return dequeue(value); }, WaitDeadline::max());
+        }
+    }
+
+    // 最多等待 timeout，超时返回 false
+    bool wait_dequeue_for(LogEntry& value, std::chrono::nanoseconds timeout) {
+        return dequeue(value) || not_empty_.wait_until([&]() { return dequeue(value); }, wait_deadline(timeout));
+    }
+
+    // 有生产者占了槽位但还没写完时也不算空，满足 ConcurrentQueue 对 empty 的约定
+    bool empty() const {
+        return header_->enqueue_pos.load(std::memory_order_acquire) == read_pos_;
+    }
+
+    // 已占用但还没取出的记录数
+    size_t size() const {
+        return static_cast<size_t>(header_->enqueue_pos.load(std::memory_order_acquire) - read_pos_);
+    }
+
+    // 已取出的记录都写进了日志文件：推进 flushed_pos 并归还槽位
+    void commit_dequeued() {
+        uint64_t flushed = header_->flushed_pos.load(std::memory_order_relaxed);
+        if (flushed == read_pos_) {
+            return;
+        }
+        // 先推进 flushed_pos 再归还槽位，中途崩溃也不会把已归还的槽位当作待恢复记录
+        header_->flushed_pos.store(read_pos_, std::memory_order_release);
+        for (uint64_t pos = flushed; pos < read_pos_; ++pos) {
+            slot(pos).seq.store(pos + capacity_, std::memory_order_release);
+        }
+        not_full_.notify();
+    }
+
+    const std::string& path() const {
+        return path_;
+    }
+
+    size_t capacity() const {
+        return capacity_;
+    }
+
+    // 构造时从文件中找回的未落盘记录数
+    size_t recovered() const {
+        return recovered_;
+    }
+
+    /*
+        只读地取出 path 中尚未写入日志文件的记录，按入队顺序追加到 out，返回条数。
+        不修改文件，供 cclog_recover 等离线工具在服务未启动时使用。
+    */
+    static size_t read_unflushed(const std::string& path, std::vector<LogEntry>& out) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to open log ring: " + path + ": " + std::strerror(errno));
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < MMAP_LOG_HEADER_SIZE) {
+            ::close(fd);
+            throw std::runtime_error("Not a log ring file: " + path);
+        }
+        size_t size = static_cast<size_t>(st.st_size);
+        void* base = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            throw std::runtime_error("Failed to map log ring: " + path + ": " + std::strerror(errno));
+        }
+
+        const auto* header = static_cast<const MmapLogHeader*>(base);
+        if (!valid_header(*header, size)) {
+            ::munmap(base, size);
+            throw std::runtime_error("Not a log ring file: " + path);
+        }
+        const auto* slots = reinterpret_cast<const MmapLogSlot*>(static_cast<const char*>(base) + MMAP_LOG_HEADER_SIZE);
+        uint64_t mask = header->capacity - 1;
+        uint64_t head = header->flushed_pos.load(std::memory_order_acquire);
+        size_t count = 0;
+        // 写入中途崩溃的槽位会留下空洞，跳过空洞继续找之后已发布的记录
+        for (uint64_t pos = head; pos < head + header->capacity; ++pos) {
+            const MmapLogSlot& s = slots[pos & mask];
+            if (s.seq.load(std::memory_order_acquire) == pos + 1) {
+                out.emplace_back();
+                decode(s, out.back());
+                ++count;
+            }
+        }
+        ::munmap(base, size);
+        return count;
+    }
+
+private:
+    MmapLogSlot& slot(uint64_t pos) const {
+        return slots_[pos & mask_];
+    }
+
+    // 从 enqueue_pos 起一次 CAS 占住最多 want 个连续的空槽位，返回个数；环满时返回 0
+    uint64_t reserve(uint64_t want, uint64_t& pos) {
+        pos = header_->enqueue_pos.load(std::memory_order_relaxed);
+        while (true) {
+            uint64_t seq = slot(pos).seq.load(std::memory_order_acquire);
+            int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+            if (diff < 0) {
+                return 0;
+            }
+            if (diff > 0) {
+                pos = header_->enqueue_pos.load(std::memory_order_relaxed);
+                continue;
+            }
+            uint64_t n = 1;
+            while (n < want && slot(pos + n).seq.load(std::memory_order_acquire) == pos + n) {
+                ++n;
+            }
+            if (header_->enqueue_pos.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed)) {
+                return n;
+            }
+        }
+    }
+
+    void publish(uint64_t pos, const LogEntry& value) {
+        MmapLogSlot& s = slot(pos);
+        encode(value, s);
+        s.seq.store(pos + 1, std::memory_order_release);
+    }
+
+    bool enqueue_until(const LogEntry& value, WaitDeadline deadline) {
+        uint64_t pos;
+        auto reserved = [&]() { return reserve(1, pos) > 0; };
+        // 环满：flush 线程还没有提交，等待它归还槽位
+        if (!reserved() && !not_full_.wait_until(reserved, deadline)) {
+            return false;
+        }
+        publish(pos, value);
+        not_empty_.notify();
+        return true;
+    }
+
+    static bool valid_header(const MmapLogHeader& header, size_t file_size) {
+        return header.magic == MMAP_LOG_MAGIC &&
+               header.version == MMAP_LOG_VERSION &&
+               header.slot_size == sizeof(MmapLogSlot) &&
+               header.capacity >= 2 && (header.capacity & (header.capacity - 1)) == 0 &&
+               file_size >= MMAP_LOG_HEADER_SIZE + header.capacity * sizeof(MmapLogSlot);
+    }
+
+    // 返回 true 表示新建的文件，需要初始化
+    bool map_file(size_t capacity) {
+        int fd = ::open(path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to open log ring: " + path_ + ": " + std::strerror(errno));
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Failed to stat log ring: " + path_);
+        }
+
+        bool fresh = st.st_size == 0;
+        if (fresh) {
+            map_size_ = MMAP_LOG_HEADER_SIZE + capacity * sizeof(MmapLogSlot);
+            if (::ftruncate(fd, static_cast<off_t>(map_size_)) != 0) {
+                ::close(fd);
+                throw std::runtime_error("Failed to size log ring: " + path_ + ": " + std::strerror(errno));
+            }
+        } else {
+            map_size_ = static_cast<size_t>(st.st_size);
+        }
+
+        void* base = map_size_ >= MMAP_LOG_HEADER_SIZE
+            ? ::mmap(nullptr, map_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+            : MAP_FAILED;
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            throw std::runtime_error("Failed to map log ring: " + path_);
+        }
+        base_ = base;
+        header_ = static_cast<MmapLogHeader*>(base);
+        slots_ = reinterpret_cast<MmapLogSlot*>(static_cast<char*>(base) + MMAP_LOG_HEADER_SIZE);
+
+        if (!fresh && header_->magic == 0 &&
+            map_size_ == MMAP_LOG_HEADER_SIZE + capacity * sizeof(MmapLogSlot)) {
+            fresh = true;   // 上次初始化没有完成
+        }
+        if (!fresh && !valid_header(*header_, map_size_)) {
+            // 不认识的文件不覆盖
+            ::munmap(base_, map_size_);
+            base_ = nullptr;
+            throw std::runtime_error("Existing file is not a log ring: " + path_);
+        }
+        capacity_ = fresh ? capacity : header_->capacity;
+        mask_ = capacity_ - 1;
+        return fresh;
+    }
+
+    void format() {
+        for (uint64_t i = 0; i < capacity_; ++i) {
+            slots_[i].seq.store(i, std::memory_order_relaxed);
+        }
+        header_->enqueue_pos.store(0, std::memory_order_relaxed);
+        header_->flushed_pos.store(0, std::memory_order_relaxed);
+        header_->version = MMAP_LOG_VERSION;
+        header_->slot_size = sizeof(MmapLogSlot);
+        header_->capacity = capacity_;
+        // magic 最后写入，初始化中途崩溃的文件不会被当成有效的环
+        std::atomic_thread_fence(std::memory_order_release);
+        header_->magic = MMAP_LOG_MAGIC;
+    }
+
+    /*
+        从上次进程留下的状态继续。[flushed_pos, 第一个空洞) 中连续的记录原地保留，读指针回到
+        flushed_pos 让 flush 线程补写；空洞之后零散的记录先读出来、清空槽位，再重新入队。
+    */
+    void resume() {
+        uint64_t head = header_->flushed_pos.load(std::memory_order_acquire);
+        uint64_t end = head;
+        while (end - head < capacity_ && slot(end).seq.load(std::memory_order_acquire) == end + 1) {
+            ++end;
+        }
+
+        std::vector<LogEntry> stray;
+        for (uint64_t pos = end; pos < head + capacity_; ++pos) {
+            MmapLogSlot& s = slot(pos);
+            if (s.seq.load(std::memory_order_acquire) == pos + 1) {
+                stray.emplace_back();
+                decode(s, stray.back());
+            }
+            s.seq.store(pos, std::memory_order_release);
+        }
+
+        header_->enqueue_pos.store(end, std::memory_order_release);
+        read_pos_ = head;
+        recovered_ = static_cast<size_t>(end - head) + stray.size();
+        enqueue_bulk(stray.begin(), stray.end());
+    }
+
+    static void encode(const LogEntry& e, MmapLogSlot& s) {
+        MmapLogRecord& r = s.record;
+        // TSC 读数离开本进程就没有意义，环文件里保存墙上时间
+        r.timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(TscClock::to_system(e.timestamp).time_since_epoch()).count();
+        r.duration_ms = e.duration_ms;
+        std::memcpy(r.uuid, e.uuid.bytes.data(), sizeof(r.uuid));
+        std::memcpy(r.client_addr, e.client.addr.data(), sizeof(r.client_addr));
+        std::memcpy(r.server_addr, e.server.addr.data(), sizeof(r.server_addr));
+        r.client_port = e.client.port;
+        r.server_port = e.server.port;
+        r.client_family = static_cast<uint8_t>(e.client.family);
+        r.server_family = static_cast<uint8_t>(e.server.family);
+        r.level = static_cast<uint8_t>(e.level);
+        r.log_type = static_cast<uint8_t>(e.log_type);
+        r.operation = static_cast<uint8_t>(e.operation);
+        r.status_code = static_cast<int32_t>(e.status_code);
+        r.sample_ppm = e.sample_ppm;
+
+        std::string_view params = e.params();
+        std::string_view error = e.error_message();
+        std::memcpy(s.text, params.data(), params.size());
+        std::memcpy(s.text + params.size(), error.data(), error.size());
+        r.params_len = static_cast<uint16_t>(params.size());
+        r.error_len = static_cast<uint16_t>(error.size());
+    }
+
+    static void decode(const MmapLogSlot& s, LogEntry& e) {
+        const MmapLogRecord& r = s.record;
+        e.timestamp = TscClock::from_system(std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(r.timestamp_ns))));
+        e.duration_ms = LogEntry::clamp_ms(r.duration_ms);
+        e.uuid = LogUuid::from_bytes(r.uuid);
+        std::memcpy(e.client.addr.data(), r.client_addr, sizeof(r.client_addr));
+        std::memcpy(e.server.addr.data(), r.server_addr, sizeof(r.server_addr));
+        e.client.port = r.client_port;
+        e.server.port = r.server_port;
+        e.client.family = static_cast<NetAddr::Family>(r.client_family);
+        e.server.family = static_cast<NetAddr::Family>(r.server_family);
+        e.level = static_cast<Level>(r.level);
+        e.log_type = static_cast<LogType>(r.log_type);
+        e.operation = static_cast<OperationType>(r.operation);
+        e.status_code = static_cast<grpc::StatusCode>(r.status_code);
+        e.sample_ppm = r.sample_ppm;
+
+        // 文件内容不可信，长度按槽位容量截断
+        size_t params_len = std::min<size_t>(r.params_len, sizeof(s.text));
+        size_t error_len = std::min<size_t>(r.error_len, sizeof(s.text) - params_len);
+        e.text.assign(std::string_view(s.text, params_len), std::string_view(s.text + params_len, error_len));
+    }
+
+    std::string path_;
+    void* base_ = nullptr;
+    size_t map_size_ = 0;
+    MmapLogHeader* header_ = nullptr;
+    MmapLogSlot* slots_ = nullptr;
+    uint64_t capacity_ = 0;
+    uint64_t mask_ = 0;
+    uint64_t read_pos_ = 0;     // 仅消费者访问
+    size_t recovered_ = 0;
+    [[no_unique_address]] Wait not_empty_;     // flush 线程等待新记录
+    [[no_unique_address]] Wait not_full_;      // 生产者等待 commit_dequeued 归还槽位
+};
+
+using MmapLogQueue = BasicMmapLogQueue<>;
+
+static_assert(BlockingQueue<MmapLogQueue>);
+static_assert(std::is_constructible_v<MmapLogQueue, const char (&)[2], QueueShard>);  // AsyncLogger 按此传入分片
@@ -0,0 +1,154 @@
+/*
+    zstd 可随机访问格式 (Zstandard Seekable Format) 的最小实现。
+
+    文件由若干相互独立的 zstd 帧组成，每帧对应原文件中固定大小 (ZSTD_SEEKABLE_FRAME_SIZE) 的一段，
+    末尾附加一个 skippable 帧保存寻址表：
+        [帧 0][帧 1]...[帧 n-1][Skippable 帧: 每帧 (压缩大小, 原始大小) + 帧数 + 描述符 + 魔数]
+    标准 zstd 工具会忽略 skippable 帧，因此压缩结果也能直接用 `zstd -d` 解开。
+*/
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <zstd.h>
+
+static constexpr size_t ZSTD_SEEKABLE_FRAME_SIZE = 1024 * 1024;   // 每帧压缩前 1MB
+static constexpr int ZSTD_SEEKABLE_LEVEL = 3;
+static constexpr uint32_t ZSTD_SEEKABLE_SKIPPABLE_MAGIC = 0x184D2A5E;
+static constexpr uint32_t ZSTD_SEEKABLE_MAGIC = 0x8F92EAB1;
+static constexpr size_t ZSTD_SEEKABLE_FOOTER_SIZE = 9;
+
+
+struct SeekableFrame {
+    uint64_t compressed_offset;
+    uint64_t decompressed_offset;
+    uint32_t compressed_size;
+    uint32_t decompressed_size;
+};
+
+class ZstdSeekable {
+public:
+    static void put_le32(std::string& out, uint32_t v) {
+        for (int i = 0; i < 4; ++i) {
+            out.push_back(static_cast<char>((v >> (8 * i)) & 0xff));
+        }
+    }
+
+    static uint32_t get_le32(const unsigned char* p) {
+        return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+               (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+
+    /*
+        把 in_path 压缩成 out_path。before_chunk(n) 在读入每段 n 字节前调用，供调用方做限速；
+        返回 false 时放弃压缩并删除半成品。失败抛出 std::runtime_error。
+    */
+    static bool compress_file(const std::string& in_path,
+                              const std::string& out_path,
+                              const std::function<bool(size_t)>& before_chunk = {}) {
+        std::ifstream ifs(in_path, std::ios::binary);
+        if (!ifs.is_open()) {
+            throw std::runtime_error("Failed to open file for compression: " + in_path);
+        }
+        std::ofstream ofs(out_path, std::ios::binary | std::ios::trunc);
+        if (!ofs.is_open()) {
+            throw std::runtime_error("Failed to create compressed file: " + out_path);
+        }
+
+        ZSTD_CCtx* cctx = ZSTD_createCCtx();
+        std::vector<char> in(ZSTD_SEEKABLE_FRAME_SIZE);
+        std::vector<char> out(ZSTD_compressBound(ZSTD_SEEKABLE_FRAME_SIZE));
+        std::string seek_table;
+        uint32_t frames = 0;
+
+        while (true) {
+            if (before_chunk && !before_chunk(in.size())) {
+                ZSTD_freeCCtx(cctx);
+                ofs.close();
+                std::remove(out_path.c_str());
+                return false;
+            }
+            ifs.read(in.data(), static_cast<std::streamsize>(in.size()));
+            size_t n = static_cast<size_t>(ifs.gcount());
+            if (n == 0) {
+                break;
+            }
+            size_t c = ZSTD_compressCCtx(cctx, out.data(), out.size(), in.data(), n, ZSTD_SEEKABLE_LEVEL);
+            if (ZSTD_isError(c)) {
+                ZSTD_freeCCtx(cctx);
+                throw std::runtime_error(std::string("zstd compression failed: ") + ZSTD_getErrorName(c));
+            }
+            ofs.write(out.data(), static_cast<std::streamsize>(c));
+            put_le32(seek_table, static_cast<uint32_t>(c));
+            put_le32(seek_table, static_cast<uint32_t>(n));
+            ++frames;
+        }
+        ZSTD_freeCCtx(cctx);
+
+        std::string skippable;
+        put_le32(skippable, ZSTD_SEEKABLE_SKIPPABLE_MAGIC);
+        put_le32(skippable, static_cast<uint32_t>(seek_table.size() + ZSTD_SEEKABLE_FOOTER_SIZE));
+        skippable += seek_table;
+        put_le32(skippable, frames);
+        skippable.push_back(0);     // 描述符：不带校验和
+        put_le32(skippable, ZSTD_SEEKABLE_MAGIC);
+        ofs.write(skippable.data(), static_cast<std::streamsize>(skippable.size()));
+        ofs.flush();
+        if (!ofs) {
+            throw std::runtime_error("Failed to write compressed file: " + out_path);
+        }
+        return true;
+    }
+
+    /*
+        读取文件末尾的寻址表。不是 seekable 格式（例如普通 zstd 压缩的文件）时返回 false。
+    */
+    static bool read_seek_table(std::ifstream& ifs, std::vector<SeekableFrame>& frames) {
+        ifs.clear();
+        ifs.seekg(0, std::ios::end);
+        std::streamoff file_size = ifs.tellg();
+        if (file_size < static_cast<std::streamoff>(ZSTD_SEEKABLE_FOOTER_SIZE + 8)) {
+            return false;
+        }
+
+        unsigned char footer[ZSTD_SEEKABLE_FOOTER_SIZE];
+        ifs.seekg(file_size - static_cast<std::streamoff>(ZSTD_SEEKABLE_FOOTER_SIZE));
+        ifs.read(reinterpret_cast<char*>(footer), sizeof(footer));
+        if (!ifs || get_le32(footer + 5) != ZSTD_SEEKABLE_MAGIC) {
+            return false;
+        }
+        uint32_t count = get_le32(footer);
+        bool has_checksum = (footer[4] & 0x80) != 0;
+        size_t entry_size = has_checksum ? 12 : 8;
+        std::streamoff table_size = static_cast<std::streamoff>(count * entry_size + ZSTD_SEEKABLE_FOOTER_SIZE);
+        std::streamoff frame_start = file_size - table_size - 8;
+        if (frame_start < 0) {
+            return false;
+        }
+
+        std::vector<unsigned char> table(static_cast<size_t>(table_size) + 8);
+        ifs.seekg(frame_start);
+        ifs.read(reinterpret_cast<char*>(table.data()), static_cast<std::streamsize>(table.size()));
+        if (!ifs || get_le32(table.data()) != ZSTD_SEEKABLE_SKIPPABLE_MAGIC) {
+            return false;
+        }
+
+        frames.clear();
+        frames.reserve(count);
+        uint64_t c_off = 0;
+        uint64_t d_off = 0;
+        for (uint32_t i = 0; i < count; ++i) {
+            const unsigned char* e = table.data() + 8 + i * entry_size;
+            SeekableFrame f{c_off, d_off, get_le32(e), get_le32(e + 4)};
+            frames.push_back(f);
+            c_off += f.compressed_size;
+            d_off += f.decompressed_size;
+        }
+        return true;
+    }
+};
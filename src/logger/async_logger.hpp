@@ -11,329 +11,395 @@
 #include <iomanip>
 #include <filesystem>
 #include <format>
+#include <memory>
+#include <unordered_map>
+#include <algorithm>
+#include <iterator>
 #include <grpcpp/grpcpp.h>
 // #define DEBUG
 #ifdef DEBUG
 #include <iostream>
 #endif
 
+#include "LogEntry.hpp"
+#include "LogFormatter.hpp"
+#include "LogSink.hpp"
+#include "LogCompressor.hpp"
+#include "LogDurability.hpp"
+#include "LoggerMetrics.hpp"
 #include "tools/BaseQueue.hpp"
 #include "tools/EBRQueue.hpp"
+#include "tools/Parker.hpp"
 
 #define DEFAULT_LOG_PATH "/home/olivercai/personal/CCcloud/logs" // 默认日志文件路径
 static constexpr int LOGENTRY_BATCH_THRESHOLD = 256; // 批量写入日志的阈值
-static constexpr int LOGENTRY_BATCH_TIMEOUT_MS = 256; // 批量写入日志的超时时间
-static constexpr int MAX_LOG_FILE_SIZE = 32 * 1024 * 1024; // 每个日志文件最大大小 32MB
-
-
-enum class Level {
-    INFO,
-    WARN,
-    ERROR
-};
-
-enum class LogType {
-    PREPARE,
-    COMMIT,
-    ABORT
-};
-
-enum class OperationType {
-    UPLOAD,
-    DOWNLOAD,
-    DELETE
+static constexpr size_t LOGGER_MAX_LATENCY_US = 1000; // 日志从入队到写出的最大延迟（攒批窗口）
+static constexpr size_t LOGGER_SPIN_ITERATIONS = 4096; // flush 线程挂起前的自旋次数
+static constexpr int LOGGER_DRAIN_RETRIES = 64; // 取批时遇到生产者占了位置还没写完，最多重试这么多次
+
+
+struct LoggerOptions {
+    std::string file_path = DEFAULT_LOG_PATH;
+    size_t flush_threads = 1;   // 分片数：每个分片独占一个队列、一个 flush 线程和一组分片文件
+    bool file_sink = true;      // 为 false 时只写入通过 add_sink 挂载的 sink
+    bool compress_rotated = false;  // 滚动出去的文件在后台压缩为 .txt.zst
+    size_t compress_bytes_per_sec = LOG_COMPRESS_BYTES_PER_SEC;
+    size_t max_latency_us = LOGGER_MAX_LATENCY_US;  // 挂起的 flush 线程被唤醒后再等这么久攒一批，0 表示立即写出
+    size_t spin_iterations = LOGGER_SPIN_ITERATIONS;
+    bool index_files = true;    // 为每个日志文件维护 .idx 稀疏索引，供 cclog_query 使用
 };
 
-struct LogEntry {
-    std::chrono::system_clock::time_point timestamp;
-    std::string uuid;
-    Level level;    // INFO, WARN, ERROR
-    std::string client_ip;
-    std::string server_ip;
-    uint32_t client_port;
-    uint32_t server_port;
-    OperationType operation;           // Upload / Download / Delete
-    std::string params;              // filename=abc.jpg size=2048
-    LogType log_type;
-    grpc::StatusCode status_code;
-    std::string error_message;
-    long long duration_ms;
-
-    LogEntry()
-    : timestamp(std::chrono::system_clock::now()),
-      level(Level::INFO),
-      client_port(0),
-      server_port(0),
-      operation(OperationType::UPLOAD),
-      log_type(LogType::PREPARE),
-      status_code(grpc::StatusCode::OK),
-      duration_ms(0) {}
-
-    LogEntry(Level lvl,
-            const std::string& uuid,
-            const std::string& cip,
-            const std::string& sip,
-            uint32_t cport,
-            uint32_t sport,
-            OperationType op,
-            const std::string& param,
-            LogType ltype,
-            grpc::StatusCode code,
-            const std::string& errmsg,
-            long long dur)
-        : timestamp(std::chrono::system_clock::now()),
-          uuid(uuid),
-          level(lvl),
-          client_ip(cip),
-          server_ip(sip),
-          client_port(cport),
-          server_port(sport),
-          operation(op),
-          params(param),
-          log_type(ltype),
-          status_code(code),
-          error_message(errmsg),
-          duration_ms(dur) {}
-
-    LogEntry(const LogEntry&) = default;
-    LogEntry(LogEntry&&) = default;
-    LogEntry& operator=(const LogEntry&) = default;
-    LogEntry& operator=(LogEntry&&) = default;
-};
-
-template <typename T>
-concept HasValueType = requires {
-    typename T::value_type;
-};
+// 线程序号，生产者据此固定落在某个分片上，同一线程的日志保持有序
+inline size_t thread_ordinal() {
+    static std::atomic<size_t> next_ordinal{0};
+    static thread_local size_t ordinal = next_ordinal.fetch_add(1, std::memory_order_relaxed);
+    return ordinal;
+}
 
-template <typename T>
-concept DerivedFromBaseQueue = HasValueType<T> && std::is_base_of_v<BaseQueue<typename T::value_type>, T>;
-
-template <DerivedFromBaseQueue Q = MPMCQueue<LogEntry>>
+// Q 按静态类型调用（见 BaseQueue.hpp 中的 ConcurrentQueue），append 里的入队可以完全内联
+template <ConcurrentQueue Q = MPMCQueue<LogEntry>>
 class AsyncLogger {
 public:
+    // 默认实例，直接写入 file_path 目录
     template <typename... Args>
     static AsyncLogger& instance(const std::string& file_path = DEFAULT_LOG_PATH, Args&&... args) {
-        static AsyncLogger logger(file_path, std::forward<Args>(args)...);
+        static AsyncLogger logger(LoggerOptions{file_path, 1, true}, std::forward<Args>(args)...);
         return logger;
     }
 
+    // 具名实例：拥有独立的队列、flush 线程和日志目录 (options.file_path/name)，
+    // 用于把审计日志与调试日志隔离。同名的后续调用直接返回已有实例，忽略其余参数。
+    template <typename... Args>
+    static AsyncLogger& named(const std::string& name, const LoggerOptions& options = {}, Args&&... args) {
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        auto it = reg.loggers.find(name);
+        if (it == reg.loggers.end()) {
+            LoggerOptions opts = options;
+            opts.file_path = (std::filesystem::path(options.file_path) / name).string();
+            it = reg.loggers.emplace(name, std::unique_ptr<AsyncLogger>(
+                new AsyncLogger(opts, std::forward<Args>(args)...))).first;
+        }
+        return *it->second;
+    }
+
     AsyncLogger(const AsyncLogger&) = delete;
     AsyncLogger& operator=(const AsyncLogger&) = delete;
     AsyncLogger(AsyncLogger&&) = delete;
     AsyncLogger& operator=(AsyncLogger&&) = delete;
 
+    ~AsyncLogger() {
+        stop();
+    }
+
     // 提交日志
     void append(LogEntry&& entry) {
-        log_queue_.enqueue(std::move(entry));
-        if (++unflushed_count_ >= LOGENTRY_BATCH_THRESHOLD) {
-            unflushed_count_ = 0;
-            cv_.notify_one();
+        size_t ordinal = thread_ordinal();
+        Shard& shard = *shards_[ordinal % shards_.size()];
+        shard.durability.on_append(ordinal / shards_.size());
+        shard.queue->enqueue(std::move(entry));
+        metrics_.on_enqueue(ordinal);
+        shard.parker.notify();  // flush 线程没有挂起时只是一次 fence 和读取
+    }
+
+    /*
+        提交日志并返回完成句柄：durability 为 WRITTEN 时在所在批次写入日志文件后完成，
+        为 SYNCED 时还要等 fdatasync。并发的 SYNCED 请求共享同一次 fdatasync。
+        写入或同步失败、或者没有日志文件 (file_sink = false) 时以失败结束。
+    */
+    LogCompletion append(LogEntry&& entry, Durability durability) {
+        size_t ordinal = thread_ordinal();
+        Shard& shard = *shards_[ordinal % shards_.size()];
+        uint64_t since = shard.durability.current_pass();
+        shard.durability.on_append(ordinal / shards_.size());
+        shard.queue->enqueue(std::move(entry));
+        metrics_.on_enqueue(ordinal);
+        if (durability == Durability::NONE) {
+            shard.parker.notify();
+            return {};
+        }
+        uint64_t target = shard.durability.request(durability);
+        shard.parker.notify();
+        return LogCompletion(&shard.durability, since, target, durability);
+    }
+
+    // 同上，有结论时在 flush 线程上调用 on_done(是否成功)，应当很快返回
+    void append(LogEntry&& entry, Durability durability, std::function<void(bool)> on_done) {
+        size_t ordinal = thread_ordinal();
+        Shard& shard = *shards_[ordinal % shards_.size()];
+        uint64_t since = shard.durability.current_pass();
+        shard.durability.on_append(ordinal / shards_.size());
+        shard.queue->enqueue(std::move(entry));
+        metrics_.on_enqueue(ordinal);
+        if (durability == Durability::NONE) {
+            shard.parker.notify();
+            on_done(true);
+            return;
         }
+        uint64_t target = shard.durability.request(durability);
+        shard.durability.on_complete(since, target, durability, std::move(on_done));
+        shard.parker.notify();
     }
 
-    // 启动后台线程
+    // 记录一条应用自定义事件，事件类型需要特化 LogEventSchema
+    template <typename E>
+    void log_event(const E& ev, Level level = Level::INFO) {
+        append(make_log_event(ev, level));
+    }
+
+    // 启动后台线程，每个分片一个
     void start() {
         running_ = true;
-        log_thread_ = std::thread(&AsyncLogger::background_flush, this);
+        for (size_t i = 0; i < shards_.size(); ++i) {
+            shards_[i]->thread = std::thread(&AsyncLogger::background_flush, this, i);
+        }
     }
 
     // 停止后台线程，flush所有日志
     void stop() {
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            running_ = false;
+        running_ = false;
+        for (auto& shard : shards_) {
+            shard->parker.interrupt();
         }
-        cv_.notify_one();
-        if (log_thread_.joinable()) {
-            log_thread_.join();
+        for (auto& shard : shards_) {
+            if (shard->thread.joinable()) {
+                shard->thread.join();
+            }
+        }
+        for (const auto& observer : *current_observers()) {
+            observer->flush();
         }
     }
 
     void set_filepath(const std::string& file_path) {
         std::lock_guard<std::mutex> lock(mutex_);
         file_path_ = file_path;
+        for (auto& shard : shards_) {
+            if (shard->file_sink) {
+                shard->file_sink->set_directory(file_path);
+            }
+        }
+    }
+
+    // 挂载额外的 sink，所有分片共享。isolated 为 true 时放到独立线程上执行，
+    // 写入慢或阻塞的 sink 只会丢弃自己的数据。
+    void add_sink(std::shared_ptr<LogSink> sink, bool isolated = true) {
+        if (isolated) {
+            sink = std::make_shared<IsolatedSink>(std::move(sink));
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto sinks = std::make_shared<SinkList>(*extra_sinks_);
+        sinks->push_back(std::move(sink));
+        extra_sinks_ = std::move(sinks);
+    }
+
+    // 挂载以 LogEntry 为单位的观察者（如 LogAggregator），在各分片的 flush 线程上调用
+    void add_observer(std::shared_ptr<LogObserver> observer) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto observers = std::make_shared<ObserverList>(*observers_);
+        observers->push_back(std::move(observer));
+        observers_ = std::move(observers);
+    }
+
+    size_t shard_count() const {
+        return shards_.size();
+    }
+
+    // 自身运行指标，见 LoggerMetrics
+    LoggerStats stats() {
+        return metrics_.snapshot();
     }
 
 private:
+    using SinkList = std::vector<std::shared_ptr<LogSink>>;
+    using ObserverList = std::vector<std::shared_ptr<LogObserver>>;
+
+    struct Shard {
+        std::unique_ptr<Q> queue;
+        std::shared_ptr<FileSink> file_sink;
+        Parker parker;
+        DurabilityTracker durability;
+        std::thread thread;
+    };
+
+    struct Registry {
+        std::mutex mutex;
+        std::unordered_map<std::string, std::unique_ptr<AsyncLogger>> loggers;
+    };
+
+    static Registry& registry() {
+        static Registry reg;
+        return reg;
+    }
+
     template <typename... Args>
-    AsyncLogger(const std::string& file_path, Args&&... args)
-        : file_path_(file_path), running_(false), current_file_index_(1), log_queue_(Q::instance(std::forward<Args>(args)...)) {
+    AsyncLogger(const LoggerOptions& options, Args&&... args)
+        : file_path_(options.file_path),
+          max_latency_(std::chrono::microseconds(options.max_latency_us)),
+          spin_iterations_(options.spin_iterations),
+          running_(false),
+          metrics_(options.file_path) {
         namespace fs = std::filesystem;
-        if (!fs::exists(file_path) || !fs::is_directory(file_path)) {
-            if (!fs::create_directories(file_path)) {
-                throw std::runtime_error("Failed to create log root directory: " + file_path);
+        if (!fs::exists(file_path_) || !fs::is_directory(file_path_)) {
+            if (!fs::create_directories(file_path_)) {
+                throw std::runtime_error("Failed to create log root directory: " + file_path_);
             }
         }
-            start();
+        if (options.file_sink && options.compress_rotated) {
+            compressor_ = std::make_unique<LogCompressor>(options.compress_bytes_per_sec);
+            compressor_->submit_stale(file_path_, FileSink::today());
         }
-
-    ~AsyncLogger() {
-        stop();
-    }
-
-    std::string get_current_log_file_path() const {
-        namespace fs = std::filesystem;
-        auto now = std::chrono::system_clock::now();
-        std::time_t t = std::chrono::system_clock::to_time_t(now);
-        std::tm tm_time;
-#if defined(_WIN32) || defined(_WIN64)
-        localtime_s(&tm_time, &t);
-#else
-        localtime_r(&t, &tm_time);
-#endif
-        std::stringstream ss;
-        ss << std::put_time(&tm_time, "%Y-%m-%d");
-        fs::path date_dir = fs::path(file_path_) / ss.str();
-        if (!fs::exists(date_dir)) {
-            if (!fs::create_directories(date_dir)) {
-                throw std::runtime_error("Failed to create date directory: " + date_dir.string());
+        size_t shard_count = std::max<size_t>(1, options.flush_threads);
+        for (size_t i = 0; i < shard_count; ++i) {
+            auto shard = std::make_unique<Shard>();
+            if constexpr (std::is_constructible_v<Q, Args&..., QueueShard>) {
+                shard->queue = std::make_unique<Q>(args..., QueueShard{i, shard_count});
+            } else {
+                shard->queue = std::make_unique<Q>(args...);
             }
-            return (date_dir / "1.txt").string();
-        } else {
-            std::error_code ec;
-            uintmax_t f_size = fs::file_size(date_dir / (std::to_string(current_file_index_) + ".txt"), ec);
-#ifdef DEBUG
-            std::cout << "Current file index: " << current_file_index_ << ", File size: " << f_size << std::endl;
-#endif
-            if (ec) {
-                // throw std::runtime_error("Failed to get file size: " + (date_dir / (std::to_string(current_file_index_) + ".txt")).string());
-                goto create_file;
+            shard->durability.on_preloaded(shard->queue->size());   // 恢复出来的记录排在所有新记录前面
+            if (options.file_sink) {
+                // 单分片沿用 <n>.txt，多分片时为 shard<k>-<n>.txt
+                std::string prefix = shard_count == 1 ? "" : "shard" + std::to_string(i) + "-";
+                shard->file_sink = std::make_shared<FileSink>(file_path_, prefix);
+                if (options.index_files) {
+                    shard->file_sink->enable_index();
+                }
+                if (compressor_) {
+                    shard->file_sink->set_rotate_callback(
+                        [this](const std::string& path) { compressor_->submit(path); });
+                }
             }
-
-            if (f_size >= MAX_LOG_FILE_SIZE) {
-                ++current_file_index_;
-create_file:
-                std::ofstream ofs((date_dir / (std::to_string(current_file_index_) + ".txt")).string(), std::ios::app);
-                if (!ofs.is_open()) {
-                    throw std::runtime_error("Failed to create log file: " + (date_dir / (std::to_string(current_file_index_) + ".txt")).string());
+            shards_.push_back(std::move(shard));
+        }
+        metrics_.set_sink_counters([this](uint64_t& rotations, uint64_t& dropped) {
+            for (const auto& shard : shards_) {
+                if (shard->file_sink) {
+                    rotations += shard->file_sink->rotations();
+                    dropped += shard->file_sink->dropped();
                 }
-                ofs.close();
-                return (date_dir / (std::to_string(current_file_index_) + ".txt")).string();
             }
+            for (const auto& sink : *current_sinks()) {
+                dropped += sink->dropped();
+            }
+        });
+        start();
+    }
 
-            return (date_dir / (std::to_string(current_file_index_) + ".txt")).string();
-        }
+    std::shared_ptr<const SinkList> current_sinks() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return extra_sinks_;
     }
 
-    void background_flush() {
-        std::ofstream ofs;
+    std::shared_ptr<const ObserverList> current_observers() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return observers_;
+    }
 
-        auto open_log_file = [&ofs, this]() {
-            std::string current_log_file = get_current_log_file_path();
-            ofs.open(current_log_file, std::ios::app);
-            if (!ofs.is_open()) {
-                throw std::runtime_error("Failed to open log file: " + current_log_file);
-            }
+    void background_flush(size_t shard_index) {
+        Shard& shard = *shards_[shard_index];
+        Q& log_queue = *shard.queue;
+
+        DurabilityTracker& durability = shard.durability;
+        auto ready = [this, &log_queue, &durability]() {
+            return !running_ || !log_queue.empty() || durability.pending();
         };
 
+        constexpr size_t batch = LOGENTRY_BATCH_THRESHOLD;
+        std::vector<LogEntry> entries;  // 各批复用，不随批次重新分配
+        entries.reserve(batch);
+        uint64_t pass = 0;  // 0 表示当前没有进行中的一轮
         while (true) {
-            std::unique_lock<std::mutex> lock(mutex_);
-            cv_.wait_for(
-                lock, 
-                std::chrono::milliseconds(LOGENTRY_BATCH_TIMEOUT_MS),    // 超时后即便没满足批量更新的日志数量也会落盘
-                [this]() { return !running_ || !log_queue_.empty(); }
-            );
-            lock.unlock();
-
-            open_log_file();
-            std::vector<LogEntry> entries;
-            int cnt = 0;
-            while (!log_queue_.empty() && cnt < LOGENTRY_BATCH_THRESHOLD) {
-                LogEntry entry;
-                if (log_queue_.dequeue(entry)) {
-                    entries.emplace_back(std::move(entry));
-                    cnt++;
+            // 高负载时队列一直非空，生产者和 flush 线程之间没有任何系统调用；
+            // 空闲时先自旋，再挂起直到第一条日志到来，随后最多再等 max_latency_ 攒一批。
+            // 有持久化等待者时不攒批，尽快完成这一轮
+            if (!shard.parker.spin(spin_iterations_, ready)) {
+                shard.parker.park(ready);
+                if (max_latency_.count() > 0 && running_ && !durability.pending()) {
+                    shard.parker.nap(max_latency_);
+                }
+            }
+
+            if (pass == 0) {
+                pass = durability.begin_pass();
+            }
+            entries.clear();
+            // 按批取出，队列一次占住一段位置，而不是每条记录同步一次。
+            // 生产者占了位置还没写完时 empty() 为 false（如 LockFreeMPMCQueue），生产者被抢占时不能一直等：
+            // 重试有限次后先写出已取到的，drained 为 false，这一轮由 pass_covered() 判断或留到下一批
+            int retries = 0;
+            while (entries.size() < batch && !log_queue.empty()) {
+                if (log_queue.dequeue_bulk(std::back_inserter(entries), batch - entries.size()) == 0) {
+                    if (++retries > LOGGER_DRAIN_RETRIES) {
+                        if (entries.empty()) {
+                            std::this_thread::yield();  // 一条也没取到：让出 CPU，让被抢占的生产者写完
+                        }
+                        break;
+                    }
+                    cpu_relax();
                 }
             }
+            bool drained = log_queue.empty();
 #ifdef DEBUG
-            std::cout << "Flushing " << entries.size() << " log entries." << std::endl;
+            std::cout << "Shard " << shard_index << " flushing " << entries.size() << " log entries." << std::endl;
 #endif
-            ofs << format_log_entry(entries);
-            ofs.flush();
-            ofs.close();
-            if (!running_ && log_queue_.empty()) {
-                break;
+            if (!entries.empty()) {
+                TscClock::maybe_reanchor();
+                auto format_start = TscClock::now();
+                std::string formatted = LogFormatter::format(entries);
+                auto write_start = TscClock::now();
+                // 没有写进日志文件的一批，等待它的持久化请求以失败结束
+                if (!shard.file_sink || !shard.file_sink->write(formatted)) {
+                    durability.fail(pass, Durability::WRITTEN);
+                }
+                for (const auto& sink : *current_sinks()) {
+                    sink->write(formatted);
+                }
+                metrics_.on_batch(entries.size(), formatted.size(), TscClock::elapsed(format_start, write_start),
+                                  TscClock::elapsed(write_start));
+                for (const auto& observer : *current_observers()) {
+                    observer->observe(entries);
+                }
+                // 需要确认的队列（如 MmapLogQueue）在整批写出后才释放这些记录
+                if constexpr (requires(Q& q) { q.commit_dequeued(); }) {
+                    log_queue.commit_dequeued();
+                }
+                durability.on_written(entries.size());
             }
-        }
-    }
-
-    std::string format_log_entry(const std::vector<LogEntry>& entries) {  //支持到微秒
-        std::ostringstream oss;
-
-    for (const auto& entry : entries) {
-        auto in_time_t = std::chrono::system_clock::to_time_t(entry.timestamp);
-        auto micros = std::chrono::duration_cast<std::chrono::microseconds>(
-            entry.timestamp.time_since_epoch()).count() % 1000000;
-
-        std::tm buf;
-    #if defined(_WIN32) || defined(_WIN64)
-        localtime_s(&buf, &in_time_t);
-    #else
-        localtime_r(&in_time_t, &buf);
-    #endif
-
-        oss << "[" << std::put_time(&buf, "%Y-%m-%d_%H:%M:%S");
-        oss << "." << std::setfill('0') << std::setw(6) << micros << "]";
-        oss << " [" << entry.uuid << "]";
-        oss << " [" << loglevel_to_string(entry.level) << "]";
-        oss << " [" << logtype_to_string(entry.log_type) << "]";
-        oss << " [" << operation_to_string(entry.operation) << "]";
-
-        oss << " client=" << entry.client_ip << ":" << entry.client_port;
-        oss << " server=" << entry.server_ip << ":" << entry.server_port;
-
-        if (entry.log_type == LogType::PREPARE) {
-            oss << " params=" << entry.params;
-        } else if (entry.log_type == LogType::COMMIT || entry.log_type == LogType::ABORT) {
-            oss << " result=" << (entry.status_code == grpc::StatusCode::OK ? "OK" : "FAILED");
-            oss << " code=" << static_cast<int>(entry.status_code);
-            if (!entry.error_message.empty()) {
-                oss << " error=" << entry.error_message;
+            // 本轮开始前入队的记录都已写出：写出的条数达到快照，或者队列已空
+            if (drained || durability.pass_covered()) {
+                bool sync = durability.sync_wanted();
+                if (sync) {
+                    sync = shard.file_sink && shard.file_sink->sync();
+                    if (shard.file_sink) {
+                        metrics_.on_sync();
+                    }
+                    if (!sync) {
+                        durability.fail(pass, Durability::SYNCED);
+                    }
+                }
+                durability.complete(pass, sync);
+                pass = 0;
+            }
+            if (!running_ && log_queue.empty()) {
+                break;
             }
-            oss << " time=" << entry.duration_ms << "ms";
-        }
-
-        oss << "\n";
-    }
-
-    return oss.str();
-    }
-
-    std::string loglevel_to_string(const Level& level) const {
-        switch (level) {
-            case Level::INFO: return "INFO";
-            case Level::WARN: return "WARN";
-            case Level::ERROR: return "ERROR";
-            default: return "UNKNOWN";
-        }
-    }
-
-    std::string logtype_to_string(const LogType& type) const {
-        switch (type) {
-            case LogType::PREPARE: return "PREPARE";
-            case LogType::COMMIT: return "COMMIT";
-            case LogType::ABORT: return "ABORT";
-            default: return "UNKNOWN";
         }
-    }
-
-    std::string operation_to_string(OperationType op) {
-        switch (op) {
-            case OperationType::UPLOAD: return "UPLOAD";
-            case OperationType::DOWNLOAD: return "DOWNLOAD";
-            case OperationType::DELETE: return "DELETE";
-            default: return "UNKNOWN";
+        if (shard.file_sink && !shard.file_sink->sync()) {
+            durability.fail(durability.current_pass(), Durability::SYNCED);
         }
+        durability.complete_all();
     }
 
 private:
     std::string file_path_;
-    std::mutex mutex_;
-    Q& log_queue_;
-    std::condition_variable cv_;
+    const std::chrono::nanoseconds max_latency_;
+    const size_t spin_iterations_;
+    std::mutex mutex_;          // 保护 file_path_ / extra_sinks_ / observers_
+    std::shared_ptr<const SinkList> extra_sinks_ = std::make_shared<SinkList>();
+    std::shared_ptr<const ObserverList> observers_ = std::make_shared<ObserverList>();
     std::atomic<bool> running_;
-    std::atomic<int> unflushed_count_{0};
-    std::thread log_thread_;
-    mutable int current_file_index_; // 用于记录当前日志文件序号
+    std::unique_ptr<LogCompressor> compressor_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    LoggerMetrics metrics_;     // 最后声明：先于分片析构，读取方不会再访问已销毁的 sink
 };
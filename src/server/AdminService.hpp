@@ -0,0 +1,141 @@
+/*
+    运维管理接口，与文件服务共用同一个端口。
+
+    以 gRPC 通用服务 (CallbackGenericService) 实现，请求和响应都是纯文本，不依赖 .proto 生成代码：
+        /CCcloud.Admin/GetLogFilter     返回当前的访问日志过滤配置
+        /CCcloud.Admin/SetLogFilter     请求体为 key=value 列表（见 LogFilter），返回修改后的配置
+        /CCcloud.Admin/GetLoggerStats   返回进程内每个 logger 的运行指标（见 LoggerMetrics）
+        /CCcloud.Admin/GetRollups       请求体为查询参数（见 LogAggregator::query），返回按秒聚合的访问统计
+        /CCcloud.Admin/GetHotKeys       请求体为查询参数（见 LogHeavyHitters::query），返回最热的文件或客户端
+    只接受本机 (loopback / unix socket) 发起的调用。其他模块可以通过 add_handler 注册新的方法。
+*/
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <grpcpp/grpcpp.h>
+#include <grpcpp/generic/async_generic_service.h>
+#include <grpcpp/support/byte_buffer.h>
+
+#include "logger/LogAggregator.hpp"
+#include "logger/LogFilter.hpp"
+#include "logger/LogHeavyHitters.hpp"
+#include "logger/LoggerMetrics.hpp"
+
+
+class AdminService : public grpc::CallbackGenericService {
+public:
+    // 处理函数：request 为请求体文本，response 写入响应文本
+    using Handler = std::function<grpc::Status(std::string_view request, std::string& response)>;
+
+    AdminService() {
+        add_handler("/CCcloud.Admin/GetLogFilter", [](std::string_view, std::string& response) {
+            response = LogFilter::instance().describe();
+            return grpc::Status::OK;
+        });
+        add_handler("/CCcloud.Admin/SetLogFilter", [](std::string_view request, std::string& response) {
+            std::string error;
+            if (!LogFilter::instance().apply(request, error)) {
+                return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, error);
+            }
+            response = LogFilter::instance().describe();
+            return grpc::Status::OK;
+        });
+        add_handler("/CCcloud.Admin/GetLoggerStats", [](std::string_view, std::string& response) {
+            response = LoggerMetrics::describe_all();
+            return grpc::Status::OK;
+        });
+        add_handler("/CCcloud.Admin/GetRollups", [](std::string_view request, std::string& response) {
+            std::string error;
+            if (!LogAggregator::query_all(request, response, error)) {
+                return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, error);
+            }
+            return grpc::Status::OK;
+        });
+        add_handler("/CCcloud.Admin/GetHotKeys", [](std::string_view request, std::string& response) {
+            std::string error;
+            if (!LogHeavyHitters::query_all(request, response, error)) {
+                return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, error);
+            }
+            return grpc::Status::OK;
+        });
+    }
+
+    // 在服务启动 (BuildAndStart) 之前调用
+    void add_handler(const std::string& method, Handler handler) {
+        handlers_[method] = std::move(handler);
+    }
+
+    grpc::ServerGenericBidiReactor* CreateReactor(grpc::GenericCallbackServerContext* context) override {
+        return new AdminCall(context, handlers_);
+    }
+
+private:
+    // 一问一答：读一条请求，写一条响应后结束
+    class AdminCall : public grpc::ServerGenericBidiReactor {
+    public:
+        AdminCall(grpc::GenericCallbackServerContext* ctx,
+                  const std::unordered_map<std::string, Handler>& handlers)
+            : ctx_(ctx), handlers_(handlers) {
+            StartRead(&request_);
+        }
+
+        void OnReadDone(bool ok) override {
+            if (!ok) {
+                Finish(grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "missing request message"));
+                return;
+            }
+            if (!local_peer(ctx_->peer())) {
+                Finish(grpc::Status(grpc::StatusCode::PERMISSION_DENIED, "admin calls are only accepted from localhost"));
+                return;
+            }
+            auto it = handlers_.find(ctx_->method());
+            if (it == handlers_.end()) {
+                Finish(grpc::Status(grpc::StatusCode::UNIMPLEMENTED, "unknown method: " + ctx_->method()));
+                return;
+            }
+
+            std::string response;
+            grpc::Status status = it->second(to_string(request_), response);
+            if (!status.ok()) {
+                Finish(status);
+                return;
+            }
+            grpc::Slice slice(response);
+            response_ = grpc::ByteBuffer(&slice, 1);
+            StartWriteAndFinish(&response_, grpc::WriteOptions(), grpc::Status::OK);
+        }
+
+        void OnDone() override {
+            delete this;
+        }
+
+    private:
+        static bool local_peer(std::string_view peer) {
+            return peer.rfind("ipv4:127.", 0) == 0 || peer.rfind("ipv6:[::1]", 0) == 0 ||
+                   peer.rfind("ipv6:%5B::1%5D", 0) == 0 || peer.rfind("unix:", 0) == 0;
+        }
+
+        static std::string to_string(const grpc::ByteBuffer& buffer) {
+            std::vector<grpc::Slice> slices;
+            std::string out;
+            if (buffer.Dump(&slices).ok()) {
+                for (const auto& s : slices) {
+                    out.append(reinterpret_cast<const char*>(s.begin()), s.size());
+                }
+            }
+            return out;
+        }
+
+        grpc::GenericCallbackServerContext* ctx_;
+        const std::unordered_map<std::string, Handler>& handlers_;
+        grpc::ByteBuffer request_;
+        grpc::ByteBuffer response_;
+    };
+
+    std::unordered_map<std::string, Handler> handlers_;
+};
@@ -17,8 +17,8 @@ public:
         : ctx_(ctx), req_(req), resp_(resp)
     {
         uuid_ = AccessLogger::generate_uuid();
-        AccessLogger::log_prepare(uuid_, ctx_, OperationType::DELETE, "delete started");
-        t0_ = std::chrono::steady_clock::now();
+        AccessLogger::log_prepare(uuid_, ctx_, OperationType::DELETE, AccessParams::file(req_->filename()));
+        t0_ = TscClock::now();
         perform_delete();
     }
 
@@ -28,22 +28,14 @@ public:
 
     void OnDone() override
     {
-        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0_).count();
-
-        if (status_.ok()) {
-            AccessLogger::log_commit(uuid_, ctx_, OperationType::DELETE, "download completed", grpc::StatusCode::OK, ms);
-        } else {
-            AccessLogger::log_abort(uuid_, ctx_, OperationType::DELETE, status_.error_code(), status_.error_message(), ms);
-        }
-
         delete this;
     }
 
+    // Finish 可能还在等审计日志落盘，这里只记录取消，释放留给 OnDone
     void OnCancel() override
     {
-        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0_).count();
-        AccessLogger::log_abort(uuid_, ctx_, OperationType::DELETE, status_.error_code(), status_.error_message(), ms);
-        delete this;
+        auto ms = TscClock::elapsed_ms(t0_);
+        AccessLogger::log_abort(uuid_, ctx_, OperationType::DELETE, grpc::StatusCode::CANCELLED, "cancelled", ms);
     }
 
 private:
@@ -64,7 +56,7 @@ private:
         resp_->set_success(true);
         resp_->set_message("delete complete");
         status_ = grpc::Status::OK;
-        Finish(status_);
+        finish_durable(AccessParams::file(req_->filename()));
     }
 
     void finish_err(const std::string& msg)
@@ -72,15 +64,31 @@ private:
         resp_->set_success(false);
         resp_->set_message(msg);
         status_ = grpc::Status(grpc::StatusCode::INTERNAL, msg);
-        Finish(status_);
+        finish_durable({});
+    }
+
+    // 删除是审计操作：COMMIT/ABORT 记录 fdatasync 之后才应答客户端，审计记录没能落盘时请求失败
+    void finish_durable(const AccessParams& params)
+    {
+        auto ms = TscClock::elapsed_ms(t0_);
+        AccessLogger::log_commit_durable(uuid_, ctx_, OperationType::DELETE, params, status_.error_code(), ms,
+                                         status_.error_message(), Durability::SYNCED,
+                                         [this](bool durable) {
+                                             if (!durable) {
+                                                 resp_->set_success(false);
+                                                 resp_->set_message(format_msg(uuid_, "audit log not persisted"));
+                                                 status_ = grpc::Status(grpc::StatusCode::UNAVAILABLE, resp_->message());
+                                             }
+                                             Finish(status_);
+                                         });
     }
 
     template <typename ... _Args>
-    std::string format_msg(std::string uuid, _Args&&... args)
+    std::string format_msg(const LogUuid& uuid, _Args&&... args)
     {
         std::ostringstream oss;
 
-        oss << "Server [" << uuid << "]";
+        oss << "Server [" << uuid.to_string() << "]";
 
         if constexpr (sizeof...(_Args) > 0) {
             ((oss << " " << std::forward<_Args>(args)), ...);
@@ -94,7 +102,7 @@ private:
     const CCcloud::DeleteRequest* req_;
     CCcloud::DeleteResponse* resp_;
 
-    std::string uuid_;
-    std::chrono::steady_clock::time_point t0_;
+    LogUuid uuid_;
+    TscClock::time_point t0_;
     grpc::Status status_;
 };
@@ -18,9 +18,9 @@ public:
         : ctx_(ctx), req_(request)
     {
         uuid_ = AccessLogger::generate_uuid();
-        AccessLogger::log_prepare(uuid_, ctx_, OperationType::DOWNLOAD, "download started");
+        AccessLogger::log_prepare(uuid_, ctx_, OperationType::DOWNLOAD, AccessParams::file(req_->filename()));
         StartWrite(&dchunk_);
-        t0_ = std::chrono::steady_clock::now();
+        t0_ = TscClock::now();
     }
 
     ~AsyncDownloadCall() override
@@ -51,6 +51,7 @@ public:
         std::streamsize bytes_read = ifs_.gcount();
     
         if (bytes_read > 0) {
+            bytes_ += static_cast<uint64_t>(bytes_read);
             dchunk_.set_data(buffer_, bytes_read);
             StartWrite(&dchunk_);
         } else {
@@ -67,10 +68,11 @@ public:
 
     void OnDone() override
     {
-        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0_).count();
+        auto ms = TscClock::elapsed_ms(t0_);
 
         if (status_.ok()) {
-            AccessLogger::log_commit(uuid_, ctx_, OperationType::DOWNLOAD, "download completed", grpc::StatusCode::OK, ms);
+            AccessLogger::log_commit(uuid_, ctx_, OperationType::DOWNLOAD,
+                                    AccessParams::file(req_->filename(), bytes_), grpc::StatusCode::OK, ms);
         } else {
             AccessLogger::log_abort(uuid_, ctx_, OperationType::DOWNLOAD, status_.error_code(), status_.error_message(), ms);
         }
@@ -92,11 +94,11 @@ private:
     }
 
     template <typename ... _Args>
-    std::string format_msg(std::string uuid, _Args&&... args)
+    std::string format_msg(const LogUuid& uuid, _Args&&... args)
     {
         std::ostringstream oss;
 
-        oss << "Server [" << uuid << "]";
+        oss << "Server [" << uuid.to_string() << "]";
 
         if constexpr (sizeof...(_Args) > 0) {
             ((oss << " " << std::forward<_Args>(args)), ...);
@@ -111,9 +113,10 @@ private:
     CCcloud::DownloadChunk dchunk_;
 
     std::ifstream ifs_;
+    uint64_t bytes_ = 0;
 
-    std::string uuid_;
-    std::chrono::steady_clock::time_point t0_;
+    LogUuid uuid_;
+    TscClock::time_point t0_;
     grpc::Status status_;
     char buffer_[409600]; 
 };
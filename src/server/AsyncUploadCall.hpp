@@ -19,7 +19,7 @@ public:
         uuid_ = AccessLogger::generate_uuid();
         AccessLogger::log_prepare(uuid_, ctx_, OperationType::UPLOAD, "upload started");
         StartRead(&chunk_);
-        t0_ = std::chrono::steady_clock::now();
+        t0_ = TscClock::now();
     }
 
     ~AsyncUploadCall() override
@@ -57,6 +57,7 @@ public:
                 return;
             }
             file_opened_ = true;
+            filename_ = chunk_.filename();
         }
 
         ofs_.write(chunk_.data().data(), chunk_.data().size());
@@ -66,15 +67,17 @@ public:
             return;
         }
 
+        bytes_ += chunk_.data().size();
         StartRead(&chunk_);
     }
 
     void OnDone() override
     {
-        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0_).count();
+        auto ms = TscClock::elapsed_ms(t0_);
 
         if (status_.ok()) {
-            AccessLogger::log_commit(uuid_, ctx_, OperationType::UPLOAD, "upload committed", grpc::StatusCode::OK, ms);
+            AccessLogger::log_commit(uuid_, ctx_, OperationType::UPLOAD,
+                                    AccessParams::file(filename_, bytes_), grpc::StatusCode::OK, ms);
         } else {
             AccessLogger::log_abort(uuid_, ctx_, OperationType::UPLOAD, status_.error_code(), status_.error_message(), ms);
         }
@@ -100,11 +103,11 @@ private:
     }
 
     template <typename ... _Args>
-    std::string format_msg(std::string uuid, _Args&&... args)
+    std::string format_msg(const LogUuid& uuid, _Args&&... args)
     {
         std::ostringstream oss;
 
-        oss << "Server [" << uuid << "]";
+        oss << "Server [" << uuid.to_string() << "]";
 
         if constexpr (sizeof...(_Args) > 0) {
             ((oss << " " << std::forward<_Args>(args)), ...);
@@ -121,8 +124,10 @@ private:
 
     std::ofstream ofs_;
     bool file_opened_ = false;
+    std::string filename_;
+    uint64_t bytes_ = 0;
 
-    std::string uuid_;
-    std::chrono::steady_clock::time_point t0_;
+    LogUuid uuid_;
+    TscClock::time_point t0_;
     grpc::Status status_;
 };
@@ -17,10 +17,9 @@ class FileServiceImpl final : public CCcloud::FileService::Service {
         grpc::Status Upload(grpc::ServerContext* context,
                             grpc::ServerReader<CCcloud::UploadChunk>* reader,
                             CCcloud::UploadResponse* response) override {
-            using namespace std::chrono;
     
             auto uuid = AccessLogger::generate_uuid();
-            auto start = steady_clock::now();
+            auto start = TscClock::now();
     
             std::string filename = "[unknown]";
             std::ofstream ofs;
@@ -36,7 +35,7 @@ class FileServiceImpl final : public CCcloud::FileService::Service {
                     std::filesystem::create_directories("uploads/");
                     ofs.open("uploads/" + filename, std::ios::binary);
                     if (!ofs.is_open()) {
-                        auto duration = duration_cast<milliseconds>(steady_clock::now() - start).count();
+                        auto duration = TscClock::elapsed_ms(start);
                         AccessLogger::log_abort(uuid, context, OperationType::UPLOAD,
                                                 grpc::StatusCode::INTERNAL,
                                                 "failed to open file",
@@ -52,9 +51,9 @@ class FileServiceImpl final : public CCcloud::FileService::Service {
             ofs.close();
             response->set_message("Upload successful");
     
-            auto duration = duration_cast<milliseconds>(steady_clock::now() - start).count();
+            auto duration = TscClock::elapsed_ms(start);
             AccessLogger::log_commit(uuid, context, OperationType::UPLOAD,
-                                     "filename=" + filename + " size=" + std::to_string(total_bytes),
+                                     AccessParams::file(filename, total_bytes),
                                      grpc::StatusCode::OK, duration);
     
             return grpc::Status::OK;
@@ -63,18 +62,17 @@ class FileServiceImpl final : public CCcloud::FileService::Service {
         grpc::Status Download(grpc::ServerContext* context,
                               const CCcloud::DownloadRequest* request,
                               grpc::ServerWriter<CCcloud::DownloadChunk>* writer) override {
-            using namespace std::chrono;
     
             auto uuid = AccessLogger::generate_uuid();
-            auto start = steady_clock::now();
+            auto start = TscClock::now();
     
             std::string filename = request->filename();
             AccessLogger::log_prepare(uuid, context, OperationType::DOWNLOAD,
-                                      "filename=" + filename);
+                                      AccessParams::file(filename));
     
             std::ifstream ifs("uploads/" + filename, std::ios::binary);
             if (!ifs.is_open()) {
-                auto duration = duration_cast<milliseconds>(steady_clock::now() - start).count();
+                auto duration = TscClock::elapsed_ms(start);
                 AccessLogger::log_abort(uuid, context, OperationType::DOWNLOAD,
                                         grpc::StatusCode::NOT_FOUND,
                                         "file not found",
@@ -94,9 +92,9 @@ class FileServiceImpl final : public CCcloud::FileService::Service {
             }
     
             ifs.close();
-            auto duration = duration_cast<milliseconds>(steady_clock::now() - start).count();
+            auto duration = TscClock::elapsed_ms(start);
             AccessLogger::log_commit(uuid, context, OperationType::DOWNLOAD,
-                                     "filename=" + filename + " size=" + std::to_string(total_bytes),
+                                     AccessParams::file(filename, total_bytes),
                                      grpc::StatusCode::OK, duration);
     
             return grpc::Status::OK;
@@ -105,14 +103,13 @@ class FileServiceImpl final : public CCcloud::FileService::Service {
         grpc::Status Delete(grpc::ServerContext* context,
                             const CCcloud::DeleteRequest* request,
                             CCcloud::DeleteResponse* response) override {
-            using namespace std::chrono;
     
             auto uuid = AccessLogger::generate_uuid();
-            auto start = steady_clock::now();
+            auto start = TscClock::now();
     
             std::string filename = request->filename();
             AccessLogger::log_prepare(uuid, context, OperationType::DELETE,
-                                      "filename=" + filename);
+                                      AccessParams::file(filename));
     
             std::string filepath = "uploads/" + filename;
             grpc::StatusCode status;
@@ -126,9 +123,9 @@ class FileServiceImpl final : public CCcloud::FileService::Service {
                 status = grpc::StatusCode::NOT_FOUND;
             }
     
-            auto duration = duration_cast<milliseconds>(steady_clock::now() - start).count();
+            auto duration = TscClock::elapsed_ms(start);
             AccessLogger::log_commit(uuid, context, OperationType::DELETE,
-                                     "filename=" + filename,
+                                     AccessParams::file(filename),
                                      status, duration);
     
             return grpc::Status(status, response->message());
@@ -11,6 +11,7 @@
 
 #include "generated/file.grpc.pb.h"
 #include "AsyncCall.hpp"
+#include "AdminService.hpp"
 #include "logger/AccessLogger.hpp"
 
 
@@ -50,10 +51,12 @@ public:
 int main() {
     std::string server_address("0.0.0.0:9527");
     CCcloudServiceImplCallback service;
+    AdminService admin;     // 运行时调整日志过滤等，见 CCcloud_admin
 
     ServerBuilder builder;
     builder.AddListeningPort(server_address, grpc::InsecureServerCredentials());
     builder.RegisterService(&service);
+    builder.RegisterCallbackGenericService(&admin);
 
     std::unique_ptr<Server> server(builder.BuildAndStart());
     std::cout << "✅ Callback-based gRPC Server listening on " << server_address << std::endl;
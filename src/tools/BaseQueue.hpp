@@ -1,14 +1,171 @@
 /*
-    如果用户想使用自己定义的队列类，只需要继承这个类，并实现 enqueue、dequeue 和 empty 方法即可。
-    这样就可以在 AsyncLogger 中使用用户自定义的队列类。
+    队列的约定由 ConcurrentQueue 概念描述，AsyncLogger 等模板按队列的静态类型调用，不经过虚函数，
+    append 路径上的入队可以完全内联。仓库里的队列都直接满足这个概念，不继承任何基类。
+
+    empty() 返回 true 时，所有已经返回的 enqueue 放入的元素都必须已被取出；另外单个消费者按 FIFO 顺序取出元素。
+    AsyncLogger 据此判断写出的日志是否覆盖了之前入队的全部记录（见 LogDurability.hpp）。
+
+    需要运行时多态的调用方使用 BaseQueue<T>：QueueAdapter<Q> 把任意满足概念的队列包装成 BaseQueue<T>；
+    用户也可以直接继承 BaseQueue 实现 enqueue、dequeue 和 empty，其余操作有逐个调用的默认实现，
+    这样的类同样满足 ConcurrentQueue，可以用在 AsyncLogger 中。
 */
 #pragma once
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+/*
+    AsyncLogger 为每个分片构造一个队列。如果队列的构造函数在用户参数之后还能接受一个 QueueShard，
+    AsyncLogger 会把分片序号传进去，需要按分片区分资源的队列（例如基于文件的队列）据此选择文件名。
+*/
+struct QueueShard {
+    size_t index = 0;
+    size_t count = 1;
+};
+
+/*
+    多生产者队列的约定：
+      - enqueue 阻塞直到元素入队（有界队列满时等待），try_enqueue 不等待，满时返回 false；
+      - dequeue / try_dequeue 都不阻塞，队列为空时返回 false；
+      - enqueue_bulk(first, last) 返回时全部入队，dequeue_bulk(out, max) 返回取出的个数，不阻塞；
+      - size() 是并发下的估计值，empty() 的约定见文件开头。
+    只要求右值入队，只可移动的元素类型也能满足。
+*/
+template <typename Q>
+concept ConcurrentQueue = requires(Q& q, const Q& cq, typename Q::value_type& value,
+                                   typename Q::value_type* items, size_t max) {
+    q.enqueue(std::move(value));
+    { q.try_enqueue(std::move(value)) } -> std::same_as<bool>;
+    { q.dequeue(value) } -> std::same_as<bool>;
+    { q.try_dequeue(value) } -> std::same_as<bool>;
+    q.enqueue_bulk(std::make_move_iterator(items), std::make_move_iterator(items + max));
+    { q.dequeue_bulk(items, max) } -> std::same_as<size_t>;
+    { cq.empty() } -> std::same_as<bool>;
+    { cq.size() } -> std::convertible_to<size_t>;
+};
+
+/*
+    在 ConcurrentQueue 之上提供等待：wait_dequeue 阻塞到取出一个元素；enqueue_for / wait_dequeue_for
+    最多等待 timeout，超时返回 false。怎样等待由队列的 Wait 模板参数决定（见 WaitStrategy.hpp）。
+*/
+template <typename Q>
+concept BlockingQueue = ConcurrentQueue<Q> &&
+    requires(Q& q, typename Q::value_type& value, std::chrono::nanoseconds timeout) {
+        q.wait_dequeue(value);
+        { q.wait_dequeue_for(value, timeout) } -> std::same_as<bool>;
+        { q.enqueue_for(std::move(value), timeout) } -> std::same_as<bool>;
+    };
+
 template <typename T>
 class BaseQueue {
 public:
     using value_type = T;
     virtual ~BaseQueue() = default;
     virtual void enqueue(const T& value) = 0;
+    // 右值入队，默认退化为复制；能把数据直接移动进队列的实现应当覆盖它
+    virtual void enqueue(T&& value) {
+        enqueue(static_cast<const T&>(value));
+    }
     virtual bool dequeue(T& value) = 0;
     virtual bool empty() const = 0;
-};
\ No newline at end of file
+
+    // 默认按无界队列处理：总能入队
+    virtual bool try_enqueue(T&& value) {
+        enqueue(std::move(value));
+        return true;
+    }
+
+    virtual bool try_dequeue(T& value) {
+        return dequeue(value);
+    }
+
+    // 默认只知道是否为空
+    virtual size_t size() const {
+        return empty() ? 0 : 1;
+    }
+
+    // 入队 [first, last)，返回时全部入队；需要移动时传 std::make_move_iterator
+    template <typename InputIt>
+    void enqueue_bulk(InputIt first, InputIt last) {
+        for (; first != last; ++first) {
+            enqueue(*first);
+        }
+    }
+
+    // 最多取出 max 个元素写入 out，返回取出的个数；没有可取的元素时返回 0，不阻塞
+    template <typename OutputIt>
+    size_t dequeue_bulk(OutputIt out, size_t max) {
+        size_t n = 0;
+        T value;
+        while (n < max && dequeue(value)) {
+            *out++ = std::move(value);
+            ++n;
+        }
+        return n;
+    }
+};
+
+// 把满足 ConcurrentQueue 的队列包装成 BaseQueue；按静态类型调用时批量操作仍走队列自己的实现
+template <ConcurrentQueue Q>
+class QueueAdapter final : public BaseQueue<typename Q::value_type> {
+public:
+    using T = typename Q::value_type;
+
+    // 受约束：AsyncLogger 据 is_constructible 判断能否传入 QueueShard，不能对任意参数都声称可构造
+    template <typename... Args>
+        requires std::constructible_from<Q, Args...>
+    explicit QueueAdapter(Args&&... args) : queue_(std::forward<Args>(args)...) {}
+
+    void enqueue(const T& value) override {
+        if constexpr (std::is_copy_constructible_v<T>) {
+            queue_.enqueue(value);
+        } else {
+            throw std::logic_error("QueueAdapter: element type is move-only, enqueue an rvalue");
+        }
+    }
+
+    void enqueue(T&& value) override {
+        queue_.enqueue(std::move(value));
+    }
+
+    bool dequeue(T& value) override {
+        return queue_.dequeue(value);
+    }
+
+    bool empty() const override {
+        return queue_.empty();
+    }
+
+    bool try_enqueue(T&& value) override {
+        return queue_.try_enqueue(std::move(value));
+    }
+
+    bool try_dequeue(T& value) override {
+        return queue_.try_dequeue(value);
+    }
+
+    size_t size() const override {
+        return queue_.size();
+    }
+
+    template <typename InputIt>
+    void enqueue_bulk(InputIt first, InputIt last) {
+        queue_.enqueue_bulk(first, last);
+    }
+
+    template <typename OutputIt>
+    size_t dequeue_bulk(OutputIt out, size_t max) {
+        return queue_.dequeue_bulk(out, max);
+    }
+
+    Q& get() {
+        return queue_;
+    }
+
+private:
+    Q queue_;
+};
@@ -0,0 +1,10 @@
+#pragma once
+#include <cstddef>
+#include <new>
+
+// 用于 alignas 隔开被不同线程频繁写入的字段，避免伪共享
+#ifdef __cpp_lib_hardware_interference_size
+    inline constexpr size_t hardware_destructive_interference_size = std::hardware_destructive_interference_size;
+#else
+    inline constexpr size_t hardware_destructive_interference_size = 64;
+#endif
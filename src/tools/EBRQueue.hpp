@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include <iostream>
 #include <atomic>
 #include <thread>
@@ -6,9 +7,6 @@
 #include <optional>
 #include <memory>
 #include <functional>
-#include <mutex>
-#include <shared_mutex>
-#include <unordered_map>
 #include <vector>
 #include <numeric> // for std::iota
 #include <chrono> // for sleep_for, etc.
@@ -18,124 +16,143 @@
 #endif
 
 #include "BaseQueue.hpp"
+#include "Reclamation.hpp"
+#include "HazardPointers.hpp"
+#include "NodePool.hpp"
+#include "WaitStrategy.hpp"
+
+static constexpr size_t EBR_RETIRE_THRESHOLD = 128;     // 本线程待回收节点达到此数时尝试推进全局纪元
+static constexpr size_t EBR_LIMBO_LISTS = 3;            // 按纪元 e % 3 分桶的待回收链表
+
+// 经 EBR 回收的对象继承这个头部：退休时只填两个字段，不做任何分配
+struct EBRNode {
+    EBRNode* ebr_next = nullptr;
+    void (*ebr_deleter)(EBRNode*) = nullptr;
+};
 
-#ifdef __cpp_lib_hardware_interference_size
-    inline constexpr size_t hardware_destructive_interference_size = std::hardware_destructive_interference_size;
-#else
-    inline constexpr size_t hardware_destructive_interference_size = 64;
-#endif
-
+/*
+    纪元推进：某线程的待回收节点数每达到 EBR_RETIRE_THRESHOLD 扫描一次所有线程，
+    若每个处于临界区的线程都已观察到当前全局纪元 E，则把全局纪元 CAS 为 E + 1。
+    在纪元 e 退休的节点，全局纪元到达 e + 2 后不再可能被任何临界区引用。
+
+    待回收节点挂在所属线程的三条侵入式链表上 (limbo[e % 3])，链表只由持有槽位的线程访问，不加锁：
+      - retire 时若桶里是更早纪元 (至少 e - 3) 的节点，先整条摘下释放，再把新节点压入；
+      - leave 时释放已满两个纪元的桶，摘链是 O(1) 的，之后逐个调用 deleter。
+    因此每个线程最多积压约三个纪元的节点（前提是没有线程长期停留在临界区）。
+
+    线程注册：每个线程第一次使用时从 ThreadSlots 占一个槽位。线程退出时 thread_local 句柄自动归还槽位，
+    尚未到期的待回收节点留在槽里，由下一个占用该槽位的线程接着回收。
+    EBRManager 从不析构（见 shared()），进程退出时仍未到期的节点不再释放。
+    扫描只遍历已分配的槽位，注册和扫描都不加锁。
+*/
 class EBRManager {
 private:
-    struct RetiredNode {
-        void* ptr;
-        std::function<void(void*)> deleter;
-        uint64_t epoch;
+    struct LimboList {
+        EBRNode* head = nullptr;
+        size_t count = 0;
+        uint64_t epoch = UINT64_MAX;
     };
 
     struct alignas(hardware_destructive_interference_size) ThreadData {
         std::atomic<uint64_t> local_epoch{UINT64_MAX}; // UINT64_MAX 表示不活跃
-        std::vector<RetiredNode> retired_list;
-        std::mutex list_mutex; // 保护 retired_list
-        bool registered = false;
-
-        ThreadData() = default;
-        ThreadData(const ThreadData&) = delete;
-        ThreadData& operator=(const ThreadData&) = delete;
-        ThreadData(ThreadData&&) = delete;
-        ThreadData& operator=(ThreadData&&) = delete;
+        std::atomic<bool> in_use{false};
+        LimboList limbo[EBR_LIMBO_LISTS];   // 只由持有槽位的线程访问
+        size_t pending = 0;                 // 三条链表的节点总数
     };
 
-    alignas(hardware_destructive_interference_size) std::atomic<uint64_t> global_epoch{0};
-    std::shared_mutex registry_mutex;
-    std::unordered_map<std::thread::id, std::unique_ptr<ThreadData>> thread_registry;
-
-    static thread_local ThreadData* current_thread_data;
-    static thread_local bool needs_registration;
-
-
-    void register_thread_if_needed() {
-        if (needs_registration) {
-            std::thread::id tid = std::this_thread::get_id();
-            std::unique_lock lock(registry_mutex);
-            if (thread_registry.find(tid) == thread_registry.end()) {
-                auto data = std::make_unique<ThreadData>();
-                current_thread_data = data.get();
-                thread_registry[tid] = std::move(data);
-                current_thread_data->registered = true;
-            } else {
-                 current_thread_data = thread_registry[tid].get();
+    // 线程退出时归还槽位；持有 EBRManager 的引用，保证归还时它还活着
+    struct ThreadHandle {
+        std::shared_ptr<EBRManager> manager;
+        ThreadData* slot = nullptr;
+
+        ~ThreadHandle() {
+            if (slot) {
+                manager->release_slot(slot);
             }
-            needs_registration = false;
         }
-        if (!current_thread_data) {
-             std::thread::id tid = std::this_thread::get_id();
-             std::shared_lock lock(registry_mutex);
-             auto it = thread_registry.find(tid);
-             if (it != thread_registry.end()) {
-                 current_thread_data = it->second.get();
-             } else {
-                 lock.unlock();
-                 std::unique_lock write_lock(registry_mutex);
-                 if (thread_registry.find(tid) == thread_registry.end()) {
-                     auto data = std::make_unique<ThreadData>();
-                     current_thread_data = data.get();
-                     thread_registry[tid] = std::move(data);
-                     current_thread_data->registered = true;
-                 } else {
-                    current_thread_data = thread_registry[tid].get();
-                 }
-             }
+    };
+
+    alignas(hardware_destructive_interference_size) std::atomic<uint64_t> global_epoch{0};
+    ThreadSlots<ThreadData> slots_;
+
+    static ThreadHandle& handle() {
+        static thread_local ThreadHandle h;
+        return h;
+    }
+
+    ThreadData* current_slot() {
+        ThreadHandle& h = handle();
+        if (!h.slot) {
+            h.manager = shared();
+            h.slot = slots_.claim();
+        }
+        return h.slot;
+    }
+
+    // 先释放已到期的节点，其余留在槽里交给下一个占用者
+    void release_slot(ThreadData* slot) {
+        slot->local_epoch.store(UINT64_MAX, std::memory_order_release);
+        try_reclaim(slot);
+        slots_.release(slot);
+    }
+
+    // 整条摘下后逐个释放
+    static void free_list(ThreadData* data, LimboList& list) {
+        EBRNode* node = list.head;
+        data->pending -= list.count;
+        list.head = nullptr;
+        list.count = 0;
+        list.epoch = UINT64_MAX;
+        while (node) {
+            EBRNode* next = node->ebr_next;
+            node->ebr_deleter(node);
+            node = next;
         }
     }
 
     void try_reclaim(ThreadData* data) {
+        if (data->pending == 0) return;
         uint64_t current_global_epoch = global_epoch.load(std::memory_order_acquire);
-        if (current_global_epoch < 2) return;
-        uint64_t safe_epoch = current_global_epoch - 2;
-
-        std::vector<RetiredNode> still_retired;
-        std::vector<RetiredNode> to_delete;
-        {
-            std::lock_guard list_lock(data->list_mutex);
-             for (auto& node : data->retired_list) {
-                 if (node.epoch <= safe_epoch) {
-                     to_delete.push_back(std::move(node));
-                 } else {
-                     still_retired.push_back(std::move(node));
-                 }
-             }
-             data->retired_list = std::move(still_retired);
+        for (auto& list : data->limbo) {
+            if (list.head && list.epoch + 2 <= current_global_epoch) {
+                free_list(data, list);
+            }
         }
+    }
 
-        for (const auto& node : to_delete) {
-            node.deleter(node.ptr);
+    // 所有处于临界区的线程都已观察到当前纪元时推进一次，返回是否推进成功（包括被其他线程推进）
+    bool try_advance() {
+        uint64_t epoch = global_epoch.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);    // 与 enter() 中的 fence 配对
+        bool all_observed = true;
+        slots_.for_each([&](const ThreadData& slot) {
+            // acquire 与 leave() 的 release 配对：离开的临界区内的访问先于之后的释放
+            uint64_t local = slot.local_epoch.load(std::memory_order_acquire);
+            if (local != UINT64_MAX && local != epoch) {
+                all_observed = false;
+            }
+        });
+        if (!all_observed) {
+            return false;
         }
+        global_epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_acq_rel);
+        return true;
     }
 
     EBRManager() = default;
 
 public:
     static EBRManager& instance() {
-        static EBRManager instance;
-        return instance;
-    }    
-
-    ~EBRManager() {
-         bump_epoch_often();
-         bump_epoch_often();
-         bump_epoch_often();
+        return *shared();
+    }
 
-         std::unique_lock lock(registry_mutex);
-         for (auto& pair : thread_registry) {
-             try_reclaim(pair.second.get());
-             std::lock_guard list_lock(pair.second->list_mutex);
-             for (const auto& node : pair.second->retired_list) {
-                 node.deleter(node.ptr);
-             }
-             pair.second->retired_list.clear();
-         }
-         thread_registry.clear();
+    /*
+        有意泄漏，从不析构：静态对象的析构顺序不确定，比它先构造的静态对象（如 AsyncLogger::registry()
+        中的 logger）析构时还要经 instance() 进入临界区、退休节点。退出时剩下的节点交给操作系统回收。
+    */
+    static const std::shared_ptr<EBRManager>& shared() {
+        static auto* instance = new std::shared_ptr<EBRManager>(new EBRManager());
+        return *instance;
     }
 
     EBRManager(const EBRManager&) = delete;
@@ -144,99 +161,149 @@ public:
     EBRManager& operator=(EBRManager&&) = delete;
 
     void enter() {
-        register_thread_if_needed();
-        if (current_thread_data) {
-            uint64_t current_epoch = global_epoch.load(std::memory_order_relaxed);
-            current_thread_data->local_epoch.store(current_epoch, std::memory_order_relaxed);
-        } else {
-             std::cerr << "Error: Thread data not available in enter()" << std::endl;
-        }
+        ThreadData* data = current_slot();
+        uint64_t current_epoch = global_epoch.load(std::memory_order_relaxed);
+        data->local_epoch.store(current_epoch, std::memory_order_relaxed);
+        // 纪元的发布必须先于临界区内对共享指针的读取，否则扫描方可能看不到本线程
+        std::atomic_thread_fence(std::memory_order_seq_cst);
     }
 
     void leave() {
-         if (current_thread_data) {
-            current_thread_data->local_epoch.store(UINT64_MAX, std::memory_order_relaxed);
-            try_reclaim(current_thread_data);
-        } else {
-             std::cerr << "Error: Thread data not available in leave()" << std::endl;
-        }
+        ThreadData* data = handle().slot;
+        data->local_epoch.store(UINT64_MAX, std::memory_order_release);
+        try_reclaim(data);
     }
 
     template <typename T>
+        requires std::derived_from<T, EBRNode>
     void retire(T* ptr) {
-         if (!ptr) return;
-         register_thread_if_needed();
-         if (current_thread_data) {
-            uint64_t current_epoch = global_epoch.load(std::memory_order_relaxed);
-            std::function<void(void*)> deleter = [](void* p){ delete static_cast<T*>(p); };
-            RetiredNode node{static_cast<void*>(ptr), deleter, current_epoch};
-            std::lock_guard lock(current_thread_data->list_mutex);
-            current_thread_data->retired_list.push_back(std::move(node));
-        } else {
-            std::cerr << "Error: Thread data not available in retire(). Leaking memory." << std::endl;
+        if (!ptr) return;
+        ThreadData* data = current_slot();
+        uint64_t current_epoch = global_epoch.load(std::memory_order_relaxed);
+        LimboList& list = data->limbo[current_epoch % EBR_LIMBO_LISTS];
+        if (list.epoch != current_epoch) {
+            free_list(data, list);  // 同一个桶里只可能是 current_epoch - 3 或更早的节点
+            list.epoch = current_epoch;
+        }
+        ptr->ebr_deleter = [](EBRNode* node) { dispose_node(static_cast<T*>(node)); };
+        ptr->ebr_next = list.head;
+        list.head = ptr;
+        list.count++;
+        // 每攒满一个阈值尝试推进一次；真正的回收留给 leave()
+        if (++data->pending % EBR_RETIRE_THRESHOLD == 0) {
+            try_advance();
         }
     }
 
-    void bump_epoch() {
-        global_epoch.fetch_add(1, std::memory_order_release);
+    uint64_t epoch() const {
+        return global_epoch.load(std::memory_order_relaxed);
     }
 
-    void bump_epoch_often() {
-        for(int i = 0; i < 5; ++i) {
-            bump_epoch();
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    // 已分配的槽位数与正在使用的槽位数
+    size_t slot_capacity() const {
+        return slots_.capacity();
+    }
+
+    size_t slots_in_use() {
+        return slots_.in_use();
+    }
+
+    // 线程退出时会自动调用，提前调用可以立即归还槽位
+    void unregister_thread() {
+        ThreadHandle& h = handle();
+        if (h.slot) {
+            release_slot(h.slot);
+            h.slot = nullptr;
         }
     }
+};
+
+// 纪元回收作为 MPMCQueue 的回收策略：guard 的生存期就是一个临界区，protect 只是一次 acquire 读
+struct EBRReclaimer {
+    using node_base = EBRNode;
+
+    class guard {
+    public:
+        guard() {
+            EBRManager::instance().enter();
+        }
+
+        ~guard() {
+            EBRManager::instance().leave();
+        }
+
+        guard(const guard&) = delete;
+        guard& operator=(const guard&) = delete;
+
+        template <typename N>
+        N* protect(size_t, const std::atomic<N*>& src) {
+            return src.load(std::memory_order_acquire);
+        }
 
-     void unregister_thread() {
-         std::thread::id tid = std::this_thread::get_id();
-         std::unique_lock lock(registry_mutex);
-         auto it = thread_registry.find(tid);
-         if (it != thread_registry.end()) {
-             ThreadData* data = it->second.get();
-             try_reclaim(data);
-             {
-                 std::lock_guard list_lock(data->list_mutex);
-                 for (const auto& node : data->retired_list) {
-                     node.deleter(node.ptr);
-                 }
-                 data->retired_list.clear();
-             }
-             thread_registry.erase(it);
-             current_thread_data = nullptr;
-             needs_registration = true;
-         }
+        template <typename N>
+        void retire(N* node) {
+            EBRManager::instance().retire(node);
+        }
+    };
+
+    static void init_node(node_base*) {}
+
+    static const std::shared_ptr<EBRManager>& shared() {
+        return EBRManager::shared();
     }
 };
 
-thread_local EBRManager::ThreadData* EBRManager::current_thread_data = nullptr;
-thread_local bool EBRManager::needs_registration = true;
+/*
+    Michael-Scott 队列。回收策略见 Reclamation.hpp，默认 EBR；
+    不希望一个停住的线程拖住全部回收时可以选 HazardPointerReclaimer 或 HazardEraReclaimer。
+    dequeue 同时保护 head 和 head->next 两个节点，dequeue_bulk 沿链表前进时还要多保护一个，策略至少要支持三个保护位。
+    节点取自 NodePool，回收器释放时放回池中；右值入队把数据直接移动进节点，稳态下入队不分配内存。
 
-template <typename T>
+    批量操作：enqueue_bulk 先在本地把节点串成一条链，一次 CAS 挂到 tail 后面；
+    dequeue_bulk 从 head 往后数出最多 max 个节点（不越过 tail），一次 CAS 把 head 移到最后一个，再依次取出数据。
+
+    节点挂上队尾前按位置编号 (seq = 前一个节点的 seq + 1)，size() 用 tail 与 head 的编号差估计长度，
+    入队出队路径上没有额外的共享计数器。满足 BlockingQueue（BaseQueue.hpp），无界，try_enqueue 总是成功；
+    wait_dequeue 按 Wait 策略等待元素（见 WaitStrategy.hpp）。
+*/
+template <typename T, typename Reclaimer = EBRReclaimer, typename Wait = ParkingWait>
 #if __cplusplus >= 202002L
-    requires std::movable<T> // 假设 T 是可移动的
+    requires std::movable<T> && ReclamationPolicy<Reclaimer> && WaitStrategy<Wait> // 假设 T 是可移动的
 #endif
-class MPMCQueue final : public BaseQueue<T> { // 使用 final 明确无后续继承，继承 BaseQueue
+class MPMCQueue final {
 private:
-    struct Node {
+    struct Node : Reclaimer::node_base {
         std::optional<T> data;
         std::atomic<Node*> next{nullptr};
+        uint64_t seq = 0;   // 在队列中的位置，发布前写入，之后不变
 
         Node() = default;
-        explicit Node(const T& val) : data(val) {}
-        Node(T&& val) noexcept : data(move(val)) {}
+
+        // 回收器释放节点时调用 (dispose_node)
+        static void recycle(Node* node) {
+            node->data.reset();
+            NodePool<Node>::release(node);
+        }
     };
 
+    using Guard = typename Reclaimer::guard;
+
     alignas(hardware_destructive_interference_size) std::atomic<Node*> head;
     alignas(hardware_destructive_interference_size) std::atomic<Node*> tail;
+    [[no_unique_address]] Wait not_empty_;
+
+public:
+    using value_type = T;
+    using reclaimer_type = Reclaimer;
 
     MPMCQueue() {
         Node* dummy = new Node();
+        Reclaimer::init_node(dummy);
         head.store(dummy, std::memory_order_relaxed);
         tail.store(dummy, std::memory_order_relaxed);
     }
 
-    ~MPMCQueue() override {
+    ~MPMCQueue() {
         T temp_val;
         while (dequeue(temp_val));
         Node* dummy = head.load(std::memory_order_relaxed);
@@ -245,9 +312,8 @@ private:
         }
     }
 
-public:
-    static MPMCQueue<T>& instance() {
-        static MPMCQueue<T> instance;
+    static MPMCQueue& instance() {
+        static MPMCQueue instance;
         return instance;
     }
 
@@ -256,27 +322,165 @@ public:
 
     /**
      * @brief Enqueues a value into the queue (thread-safe).
-     * Implements BaseQueue::enqueue.
      * @param value The value to enqueue (passed by const reference).
      */
-    void enqueue(const T& value) override {
-        Node* new_node = new Node(value);
-        EBRManager::instance().enter();
-        Node* current_tail = nullptr;
+    void enqueue(const T& value) {
+        push(value);
+    }
+
+    // 右值入队：数据直接移动进节点，不再复制
+    void enqueue(T&& value) {
+        push(std::move(value));
+    }
+
+    // 无界队列，总能入队
+    bool try_enqueue(const T& value) {
+        push(value);
+        return true;
+    }
+
+    bool try_enqueue(T&& value) {
+        push(std::move(value));
+        return true;
+    }
+
+    bool enqueue_for(const T& value, std::chrono::nanoseconds) {
+        push(value);
+        return true;
+    }
+
+    bool enqueue_for(T&& value, std::chrono::nanoseconds) {
+        push(std::move(value));
+        return true;
+    }
+
+    // 入队 [first, last)：整段串成一条链后一次挂到队尾
+    template <typename InputIt>
+    void enqueue_bulk(InputIt first, InputIt last) {
+        Node* chain_head = nullptr;
+        Node* chain_tail = nullptr;
+        for (; first != last; ++first) {
+            Node* node = make_node(*first);
+            if (chain_tail) {
+                chain_tail->next.store(node, std::memory_order_relaxed);
+            } else {
+                chain_head = node;
+            }
+            chain_tail = node;
+        }
+        if (chain_head) {
+            link(chain_head, chain_tail);
+            not_empty_.notify();
+        }
+    }
+
+    // 最多取出 max 个元素，head 只移动一次；队列为空时返回 0
+    template <typename OutputIt>
+    size_t dequeue_bulk(OutputIt out, size_t max) {
+        if (max == 0) {
+            return 0;
+        }
+        Guard guard;
         while (true) {
-            current_tail = tail.load(std::memory_order_acquire);
+            Node* current_head = guard.protect(0, head);
+            Node* current_tail = tail.load(std::memory_order_acquire);
+            // 沿链表数到 tail 为止；每保护一个节点都确认 head 未变，此时它仍在队列中，可以解引用。
+            // 保护位 1、2 交替使用，当前节点一直受保护，直到读出它的 next
+            Node* last = current_head;
+            size_t count = 0;
+            bool moved = false;
+            while (count < max && last != current_tail) {
+                Node* next_node = guard.protect(1 + count % 2, last->next);
+                if (current_head != head.load(std::memory_order_acquire)) {
+                    moved = true;
+                    break;
+                }
+                if (next_node == nullptr) {
+                    break;
+                }
+                last = next_node;
+                count++;
+            }
+            if (moved) {
+                continue;
+            }
+            if (count == 0) {
+                Node* next_node = guard.protect(1, current_head->next);
+                if (current_head != head.load(std::memory_order_acquire)) {
+                    continue;
+                }
+                if (next_node == nullptr) {
+                    return 0; // Queue is empty
+                }
+                // tail 落后，帮它前进后重试
+                tail.compare_exchange_weak(
+                    current_tail, next_node,
+                    std::memory_order_release, std::memory_order_relaxed);
+                continue;
+            }
+            if (!head.compare_exchange_weak(
+                    current_head, last,
+                    std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                continue;
+            }
+            // 中间的节点只由本线程退休；最后一个成为新的哑节点，仍在保护位里
+            Node* node = current_head;
+            for (size_t i = 0; i < count; ++i) {
+                Node* next_node = node->next.load(std::memory_order_acquire);
+                *out++ = std::move(*(next_node->data));
+                next_node->data.reset();
+                guard.retire(node);
+                node = next_node;
+            }
+            return count;
+        }
+    }
+
+private:
+    template <typename U>
+    static Node* make_node(U&& value) {
+        Node* node = NodePool<Node>::acquire();
+        node->data.emplace(std::forward<U>(value));
+        Reclaimer::init_node(node);
+        return node;
+    }
+
+    template <typename U>
+    void push(U&& value) {
+        Node* new_node = make_node(std::forward<U>(value));
+        link(new_node, new_node);
+        not_empty_.notify();    // 在 link 的 guard 之外，可能的 futex 唤醒不延长临界区
+    }
+
+    // 把 first 开始、以 last 结尾的链挂到队尾
+    void link(Node* first, Node* last) {
+        Guard guard;
+        uint64_t numbered_after = UINT64_MAX;
+        while (true) {
+            Node* current_tail = guard.protect(0, tail);
             Node* next_node = current_tail->next.load(std::memory_order_acquire);
 
             if (current_tail == tail.load(std::memory_order_acquire)) {
                 if (next_node == nullptr) {
+                    // 链还是私有的，按将要挂上的位置编号；队尾变了才需要重编
+                    if (numbered_after != current_tail->seq) {
+                        numbered_after = current_tail->seq;
+                        uint64_t seq = numbered_after;
+                        for (Node* node = first; ; node = node->next.load(std::memory_order_relaxed)) {
+                            node->seq = ++seq;
+                            if (node == last) {
+                                break;
+                            }
+                        }
+                    }
                     if (current_tail->next.compare_exchange_weak(
-                            next_node, new_node,
+                            next_node, first,
                             std::memory_order_release, std::memory_order_relaxed))
                     {
+                        // 失败说明其他线程已经帮着沿这条链推进 tail
                         tail.compare_exchange_weak(
-                            current_tail, new_node,
+                            current_tail, last,
                             std::memory_order_release, std::memory_order_relaxed);
-                            EBRManager::instance().leave();
                         return;
                     }
                 } else {
@@ -288,27 +492,24 @@ public:
         }
     }
 
+public:
+
     /**
      * @brief Dequeues a value from the queue (thread-safe).
-     * Implements BaseQueue::dequeue.
      * @param value Reference to store the dequeued value.
      * @return true if a value was successfully dequeued, false otherwise.
      */
-    bool dequeue(T& value) override { // 重命名并使用 override
-        EBRManager::instance().enter();
-        Node* current_head = nullptr;
-        Node* current_tail = nullptr;
-        Node* next_node = nullptr;
-
+    bool dequeue(T& value) {
+        Guard guard;
         while (true) {
-            current_head = head.load(std::memory_order_acquire);
-            current_tail = tail.load(std::memory_order_acquire);
-            next_node = current_head->next.load(std::memory_order_acquire);
+            Node* current_head = guard.protect(0, head);
+            Node* current_tail = tail.load(std::memory_order_acquire);
+            // head 未变时 next 仍在队列中，保护之后可以解引用
+            Node* next_node = guard.protect(1, current_head->next);
 
             if (current_head == head.load(std::memory_order_acquire)) {
                 if (current_head == current_tail) {
                     if (next_node == nullptr) {
-                        EBRManager::instance().leave();
                         return false; // Queue is empty
                     }
                     tail.compare_exchange_weak(
@@ -324,18 +525,13 @@ public:
                             std::memory_order_acq_rel, std::memory_order_relaxed))
                     {
                         // Dequeue successful
-                        if (next_node->data.has_value()) {
-                            value = std::move(*(next_node->data)); // Move data out
-                            next_node->data.reset();
-                        } else {
-                             // Problem: Dequeued node has no data (should be impossible unless it's the dummy node?)
-                             EBRManager::instance().leave();
-                             // This indicates a potential logic error or race we didn't handle.
-                             // For robustness, maybe return false or throw. Let's return false here.
-                             return false;
+                        if (!next_node->data.has_value()) {
+                            // 只有哑节点没有数据，走到这里说明有逻辑错误
+                            return false;
                         }
-                        EBRManager::instance().retire(current_head); // Retire the old head
-                        EBRManager::instance().leave();
+                        value = std::move(*(next_node->data)); // Move data out
+                        next_node->data.reset();
+                        guard.retire(current_head); // Retire the old head
                         return true;
                     }
                 }
@@ -345,25 +541,42 @@ public:
 
     /**
      * @brief Checks if the queue is likely empty (thread-safe, snapshot check).
-     * Implements BaseQueue::empty.
      * @return true if the queue appeared empty at the moment of check, false otherwise.
      * @warning Due to concurrency, the state might change immediately after this call.
      */
-    bool empty() const override {
-        // 需要 const_cast 来调用非 const 的 ebr.enter/leave
-        // 或者提供 const 版本的 EBR enter/leave (如果只读访问不需要更新本地纪元，但仍需保护指针读取)
-        // 这里简单用 const_cast，假设 EBR enter/leave 本身线程安全且逻辑上允许来自 const 方法
-        // 一个更好的 EBR 设计会区分读/写临界区。
-        const_cast<EBRManager&>(EBRManager::instance()).enter();
-
-        Node* current_head = head.load(std::memory_order_acquire);
+    bool empty() const {
+        Guard guard;    // guard 不依赖队列本身，const 方法里也可以构造
+        Node* current_head = guard.protect(0, head);
         // We also need tail to differentiate between empty and tail lagging
         Node* current_tail = tail.load(std::memory_order_acquire);
         Node* next_node = current_head->next.load(std::memory_order_acquire);
 
-        bool is_empty = (current_head == current_tail) && (next_node == nullptr);
+        return (current_head == current_tail) && (next_node == nullptr);
+    }
+
+    bool try_dequeue(T& value) {
+        return dequeue(value);
+    }
+
+    // 阻塞直到取出一个元素
+    void wait_dequeue(T& value) {
+        if (!dequeue(value)) {
+            not_empty_.wait_until([&]() { return dequeue(value); }, WaitDeadline::max());
+        }
+    }
+
+    // 最多等待 timeout，超时返回 false
+    bool wait_dequeue_for(T& value, std::chrono::nanoseconds timeout) {
+        return dequeue(value) || not_empty_.wait_until([&]() { return dequeue(value); }, wait_deadline(timeout));
+    }
 
-        const_cast<EBRManager&>(EBRManager::instance()).leave();
-        return is_empty;
+    // 估计值：tail 落后时会少算刚挂上的节点
+    size_t size() const {
+        Guard guard;
+        Node* current_head = guard.protect(0, head);
+        Node* current_tail = guard.protect(1, tail);
+        return current_tail->seq > current_head->seq ? static_cast<size_t>(current_tail->seq - current_head->seq) : 0;
     }
 };
+
+static_assert(BlockingQueue<MPMCQueue<int>>);
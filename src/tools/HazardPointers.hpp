@@ -0,0 +1,413 @@
+/*
+    Hazard pointers 与 hazard eras，两种不会被停住的线程拖住全部回收的策略（接口见 Reclamation.hpp）。
+
+    Hazard pointers：guard.protect 把读到的指针写进本线程的保护位，再重读一次源指针确认它仍然可达。
+    退休的节点先挂在本线程的侵入式链表上，攒够 scan_threshold() 个后扫描一次所有线程的保护位，
+    释放没有被保护的节点；扫描后仍被保护的节点较多时，下一次扫描的门槛随之翻倍，保证扫描的摊销代价是常数。一个停住的线程最多拖住 HP_PER_THREAD 个节点，代价是每次 protect 一个 fence。
+
+    Hazard eras：节点记录出生纪元和退休纪元，guard.protect 发布的是当前全局纪元而不是指针，
+    只有全局纪元变化时才需要重新发布，读路径上的 fence 比 hazard pointers 少。
+    扫描时一个节点只要生存区间 [birth, retire] 不包含任何已发布的纪元就可以释放，
+    一个停住的线程只拖住在它发布的纪元仍然存活的节点（即那一刻队列里的节点），之后分配的节点照常回收。
+    因此积压很深时，一个短暂被抢占的线程也会让一批节点多留几轮扫描，扫描门槛的翻倍同样适用。
+    全局纪元每个线程每退休 HE_ERA_ADVANCE 个节点推进一次。
+
+    两者的线程注册与 EBRManager 相同：槽位来自 ThreadSlots，线程退出时自动归还，
+    尚未能释放的节点留在槽里交给下一个占用者。
+*/
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Reclamation.hpp"
+
+static constexpr size_t HP_PER_THREAD = 3;          // 每个 guard 的保护位个数，MPMCQueue::dequeue_bulk 需要 3 个
+static constexpr size_t HP_SCAN_THRESHOLD = 128;    // 本线程退休节点达到 max(此数, 2 * 保护位总数, 2 * 上次扫描剩下的) 时扫描
+static constexpr size_t HE_ERA_ADVANCE = 64;        // 本线程每退休这么多节点推进一次全局纪元
+static constexpr uint64_t HE_NONE = UINT64_MAX;     // 保护位未发布纪元
+
+// 经 hazard pointers 回收的对象继承这个头部
+struct HazardNode {
+    HazardNode* hp_next = nullptr;
+    void (*hp_deleter)(HazardNode*) = nullptr;
+};
+
+// 经 hazard eras 回收的对象继承这个头部
+struct HazardEraNode {
+    HazardEraNode* he_next = nullptr;
+    void (*he_deleter)(HazardEraNode*) = nullptr;
+    uint64_t birth_era = 0;
+    uint64_t retire_era = 0;
+};
+
+class HazardPointerManager {
+private:
+    struct alignas(hardware_destructive_interference_size) ThreadData {
+        std::atomic<bool> in_use{false};
+        std::atomic<HazardNode*> hazards[HP_PER_THREAD] = {};
+        HazardNode* retired = nullptr;      // 只由持有槽位的线程访问
+        size_t retired_count = 0;
+        size_t next_scan = 0;               // 上次扫描剩下的节点数的两倍
+        std::vector<HazardNode*> scratch;   // 扫描时收集的保护位，复用以免每次分配
+    };
+
+    struct ThreadHandle {
+        std::shared_ptr<HazardPointerManager> manager;
+        ThreadData* slot = nullptr;
+
+        ~ThreadHandle() {
+            if (slot) {
+                manager->release_slot(slot);
+            }
+        }
+    };
+
+    ThreadSlots<ThreadData> slots_;
+
+    static ThreadHandle& handle() {
+        static thread_local ThreadHandle h;
+        return h;
+    }
+
+    void release_slot(ThreadData* data) {
+        for (auto& hazard : data->hazards) {
+            hazard.store(nullptr, std::memory_order_release);
+        }
+        scan(data);
+        slots_.release(data);
+    }
+
+    size_t scan_threshold(const ThreadData* data) const {
+        return std::max({HP_SCAN_THRESHOLD, 2 * HP_PER_THREAD * slots_.capacity(), data->next_scan});
+    }
+
+    // 释放本线程退休链表里没有被任何线程保护的节点
+    void scan(ThreadData* data) {
+        if (!data->retired) return;
+        std::atomic_thread_fence(std::memory_order_seq_cst);    // 与 protect 中的 fence 配对
+        data->scratch.clear();
+        slots_.for_each([&](const ThreadData& slot) {
+            for (const auto& hazard : slot.hazards) {
+                if (HazardNode* p = hazard.load(std::memory_order_acquire)) {
+                    data->scratch.push_back(p);
+                }
+            }
+        });
+        std::sort(data->scratch.begin(), data->scratch.end());
+
+        HazardNode* node = data->retired;
+        HazardNode* kept = nullptr;
+        size_t kept_count = 0;
+        while (node) {
+            HazardNode* next = node->hp_next;
+            if (std::binary_search(data->scratch.begin(), data->scratch.end(), node)) {
+                node->hp_next = kept;
+                kept = node;
+                kept_count++;
+            } else {
+                node->hp_deleter(node);
+            }
+            node = next;
+        }
+        data->retired = kept;
+        data->retired_count = kept_count;
+        data->next_scan = 2 * kept_count;
+    }
+
+    HazardPointerManager() = default;
+
+public:
+    static HazardPointerManager& instance() {
+        return *shared();
+    }
+
+    // 有意泄漏，从不析构，理由同 EBRManager::shared()
+    static const std::shared_ptr<HazardPointerManager>& shared() {
+        static auto* instance = new std::shared_ptr<HazardPointerManager>(new HazardPointerManager());
+        return *instance;
+    }
+
+    HazardPointerManager(const HazardPointerManager&) = delete;
+    HazardPointerManager& operator=(const HazardPointerManager&) = delete;
+
+    ThreadData* current_slot() {
+        ThreadHandle& h = handle();
+        if (!h.slot) {
+            h.manager = shared();
+            h.slot = slots_.claim();
+        }
+        return h.slot;
+    }
+
+    template <typename N>
+        requires std::derived_from<N, HazardNode>
+    N* protect(ThreadData* data, size_t index, const std::atomic<N*>& src) {
+        N* p = src.load(std::memory_order_relaxed);
+        while (true) {
+            data->hazards[index].store(p, std::memory_order_relaxed);
+            // 保护位的发布必须先于重读，否则扫描方可能在节点被摘除后仍看不到保护
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            N* again = src.load(std::memory_order_acquire);
+            if (again == p) {
+                return p;
+            }
+            p = again;
+        }
+    }
+
+    void clear(ThreadData* data) {
+        for (auto& hazard : data->hazards) {
+            hazard.store(nullptr, std::memory_order_release);
+        }
+    }
+
+    template <typename N>
+        requires std::derived_from<N, HazardNode>
+    void retire(ThreadData* data, N* ptr) {
+        if (!ptr) return;
+        ptr->hp_deleter = [](HazardNode* node) { dispose_node(static_cast<N*>(node)); };
+        ptr->hp_next = data->retired;
+        data->retired = ptr;
+        if (++data->retired_count >= scan_threshold(data)) {
+            scan(data);
+        }
+    }
+
+    size_t slot_capacity() const {
+        return slots_.capacity();
+    }
+};
+
+class HazardEraManager {
+private:
+    struct alignas(hardware_destructive_interference_size) ThreadData {
+        std::atomic<bool> in_use{false};
+        std::atomic<uint64_t> eras[HP_PER_THREAD];
+        HazardEraNode* retired = nullptr;   // 只由持有槽位的线程访问
+        size_t retired_count = 0;
+        size_t next_scan = 0;
+        size_t retired_total = 0;           // 决定何时推进全局纪元
+        std::vector<uint64_t> scratch;
+
+        ThreadData() {
+            for (auto& era : eras) {
+                era.store(HE_NONE, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    struct ThreadHandle {
+        std::shared_ptr<HazardEraManager> manager;
+        ThreadData* slot = nullptr;
+
+        ~ThreadHandle() {
+            if (slot) {
+                manager->release_slot(slot);
+            }
+        }
+    };
+
+    alignas(hardware_destructive_interference_size) std::atomic<uint64_t> era_{1};
+    ThreadSlots<ThreadData> slots_;
+
+    static ThreadHandle& handle() {
+        static thread_local ThreadHandle h;
+        return h;
+    }
+
+    void release_slot(ThreadData* data) {
+        clear(data);
+        scan(data);
+        slots_.release(data);
+    }
+
+    size_t scan_threshold(const ThreadData* data) const {
+        return std::max({HP_SCAN_THRESHOLD, 2 * HP_PER_THREAD * slots_.capacity(), data->next_scan});
+    }
+
+    // 释放生存区间内没有任何已发布纪元的节点
+    void scan(ThreadData* data) {
+        if (!data->retired) return;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        data->scratch.clear();
+        slots_.for_each([&](const ThreadData& slot) {
+            for (const auto& era : slot.eras) {
+                uint64_t e = era.load(std::memory_order_seq_cst);
+                if (e != HE_NONE) {
+                    data->scratch.push_back(e);
+                }
+            }
+        });
+        std::sort(data->scratch.begin(), data->scratch.end());
+
+        HazardEraNode* node = data->retired;
+        HazardEraNode* kept = nullptr;
+        size_t kept_count = 0;
+        while (node) {
+            HazardEraNode* next = node->he_next;
+            auto it = std::lower_bound(data->scratch.begin(), data->scratch.end(), node->birth_era);
+            if (it != data->scratch.end() && *it <= node->retire_era) {
+                node->he_next = kept;
+                kept = node;
+                kept_count++;
+            } else {
+                node->he_deleter(node);
+            }
+            node = next;
+        }
+        data->retired = kept;
+        data->retired_count = kept_count;
+        data->next_scan = 2 * kept_count;
+    }
+
+    HazardEraManager() = default;
+
+public:
+    static HazardEraManager& instance() {
+        return *shared();
+    }
+
+    // 有意泄漏，从不析构，理由同 EBRManager::shared()
+    static const std::shared_ptr<HazardEraManager>& shared() {
+        static auto* instance = new std::shared_ptr<HazardEraManager>(new HazardEraManager());
+        return *instance;
+    }
+
+    HazardEraManager(const HazardEraManager&) = delete;
+    HazardEraManager& operator=(const HazardEraManager&) = delete;
+
+    ThreadData* current_slot() {
+        ThreadHandle& h = handle();
+        if (!h.slot) {
+            h.manager = shared();
+            h.slot = slots_.claim();
+        }
+        return h.slot;
+    }
+
+    // 节点发布前记录出生纪元；之后读到它的线程发布的纪元不会比这更早
+    void init_node(HazardEraNode* node) {
+        node->birth_era = era_.load(std::memory_order_seq_cst);
+    }
+
+    template <typename N>
+        requires std::derived_from<N, HazardEraNode>
+    N* protect(ThreadData* data, size_t index, const std::atomic<N*>& src) {
+        uint64_t published = data->eras[index].load(std::memory_order_relaxed);
+        while (true) {
+            N* p = src.load(std::memory_order_seq_cst);
+            uint64_t era = era_.load(std::memory_order_seq_cst);
+            if (era == published) {
+                return p;
+            }
+            data->eras[index].store(era, std::memory_order_seq_cst);
+            published = era;
+        }
+    }
+
+    void clear(ThreadData* data) {
+        for (auto& era : data->eras) {
+            era.store(HE_NONE, std::memory_order_release);
+        }
+    }
+
+    template <typename N>
+        requires std::derived_from<N, HazardEraNode>
+    void retire(ThreadData* data, N* ptr) {
+        if (!ptr) return;
+        ptr->retire_era = era_.load(std::memory_order_seq_cst);
+        ptr->he_deleter = [](HazardEraNode* node) { dispose_node(static_cast<N*>(node)); };
+        ptr->he_next = data->retired;
+        data->retired = ptr;
+        if (++data->retired_total % HE_ERA_ADVANCE == 0) {
+            era_.fetch_add(1, std::memory_order_seq_cst);
+        }
+        if (++data->retired_count >= scan_threshold(data)) {
+            scan(data);
+        }
+    }
+
+    uint64_t era() const {
+        return era_.load(std::memory_order_relaxed);
+    }
+
+    size_t slot_capacity() const {
+        return slots_.capacity();
+    }
+};
+
+struct HazardPointerReclaimer {
+    using node_base = HazardNode;
+
+    class guard {
+    public:
+        guard() : data_(HazardPointerManager::instance().current_slot()) {}
+
+        ~guard() {
+            HazardPointerManager::instance().clear(data_);
+        }
+
+        guard(const guard&) = delete;
+        guard& operator=(const guard&) = delete;
+
+        template <typename N>
+        N* protect(size_t index, const std::atomic<N*>& src) {
+            return HazardPointerManager::instance().protect(data_, index, src);
+        }
+
+        template <typename N>
+        void retire(N* node) {
+            HazardPointerManager::instance().retire(data_, node);
+        }
+
+    private:
+        decltype(HazardPointerManager::instance().current_slot()) data_;
+    };
+
+    static void init_node(node_base*) {}
+
+    static const std::shared_ptr<HazardPointerManager>& shared() {
+        return HazardPointerManager::shared();
+    }
+};
+
+struct HazardEraReclaimer {
+    using node_base = HazardEraNode;
+
+    class guard {
+    public:
+        guard() : data_(HazardEraManager::instance().current_slot()) {}
+
+        ~guard() {
+            HazardEraManager::instance().clear(data_);
+        }
+
+        guard(const guard&) = delete;
+        guard& operator=(const guard&) = delete;
+
+        template <typename N>
+        N* protect(size_t index, const std::atomic<N*>& src) {
+            return HazardEraManager::instance().protect(data_, index, src);
+        }
+
+        template <typename N>
+        void retire(N* node) {
+            HazardEraManager::instance().retire(data_, node);
+        }
+
+    private:
+        decltype(HazardEraManager::instance().current_slot()) data_;
+    };
+
+    static void init_node(node_base* node) {
+        HazardEraManager::instance().init_node(node);
+    }
+
+    static const std::shared_ptr<HazardEraManager>& shared() {
+        return HazardEraManager::shared();
+    }
+};
@@ -0,0 +1,159 @@
+/*
+    链式队列节点的缓存池，稳态下入队不再调用 malloc/free。
+
+    每个线程有一个本地缓存（单链表，不加锁），回收器释放的节点经 N::recycle 放回释放线程的缓存；
+    本地缓存超过 2 * NODE_POOL_BATCH 个时把 NODE_POOL_BATCH 个节点整条交给共享池，取空时从共享池整条取回。
+    生产者与消费者通常不是同一批线程，节点就这样成批地从消费者流回生产者。
+
+    共享池是 NODE_POOL_SHARED_BATCHES 个槽位，每个槽位放一条节点链：放入是 CAS (nullptr -> 链)，
+    取出是 exchange(nullptr)，不需要读取链上的 next，因此没有 ABA 问题。槽位都满时多出的节点直接释放，
+    池子最多缓存 NODE_POOL_SHARED_BATCHES * NODE_POOL_BATCH 个节点加上每个线程的本地缓存。
+
+    节点空闲时借用它的 next 字段 (std::atomic<N*>) 串成链表；池里的节点保持构造状态，取出后由调用方填数据。
+    线程退出时本地缓存交回共享池，之后在该线程上归还的节点直接释放。
+*/
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+static constexpr size_t NODE_POOL_BATCH = 64;            // 本地缓存与共享池之间一次搬运的节点数
+static constexpr size_t NODE_POOL_SHARED_BATCHES = 1024; // 共享池的槽位数，最多缓存 64K 个节点
+
+template <typename N>
+class NodePool {
+public:
+    static N* acquire() {
+        Cache& c = cache();
+        if (!c.head) {
+            if (c.closed) {
+                return new N();
+            }
+            refill(c);
+        }
+        N* node = c.head;
+        c.head = node->next.load(std::memory_order_relaxed);
+        c.count--;
+        node->next.store(nullptr, std::memory_order_relaxed);
+        return node;
+    }
+
+    static void release(N* node) {
+        Cache& c = cache();
+        if (c.closed) {
+            delete node;
+            return;
+        }
+        if (!c.attached) {
+            attach(c);
+        }
+        node->next.store(c.head, std::memory_order_relaxed);
+        c.head = node;
+        if (++c.count >= 2 * NODE_POOL_BATCH) {
+            // 前 NODE_POOL_BATCH 个节点整条交给共享池
+            N* tail = c.head;
+            for (size_t i = 1; i < NODE_POOL_BATCH; ++i) {
+                tail = tail->next.load(std::memory_order_relaxed);
+            }
+            N* batch = c.head;
+            c.head = tail->next.load(std::memory_order_relaxed);
+            tail->next.store(nullptr, std::memory_order_relaxed);
+            c.count -= NODE_POOL_BATCH;
+            give_back(batch);
+        }
+    }
+
+private:
+    // 必须是平凡析构的：线程退出时回收器可能在 Flusher 析构之后仍然归还节点
+    struct Cache {
+        N* head = nullptr;
+        size_t count = 0;
+        bool attached = false;  // 已注册线程退出时的 Flusher
+        bool closed = false;
+    };
+
+    struct Flusher {
+        ~Flusher() {
+            Cache& c = cache();
+            c.closed = true;
+            if (c.head) {
+                give_back(c.head);
+            }
+            c.head = nullptr;
+            c.count = 0;
+        }
+    };
+
+    struct Shared {
+        std::atomic<N*> batches[NODE_POOL_SHARED_BATCHES] = {};
+    };
+
+    static Cache& cache() {
+        static thread_local constinit Cache c{};
+        return c;
+    }
+
+    // 平凡析构，静态析构期间归还节点也安全
+    static Shared& shared() {
+        static constinit Shared s{};
+        return s;
+    }
+
+    // 各线程从不同的槽位开始找，减少争用
+    static size_t start_slot(const Cache& c) {
+        return (reinterpret_cast<uintptr_t>(&c) / alignof(Cache)) % NODE_POOL_SHARED_BATCHES;
+    }
+
+    // 只归还不取用的线程（消费者）也要在退出时交回缓存
+    static void attach(Cache& c) {
+        static thread_local Flusher flusher;
+        (void)flusher;
+        c.attached = true;
+    }
+
+    static void refill(Cache& c) {
+        if (!c.attached) {
+            attach(c);
+        }
+        Shared& s = shared();
+        size_t start = start_slot(c);
+        for (size_t i = 0; i < NODE_POOL_SHARED_BATCHES; ++i) {
+            auto& slot = s.batches[(start + i) % NODE_POOL_SHARED_BATCHES];
+            if (slot.load(std::memory_order_relaxed)) {
+                if (N* batch = slot.exchange(nullptr, std::memory_order_acquire)) {
+                    size_t n = 0;
+                    for (N* p = batch; p; p = p->next.load(std::memory_order_relaxed)) {
+                        n++;
+                    }
+                    c.head = batch;
+                    c.count = n;
+                    return;
+                }
+            }
+        }
+        for (size_t i = 0; i < NODE_POOL_BATCH; ++i) {
+            N* node = new N();
+            node->next.store(c.head, std::memory_order_relaxed);
+            c.head = node;
+        }
+        c.count = NODE_POOL_BATCH;
+    }
+
+    static void give_back(N* batch) {
+        Shared& s = shared();
+        size_t start = start_slot(cache());
+        for (size_t i = 0; i < NODE_POOL_SHARED_BATCHES; ++i) {
+            auto& slot = s.batches[(start + i) % NODE_POOL_SHARED_BATCHES];
+            N* expected = nullptr;
+            if (!slot.load(std::memory_order_relaxed) &&
+                slot.compare_exchange_strong(expected, batch, std::memory_order_release, std::memory_order_relaxed)) {
+                return;
+            }
+        }
+        while (batch) {
+            N* next = batch->next.load(std::memory_order_relaxed);
+            delete batch;
+            batch = next;
+        }
+    }
+};
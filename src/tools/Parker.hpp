@@ -0,0 +1,163 @@
+/*
+    单消费者的自适应唤醒：消费者先自旋，仍然没有数据再挂起在 futex 上。
+
+    状态字 state_ 同时作为 futex 字：
+        RUNNING  消费者在工作或自旋，生产者什么都不用做
+        PARKED   消费者挂起等待数据，第一个看到它的生产者把状态改回 RUNNING 并 futex_wake
+        NAPPING  消费者在攒批的窗口里定时睡眠，生产者不唤醒它
+    生产者在发布数据后执行一次 seq_cst fence 再读取状态，消费者在写入 PARKED 后同样 fence 再检查数据，
+    两边至少有一方能看到对方，因此不会丢失唤醒；只有消费者确实挂起时才会产生系统调用。
+    非 Linux 平台退化为 mutex + condition_variable。
+*/
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <condition_variable>
+#include <mutex>
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+#if defined(__linux__)
+// word 仍等于 value 时睡眠，最多到 deadline（time_point::max() 表示不限时）；
+// 被唤醒、值已变化 (EAGAIN)、超时或被信号打断都会返回，调用方自己重新判断条件
+inline void futex_wait(std::atomic<uint32_t>& word, uint32_t value, std::chrono::steady_clock::time_point deadline) {
+    struct timespec ts;
+    struct timespec* pts = nullptr;
+    if (deadline != std::chrono::steady_clock::time_point::max()) {
+        auto left = deadline - std::chrono::steady_clock::now();
+        if (left <= std::chrono::nanoseconds::zero()) {
+            return;
+        }
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(left).count();
+        ts.tv_sec = static_cast<time_t>(ns / 1000000000);
+        ts.tv_nsec = static_cast<long>(ns % 1000000000);
+        pts = &ts;
+    }
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE, value, pts, nullptr, 0);
+}
+
+inline void futex_wake_all(std::atomic<uint32_t>& word) {
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "atomic<uint32_t> doubles as the futex word");
+#endif
+
+
+class Parker {
+public:
+    // 生产者：发布数据之后调用
+    void notify() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (state_.load(std::memory_order_relaxed) != PARKED) {
+            return;
+        }
+        uint32_t expected = PARKED;
+        if (state_.compare_exchange_strong(expected, RUNNING, std::memory_order_seq_cst)) {
+            wakeups_.fetch_add(1, std::memory_order_relaxed);
+            wake();
+        }
+    }
+
+    // 无条件叫醒消费者（包括攒批中的），用于停止
+    void interrupt() {
+        state_.store(RUNNING, std::memory_order_seq_cst);
+        wake();
+    }
+
+    // 消费者：最多自旋 iterations 次等待 ready() 成立
+    template <typename Pred>
+    bool spin(size_t iterations, Pred&& ready) {
+        for (size_t i = 0; i < iterations; ++i) {
+            if (ready()) {
+                return true;
+            }
+            cpu_relax();
+        }
+        return ready();
+    }
+
+    // 消费者：挂起直到 notify / interrupt，或者超时；ready() 在挂起前再检查一次
+    template <typename Pred>
+    void park(Pred&& ready, std::chrono::nanoseconds timeout = std::chrono::nanoseconds::max()) {
+        state_.store(PARKED, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!ready()) {
+            wait(PARKED, timeout);
+        }
+        state_.store(RUNNING, std::memory_order_relaxed);
+    }
+
+    // 消费者：睡眠 duration，期间生产者不唤醒，只有 interrupt 能提前结束
+    void nap(std::chrono::nanoseconds duration) {
+        uint32_t expected = RUNNING;
+        if (!state_.compare_exchange_strong(expected, NAPPING, std::memory_order_seq_cst)) {
+            return;
+        }
+        wait(NAPPING, duration);
+        expected = NAPPING;
+        state_.compare_exchange_strong(expected, RUNNING, std::memory_order_relaxed);
+    }
+
+    // 被生产者实际唤醒的次数
+    uint64_t wakeups() const {
+        return wakeups_.load(std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr uint32_t RUNNING = 0;
+    static constexpr uint32_t PARKED = 1;
+    static constexpr uint32_t NAPPING = 2;
+
+    // 在 state_ 仍等于 value 时睡眠，超时或被唤醒后返回
+    void wait(uint32_t value, std::chrono::nanoseconds timeout) {
+        auto deadline = timeout == std::chrono::nanoseconds::max()
+            ? std::chrono::steady_clock::time_point::max()
+            : std::chrono::steady_clock::now() + timeout;
+#if defined(__linux__)
+        while (state_.load(std::memory_order_acquire) == value) {
+            if (deadline != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() >= deadline) {
+                return;
+            }
+            futex_wait(state_, value, deadline);
+        }
+#else
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait_until(lock, deadline, [this, value]() {
+            return state_.load(std::memory_order_acquire) != value;
+        });
+#endif
+    }
+
+    void wake() {
+#if defined(__linux__)
+        futex_wake_all(state_);
+#else
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+        }
+        cv_.notify_all();
+#endif
+    }
+
+    alignas(64) std::atomic<uint32_t> state_{RUNNING};
+    std::atomic<uint64_t> wakeups_{0};
+#if !defined(__linux__)
+    std::mutex mutex_;
+    std::condition_variable cv_;
+#endif
+};
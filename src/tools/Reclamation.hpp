@@ -0,0 +1,121 @@
+/*
+    无锁结构的内存回收策略。
+
+    MPMCQueue 通过模板参数选择回收方式，策略对外只暴露三样东西：
+      - node_base：节点必须继承的头部，退休时不做额外分配；
+      - guard：每次操作在栈上构造一个，protect(i, src) 读出 src 并保证返回的节点在 guard 析构前不被释放，
+        retire(node) 把已摘除的节点交给回收器；
+      - init_node(node)：节点发布前调用一次（hazard eras 在这里记录出生纪元）。
+    同一线程同一时刻只应持有一个 guard。
+
+    已有的策略：
+      EBRReclaimer              纪元回收 (EBRQueue.hpp)，读路径最便宜；一个线程停在临界区里会阻塞全部回收
+      HazardPointerReclaimer    每个 guard 最多保护 HP_PER_THREAD 个节点，停住的线程只能拖住这么多节点
+      HazardEraReclaimer        保护的是纪元而不是指针，停住的线程只拖住在该纪元仍存活的节点
+
+    三种回收器都用 ThreadSlots 管理线程：槽位缓存行对齐，以块为单位只增不减，占用和归还都是一次 CAS。
+*/
+#pragma once
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+
+#include "CacheLine.hpp"
+
+static constexpr size_t RECLAIM_SLOTS_PER_CHUNK = 64;   // 线程槽位每次扩容的个数
+
+// Slot 需要有 std::atomic<bool> in_use 成员
+template <typename Slot>
+class ThreadSlots {
+private:
+    struct Chunk {
+        Slot slots[RECLAIM_SLOTS_PER_CHUNK];
+        std::atomic<Chunk*> next{nullptr};
+    };
+
+    Chunk first_chunk_;
+    std::atomic<size_t> chunk_count_{1};
+
+public:
+    ThreadSlots() = default;
+    ThreadSlots(const ThreadSlots&) = delete;
+    ThreadSlots& operator=(const ThreadSlots&) = delete;
+
+    ~ThreadSlots() {
+        Chunk* chunk = first_chunk_.next.load(std::memory_order_acquire);
+        while (chunk) {
+            Chunk* next = chunk->next.load(std::memory_order_relaxed);
+            delete chunk;
+            chunk = next;
+        }
+    }
+
+    Slot* claim() {
+        Chunk* chunk = &first_chunk_;
+        while (true) {
+            for (auto& slot : chunk->slots) {
+                bool expected = false;
+                if (!slot.in_use.load(std::memory_order_relaxed) &&
+                    slot.in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                    return &slot;
+                }
+            }
+            Chunk* next = chunk->next.load(std::memory_order_acquire);
+            if (!next) {
+                // 追加新块；其他线程抢先追加时沿用它的块，自己的丢弃
+                auto* fresh = new Chunk();
+                if (chunk->next.compare_exchange_strong(next, fresh, std::memory_order_acq_rel)) {
+                    chunk_count_.fetch_add(1, std::memory_order_relaxed);
+                    next = fresh;
+                } else {
+                    delete fresh;
+                }
+            }
+            chunk = next;
+        }
+    }
+
+    void release(Slot* slot) {
+        slot->in_use.store(false, std::memory_order_release);
+    }
+
+    // 遍历已分配的全部槽位（包括空闲的），不加锁
+    template <typename F>
+    void for_each(F&& f) {
+        for (Chunk* chunk = &first_chunk_; chunk; chunk = chunk->next.load(std::memory_order_acquire)) {
+            for (auto& slot : chunk->slots) {
+                f(slot);
+            }
+        }
+    }
+
+    size_t capacity() const {
+        return chunk_count_.load(std::memory_order_relaxed) * RECLAIM_SLOTS_PER_CHUNK;
+    }
+
+    size_t in_use() {
+        size_t n = 0;
+        for_each([&](const Slot& slot) { n += slot.in_use.load(std::memory_order_relaxed); });
+        return n;
+    }
+};
+
+// 回收器真正释放节点时调用：节点类型提供 static recycle(N*) 时交给它（例如放回 NodePool），否则 delete
+template <typename N>
+void dispose_node(N* node) {
+    if constexpr (requires { N::recycle(node); }) {
+        N::recycle(node);
+    } else {
+        delete node;
+    }
+}
+
+template <typename R>
+concept ReclamationPolicy = requires(typename R::guard& g,
+                                     const std::atomic<typename R::node_base*>& src,
+                                     typename R::node_base* node) {
+    { g.protect(0, src) } -> std::same_as<typename R::node_base*>;
+    g.retire(node);
+    R::init_node(node);
+    R::shared();    // 回收器单例，有意泄漏，静态析构期间仍可使用
+};
@@ -1,98 +1,283 @@
-#include <vector>
+/*
+    有界 MPMC 环形队列（Vyukov）。
+
+    每个槽位带一个序号，位置 pos 的槽位在 sequence == pos 时可写，在 sequence == pos + 1 时可读：
+      - 生产者读到 sequence == pos 后 CAS 推进 enqueue_pos_ 占住槽位，构造元素，再以 release 写入 pos + 1；
+      - 消费者读到 sequence == pos + 1 后 CAS 推进 dequeue_pos_，移出元素，再写入 pos + capacity 供下一圈使用。
+    元素的写入在序号发布之前，消费者读到序号 (acquire) 之后才访问元素，不会读到写了一半的槽位。
+    sequence 小于期望值说明槽位还没轮到（队列满或空），大于说明被别人抢先，重读位置再试。
+    批量操作先检查从当前位置起连续多少个槽位就绪，再用一次 CAS 把整段占下来。
+
+    容量向上取整为 2 的幂，下标用掩码计算；槽位按缓存行对齐，相邻槽位的生产者与消费者互不干扰。
+    内存在构造时一次分配，之后不再增长，满时 enqueue 等待、try_enqueue 返回 false。
+    阻塞操作（enqueue、enqueue_bulk、wait_dequeue 及其限时版本）按 Wait 策略等待（见 WaitStrategy.hpp），
+    默认 ParkingWait：短暂自旋后挂起，空闲时不占 CPU。
+    元素只需要可移动；enqueue(const T&) 只在用到时才要求元素可复制。满足 ConcurrentQueue（BaseQueue.hpp）。
+*/
+#pragma once
+#include <algorithm>
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
 #include <optional>
+#include <chrono>
+#include <type_traits>
+#include <utility>
 
 #include "BaseQueue.hpp"
+#include "CacheLine.hpp"
+#include "WaitStrategy.hpp"
 
-
-template <typename T>
-class LockFreeMPMCQueue: public BaseQueue<T> {
+template <typename T, typename Wait = ParkingWait>
+    requires WaitStrategy<Wait>
+class LockFreeMPMCQueue {
     static_assert(std::is_move_constructible_v<T>, "T must be move constructible");
-    static_assert(std::is_copy_constructible_v<T>, "T must be copy constructible");
 public:
+    using value_type = T;
+
     static LockFreeMPMCQueue& instance(size_t capacity) {
         static LockFreeMPMCQueue queue(capacity);
         return queue;
     }
 
     explicit LockFreeMPMCQueue(size_t capacity)
-        : capacity_(capacity),
-        buffer_(capacity),
-        head_(0),
-        tail_(0) {}
+        : capacity_(round_up(capacity)),
+        mask_(capacity_ - 1),
+        slots_(new Slot[capacity_]) {
+        for (size_t i = 0; i < capacity_; ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        enqueue_pos_.store(0, std::memory_order_relaxed);
+        dequeue_pos_.store(0, std::memory_order_relaxed);
+    }
 
-    bool try_enqueue(const T& value) {
-        size_t current_tail = tail_.load(std::memory_order_acquire);
-        size_t next_tail = (current_tail + 1) % capacity_;
+    // 此时不再有并发访问，析构剩余的元素
+    ~LockFreeMPMCQueue() {
+        size_t tail = enqueue_pos_.load(std::memory_order_relaxed);
+        for (size_t pos = dequeue_pos_.load(std::memory_order_relaxed); pos != tail; ++pos) {
+            Slot& slot = slots_[pos & mask_];
+            if (slot.sequence.load(std::memory_order_relaxed) == pos + 1) {
+                std::launder(reinterpret_cast<T*>(slot.storage))->~T();
+            }
+        }
+    }
 
-        size_t current_head = head_.load(std::memory_order_acquire);
-        if (next_tail == current_head) return false; // 队列满
+    LockFreeMPMCQueue(const LockFreeMPMCQueue&) = delete;
+    LockFreeMPMCQueue& operator=(const LockFreeMPMCQueue&) = delete;
 
-        if (!tail_.compare_exchange_strong(
-            current_tail, next_tail))
-        {
-            return false; // 竞争失败
+    // 队列满时返回 false，不阻塞
+    template <typename... Args>
+    bool try_emplace(Args&&... args) {
+        size_t pos;
+        if (reserve(enqueue_pos_, 0, 1, pos) == 0) {
+            return false; // 队列满
         }
-
-        buffer_[current_tail] = std::move(value);
+        Slot& slot = slots_[pos & mask_];
+        ::new (slot.storage) T(std::forward<Args>(args)...);
+        slot.sequence.store(pos + 1, std::memory_order_release);
+        not_empty_.notify();
         return true;
     }
 
-    // 阻塞式入队（新增实现）
-    void enqueue(const T& value) override {
-        while (true) {
-            // 尝试非阻塞入队
-            if (try_enqueue(value)) {
-                return;
+    bool try_enqueue(const T& value) {
+        return try_emplace(value);
+    }
+
+    bool try_enqueue(T&& value) {
+        return try_emplace(std::move(value));
+    }
+
+    // 阻塞式入队：队列满时按等待策略等待
+    void enqueue(const T& value) {
+        push_until(value, WaitDeadline::max());
+    }
+
+    void enqueue(T&& value) {
+        push_until(std::move(value), WaitDeadline::max());
+    }
+
+    // 最多等待 timeout，超时返回 false
+    bool enqueue_for(const T& value, std::chrono::nanoseconds timeout) {
+        return push_until(value, wait_deadline(timeout));
+    }
+
+    bool enqueue_for(T&& value, std::chrono::nanoseconds timeout) {
+        return push_until(std::move(value), wait_deadline(timeout));
+    }
+
+    /*
+        每次占住尽可能多的连续空槽位，满时等待；返回时全部入队。
+        能直接求出长度的迭代器（包括 C++20 中只算输入迭代器的 std::move_iterator）走批量路径，其余逐个入队。
+    */
+    template <typename InputIt>
+    void enqueue_bulk(InputIt first, InputIt last) {
+        if constexpr (!std::sized_sentinel_for<InputIt, InputIt>) {
+            for (; first != last; ++first) {
+                enqueue(*first);
+            }
+        } else {
+            size_t remaining = static_cast<size_t>(last - first);
+            while (remaining > 0) {
+                size_t pos;
+                size_t n = 0;
+                auto reserved = [&]() {
+                    n = reserve(enqueue_pos_, 0, remaining, pos);
+                    return n > 0;
+                };
+                if (!reserved()) {
+                    not_full_.wait_until(reserved, WaitDeadline::max());
+                }
+                for (size_t i = 0; i < n; ++i, ++first) {
+                    Slot& slot = slots_[(pos + i) & mask_];
+                    ::new (slot.storage) T(*first);
+                    slot.sequence.store(pos + i + 1, std::memory_order_release);
+                }
+                remaining -= n;
+                not_empty_.notify();
             }
-            std::this_thread::yield();
         }
     }
 
-    // 阻塞式出队（新增实现）
-    bool dequeue(T& value) override {
-        while (true) {
-            // 尝试非阻塞出队
-            if (auto res = try_dequeue()) {
-                value = std::move(*res);
-                return true;
-            }
-            std::this_thread::yield();
+    // 一次 CAS 取出最多 max 个连续就绪的元素
+    template <typename OutputIt>
+    size_t dequeue_bulk(OutputIt out, size_t max) {
+        size_t pos;
+        size_t n = reserve(dequeue_pos_, 1, max, pos);
+        for (size_t i = 0; i < n; ++i) {
+            Slot& slot = slots_[(pos + i) & mask_];
+            T* element = std::launder(reinterpret_cast<T*>(slot.storage));
+            *out++ = std::move(*element);
+            element->~T();
+            slot.sequence.store(pos + i + capacity_, std::memory_order_release);
         }
-        return false;
+        if (n > 0) {
+            not_full_.notify();
+        }
+        return n;
+    }
+
+    // 队列为空（或者队首的生产者还没写完）时返回 false
+    bool try_dequeue(T& value) {
+        return pop([&](T&& element) { value = std::move(element); });
     }
 
     std::optional<T> try_dequeue() {
-        size_t current_head = head_.load(std::memory_order_acquire);
-        size_t current_tail = tail_.load(std::memory_order_acquire);
+        std::optional<T> result;
+        pop([&](T&& element) { result.emplace(std::move(element)); });
+        return result;
+    }
 
-        if (current_head == current_tail) return std::nullopt; // 队列空
+    // 不阻塞，语义同 try_dequeue
+    bool dequeue(T& value) {
+        return try_dequeue(value);
+    }
 
-        size_t new_head = (current_head + 1) % capacity_;
-        if (!head_.compare_exchange_strong(
-            current_head, new_head))
-        {
-            return std::nullopt; // 竞争失败
+    // 阻塞直到取出一个元素
+    void wait_dequeue(T& value) {
+        if (!try_dequeue(value)) {
+            not_empty_.wait_until([&]() { return try_dequeue(value); }, WaitDeadline::max());
         }
+    }
 
-        T value = std::move(buffer_[current_head]);
-        return value;
+    // 最多等待 timeout，超时返回 false
+    bool wait_dequeue_for(T& value, std::chrono::nanoseconds timeout) {
+        return try_dequeue(value) ||
+               not_empty_.wait_until([&]() { return try_dequeue(value); }, wait_deadline(timeout));
     }
 
-    bool empty() const override {
-        return head_.load(std::memory_order_acquire) ==
-            tail_.load(std::memory_order_acquire);
+    // 所有已返回的 enqueue 放入的元素都已被取出时为 true；占住槽位但还没写完的生产者使它返回 false
+    bool empty() const {
+        size_t tail = enqueue_pos_.load(std::memory_order_acquire);
+        size_t head = dequeue_pos_.load(std::memory_order_acquire);
+        return head >= tail;
     }
 
     size_t size() const {
-        size_t head = head_.load(std::memory_order_acquire);
-        size_t tail = tail_.load(std::memory_order_acquire);
-        return (tail - head + capacity_) % capacity_;
+        size_t head = dequeue_pos_.load(std::memory_order_acquire);
+        size_t tail = enqueue_pos_.load(std::memory_order_acquire);
+        // 两次读取之间位置可能继续前进，估计值不超过容量
+        return tail > head ? std::min(tail - head, capacity_) : 0;
+    }
+
+    size_t capacity() const {
+        return capacity_;
     }
 
 private:
+    struct alignas(hardware_destructive_interference_size) Slot {
+        std::atomic<size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    static size_t round_up(size_t capacity) {
+        size_t n = 2;
+        while (n < capacity) {
+            n <<= 1;
+        }
+        return n;
+    }
+
+    /*
+        从 cursor 当前位置起占住最多 want 个连续就绪的槽位，返回个数，起始位置写入 pos。
+        槽位就绪指 sequence == 位置 + ready（入队 ready = 0，出队 ready = 1）；第一个槽位就没就绪时返回 0。
+        检查过的槽位在 cursor 越过它们之前不会被别人改动，CAS 成功即整段归自己所有。
+    */
+    size_t reserve(std::atomic<size_t>& cursor, size_t ready, size_t want, size_t& pos) {
+        pos = cursor.load(std::memory_order_relaxed);
+        while (want > 0) {
+            size_t seq = slots_[pos & mask_].sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + ready);
+            if (diff < 0) {
+                return 0; // 入队时队列满，出队时队列空
+            }
+            if (diff > 0) {
+                pos = cursor.load(std::memory_order_relaxed);
+                continue;
+            }
+            size_t n = 1;
+            while (n < want && slots_[(pos + n) & mask_].sequence.load(std::memory_order_acquire) == pos + n + ready) {
+                ++n;
+            }
+            if (cursor.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed)) {
+                return n;
+            }
+        }
+        return 0;
+    }
+
+    // try_emplace 只在占到槽位后才构造元素，失败时 value 原样保留，可以反复尝试
+    template <typename U>
+    bool push_until(U&& value, WaitDeadline deadline) {
+        return try_emplace(std::forward<U>(value)) ||
+               not_full_.wait_until([&]() { return try_emplace(std::forward<U>(value)); }, deadline);
+    }
+
+    // 取出队首元素交给 take，之后析构槽位里的元素并把槽位留给下一圈
+    template <typename F>
+    bool pop(F&& take) {
+        size_t pos;
+        if (reserve(dequeue_pos_, 1, 1, pos) == 0) {
+            return false; // 队列空
+        }
+        Slot& slot = slots_[pos & mask_];
+        T* element = std::launder(reinterpret_cast<T*>(slot.storage));
+        take(std::move(*element));
+        element->~T();
+        slot.sequence.store(pos + capacity_, std::memory_order_release);
+        not_full_.notify();
+        return true;
+    }
+
     const size_t capacity_;
-    std::vector<T> buffer_;
-    alignas(std::hardware_destructive_interference_size) std::atomic<size_t> head_;
-    alignas(std::hardware_destructive_interference_size) std::atomic<size_t> tail_;
-};
\ No newline at end of file
+    const size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    alignas(hardware_destructive_interference_size) std::atomic<size_t> enqueue_pos_;
+    alignas(hardware_destructive_interference_size) std::atomic<size_t> dequeue_pos_;
+    [[no_unique_address]] Wait not_empty_;     // 消费者等待元素
+    [[no_unique_address]] Wait not_full_;      // 生产者等待空槽位
+};
+
+static_assert(BlockingQueue<LockFreeMPMCQueue<int>>);
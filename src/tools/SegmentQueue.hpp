@@ -0,0 +1,355 @@
+/*
+    无界 MPMC 队列：固定大小的段（SEGMENT_QUEUE_SLOTS 个槽位）串成链表，段内的下标用 fetch_add 分配
+    （FAA array queue，与 LCRQ / LPRQ 同一族）。生产者之间、消费者之间只在各自的下标上做一次 FAA，
+    不像 Michael-Scott 队列那样所有生产者在同一个 tail 上重试 CAS，核数增加时吞吐基本线性增长。
+
+    槽位状态 EMPTY -> READY（生产者写完）或 EMPTY -> TAKEN（消费者作废）：
+      - 生产者 FAA 得到下标后把元素构造进槽位，再 CAS EMPTY -> READY 发布；CAS 失败说明消费者已经作废
+        这个槽位，把元素移回来换一个下标重试；
+      - 消费者 FAA 得到下标后等生产者写完，短暂自旋 (SEGMENT_QUEUE_TAKE_SPINS) 后仍未写完就 CAS EMPTY -> TAKEN
+        作废它，避免被一个被抢占的生产者拖住；读到 READY 就取走元素。
+    段写满后第一个溢出的生产者挂上新段（新段的第 0 个槽位直接放它的元素）；消费者取完一段后先帮 tail 越过它，
+    再把 head 移到下一段并退休旧段，因此 head 不会越过 tail。段经 Reclaimer 回收（见 Reclamation.hpp），
+    每个 guard 最多同时保护两个段。
+
+    只用单字长的原子操作，不需要 LCRQ 的双字 CAS；段不像 LPRQ 那样循环复用，每 SEGMENT_QUEUE_SLOTS 次入队
+    分配一次。批量操作一次 FAA 占住一段连续的下标。满足 BlockingQueue（BaseQueue.hpp），try_enqueue 总是成功。
+*/
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "BaseQueue.hpp"
+#include "CacheLine.hpp"
+#include "EBRQueue.hpp"
+#include "Reclamation.hpp"
+#include "WaitStrategy.hpp"
+
+static constexpr size_t SEGMENT_QUEUE_SLOTS = 1024;     // 每段的槽位数
+static constexpr int SEGMENT_QUEUE_TAKE_SPINS = 64;     // 消费者等待已占位的生产者写完的自旋次数，之后作废该槽位
+
+template <typename T, typename Reclaimer = EBRReclaimer, typename Wait = ParkingWait>
+    requires std::movable<T> && ReclamationPolicy<Reclaimer> && WaitStrategy<Wait>
+class SegmentQueue {
+private:
+    static constexpr uint32_t EMPTY = 0;
+    static constexpr uint32_t READY = 1;
+    static constexpr uint32_t TAKEN = 2;
+
+    struct alignas(hardware_destructive_interference_size) Slot {
+        std::atomic<uint32_t> state{EMPTY};
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* element() {
+            return std::launder(reinterpret_cast<T*>(storage));
+        }
+    };
+
+    struct Segment : Reclaimer::node_base {
+        alignas(hardware_destructive_interference_size) std::atomic<size_t> enq_idx{0};
+        alignas(hardware_destructive_interference_size) std::atomic<size_t> deq_idx{0};
+        alignas(hardware_destructive_interference_size) std::atomic<Segment*> next{nullptr};
+        uint64_t id = 0;    // 段在队列中的序号，发布前写入，size() 据此换算位置
+        Slot slots[SEGMENT_QUEUE_SLOTS];
+
+        // 回收器释放或队列析构时调用，此时没有并发访问：析构还没被取走的元素
+        ~Segment() {
+            for (auto& slot : slots) {
+                if (slot.state.load(std::memory_order_relaxed) == READY) {
+                    slot.element()->~T();
+                }
+            }
+        }
+    };
+
+    using Guard = typename Reclaimer::guard;
+
+    alignas(hardware_destructive_interference_size) std::atomic<Segment*> head_;
+    alignas(hardware_destructive_interference_size) std::atomic<Segment*> tail_;
+    [[no_unique_address]] Wait not_empty_;
+
+public:
+    using value_type = T;
+    using reclaimer_type = Reclaimer;
+
+    SegmentQueue() {
+        auto* first = new Segment();
+        Reclaimer::init_node(first);
+        head_.store(first, std::memory_order_relaxed);
+        tail_.store(first, std::memory_order_relaxed);
+    }
+
+    // 此时不再有并发访问，链上剩下的段连同其中的元素直接释放
+    ~SegmentQueue() {
+        Segment* seg = head_.load(std::memory_order_relaxed);
+        while (seg) {
+            Segment* next = seg->next.load(std::memory_order_relaxed);
+            delete seg;
+            seg = next;
+        }
+    }
+
+    static SegmentQueue& instance() {
+        static SegmentQueue queue;
+        return queue;
+    }
+
+    SegmentQueue(const SegmentQueue&) = delete;
+    SegmentQueue& operator=(const SegmentQueue&) = delete;
+
+    void enqueue(const T& value) {
+        push(value);
+    }
+
+    void enqueue(T&& value) {
+        push(std::move(value));
+    }
+
+    // 无界队列，总能入队
+    bool try_enqueue(const T& value) {
+        push(value);
+        return true;
+    }
+
+    bool try_enqueue(T&& value) {
+        push(std::move(value));
+        return true;
+    }
+
+    bool enqueue_for(const T& value, std::chrono::nanoseconds) {
+        push(value);
+        return true;
+    }
+
+    bool enqueue_for(T&& value, std::chrono::nanoseconds) {
+        push(std::move(value));
+        return true;
+    }
+
+    // 一次 FAA 占住尽可能多的连续下标；某个槽位被作废时其余下标也放弃，保持批内顺序
+    template <typename InputIt>
+    void enqueue_bulk(InputIt first, InputIt last) {
+        if constexpr (!std::sized_sentinel_for<InputIt, InputIt>) {
+            for (; first != last; ++first) {
+                push(*first);
+            }
+        } else {
+            size_t count = static_cast<size_t>(last - first);
+            if (count > 0) {
+                insert(first, count);
+                not_empty_.notify();
+            }
+        }
+    }
+
+    bool dequeue(T& value) {
+        return dequeue_bulk(&value, 1) == 1;
+    }
+
+    bool try_dequeue(T& value) {
+        return dequeue(value);
+    }
+
+    // 阻塞直到取出一个元素
+    void wait_dequeue(T& value) {
+        if (!dequeue(value)) {
+            not_empty_.wait_until([&]() { return dequeue(value); }, WaitDeadline::max());
+        }
+    }
+
+    // 最多等待 timeout，超时返回 false
+    bool wait_dequeue_for(T& value, std::chrono::nanoseconds timeout) {
+        return dequeue(value) || not_empty_.wait_until([&]() { return dequeue(value); }, wait_deadline(timeout));
+    }
+
+    // 按当前段里已分配给生产者的下标数一次 FAA 占住最多 max 个，队列为空时返回 0
+    template <typename OutputIt>
+    size_t dequeue_bulk(OutputIt out, size_t max) {
+        size_t n = 0;
+        Guard guard;
+        while (n < max) {
+            Segment* seg = guard.protect(0, head_);
+            size_t deq = seg->deq_idx.load(std::memory_order_acquire);
+            size_t enq = std::min(seg->enq_idx.load(std::memory_order_acquire), SEGMENT_QUEUE_SLOTS);
+            if (deq >= enq) {
+                if (deq < SEGMENT_QUEUE_SLOTS) {
+                    break;  // 这一段还没写满，生产者没有分配更多下标：队列为空
+                }
+                // 这一段已取完，移到下一段
+                Segment* next = seg->next.load(std::memory_order_acquire);
+                if (next == nullptr) {
+                    break;
+                }
+                Segment* tail = seg;    // CAS 失败会改写期望值，下面还要用 seg
+                tail_.compare_exchange_strong(tail, next, std::memory_order_release, std::memory_order_relaxed);
+                if (head_.compare_exchange_strong(seg, next, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                    guard.retire(seg);
+                }
+                continue;
+            }
+            size_t want = std::min(max - n, enq - deq);
+            size_t idx = seg->deq_idx.fetch_add(want, std::memory_order_acq_rel);
+            size_t end = std::min(idx + want, SEGMENT_QUEUE_SLOTS);
+            for (; idx < end; ++idx) {
+                if (take(seg->slots[idx], out)) {
+                    ++n;
+                }
+            }
+        }
+        return n;
+    }
+
+    // 有生产者占了下标但还没写完时也不算空，满足 ConcurrentQueue 对 empty 的约定
+    bool empty() const {
+        Guard guard;
+        Segment* seg = guard.protect(0, head_);
+        size_t deq = std::min(seg->deq_idx.load(std::memory_order_acquire), SEGMENT_QUEUE_SLOTS);
+        size_t enq = std::min(seg->enq_idx.load(std::memory_order_acquire), SEGMENT_QUEUE_SLOTS);
+        return deq >= enq && seg->next.load(std::memory_order_acquire) == nullptr;
+    }
+
+    // 估计值：按段序号与段内下标换算出首尾位置
+    size_t size() const {
+        Guard guard;
+        Segment* head = guard.protect(0, head_);
+        Segment* tail = guard.protect(1, tail_);
+        uint64_t deq = head->id * SEGMENT_QUEUE_SLOTS +
+                       std::min(head->deq_idx.load(std::memory_order_acquire), SEGMENT_QUEUE_SLOTS);
+        uint64_t enq = tail->id * SEGMENT_QUEUE_SLOTS +
+                       std::min(tail->enq_idx.load(std::memory_order_acquire), SEGMENT_QUEUE_SLOTS);
+        return enq > deq ? static_cast<size_t>(enq - deq) : 0;
+    }
+
+private:
+    template <typename U>
+    void push(U&& value) {
+        T item(std::forward<U>(value));
+        insert_one(item);
+        not_empty_.notify();    // 在 guard 之外，可能的 futex 唤醒不延长临界区
+    }
+
+    // 单个元素：槽位被作废或新段没挂上时元素留在 item 里，换个下标重试
+    void insert_one(T& item) {
+        Guard guard;
+        while (true) {
+            Segment* seg = guard.protect(0, tail_);
+            size_t idx = seg->enq_idx.fetch_add(1, std::memory_order_acq_rel);
+            if (idx >= SEGMENT_QUEUE_SLOTS ? append_segment(seg, item) : place(seg->slots[idx], item)) {
+                return;
+            }
+        }
+    }
+
+    /*
+        依次入队从 first 开始的 count 个元素。当前元素先取到 item 里，放进槽位失败时移回 item，
+        迭代器只读一次。
+    */
+    template <typename It>
+    void insert(It first, size_t count) {
+        T item(*first);
+        ++first;
+        Guard guard;
+        while (true) {
+            Segment* seg = guard.protect(0, tail_);
+            size_t idx = seg->enq_idx.fetch_add(count, std::memory_order_acq_rel);
+            if (idx >= SEGMENT_QUEUE_SLOTS) {
+                if (append_segment(seg, item)) {
+                    if (--count == 0) {
+                        return;
+                    }
+                    item = *first;
+                    ++first;
+                }
+                continue;
+            }
+            size_t end = std::min(idx + count, SEGMENT_QUEUE_SLOTS);
+            for (; idx < end; ++idx) {
+                if (!place(seg->slots[idx], item)) {
+                    break;
+                }
+                if (--count == 0) {
+                    return;     // 占到的下标正好用完
+                }
+                item = *first;
+                ++first;
+            }
+            // 剩下占到的下标作废，后面的元素换新下标，不会越过还没放进去的元素
+            for (++idx; idx < end; ++idx) {
+                uint32_t expected = EMPTY;
+                seg->slots[idx].state.compare_exchange_strong(expected, TAKEN, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // 失败（槽位已被作废）时元素移回 item
+    static bool place(Slot& slot, T& item) {
+        ::new (slot.storage) T(std::move(item));
+        uint32_t expected = EMPTY;
+        if (slot.state.compare_exchange_strong(expected, READY, std::memory_order_release, std::memory_order_relaxed)) {
+            return true;
+        }
+        T* element = slot.element();
+        item = std::move(*element);
+        element->~T();
+        return false;
+    }
+
+    // 生产者迟迟没有写完时作废槽位，返回 false
+    template <typename OutputIt>
+    static bool take(Slot& slot, OutputIt& out) {
+        uint32_t state = slot.state.load(std::memory_order_acquire);
+        for (int i = 0; state == EMPTY && i < SEGMENT_QUEUE_TAKE_SPINS; ++i) {
+            cpu_relax();
+            state = slot.state.load(std::memory_order_acquire);
+        }
+        if (state == EMPTY &&
+            slot.state.compare_exchange_strong(state, TAKEN, std::memory_order_acquire, std::memory_order_acquire)) {
+            return false;
+        }
+        if (state == TAKEN) {
+            return false;   // 批量入队的生产者放弃了这个下标
+        }
+        T* element = slot.element();
+        *out++ = std::move(*element);
+        element->~T();
+        slot.state.store(TAKEN, std::memory_order_relaxed);
+        return true;
+    }
+
+    // seg 已写满：挂一个以 item 开头的新段；其他线程先挂上时帮 tail 前进，item 原样保留，返回 false
+    bool append_segment(Segment* seg, T& item) {
+        if (seg != tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        Segment* next = seg->next.load(std::memory_order_acquire);
+        if (next == nullptr) {
+            auto* fresh = new Segment();
+            fresh->id = seg->id + 1;
+            Reclaimer::init_node(fresh);
+            Slot& slot = fresh->slots[0];
+            ::new (slot.storage) T(std::move(item));
+            slot.state.store(READY, std::memory_order_relaxed);
+            fresh->enq_idx.store(1, std::memory_order_relaxed);
+            if (seg->next.compare_exchange_strong(next, fresh, std::memory_order_release, std::memory_order_acquire)) {
+                tail_.compare_exchange_strong(seg, fresh, std::memory_order_release, std::memory_order_relaxed);
+                return true;
+            }
+            item = std::move(*slot.element());
+            slot.element()->~T();
+            slot.state.store(EMPTY, std::memory_order_relaxed);
+            delete fresh;
+        }
+        tail_.compare_exchange_strong(seg, next, std::memory_order_release, std::memory_order_relaxed);
+        return false;
+    }
+};
+
+static_assert(BlockingQueue<SegmentQueue<int>>);
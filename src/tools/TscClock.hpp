@@ -0,0 +1,184 @@
+/*
+    基于 TSC 的廉价时钟。
+
+    热路径 (LogEntry 构造、RPC 计时) 只执行一次 rdtsc，不经过 vDSO；换算成纳秒或墙上时间的工作
+    放在读取方 (flush 线程、请求结束时)：
+      - 时长：周期差乘以 ns_per_tick，启动时用 steady_clock 标定，之后随基线变长不断修正；
+      - 墙上时间：锚点 (tsc, system_clock) 由 flush 线程每 TSC_CLOCK_REANCHOR_INTERVAL 重新取一次，
+        校时 (NTP 步进) 在下一个锚点生效。锚点以 seqlock 发布，读取方不加锁。
+    CPU 不支持不变 TSC (constant/nonstop) 或非 x86 平台时，读数退化为 steady_clock 的纳秒数，接口不变。
+*/
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+static constexpr auto TSC_CLOCK_CALIBRATION = std::chrono::milliseconds(2);     // 首次使用时的标定时长
+static constexpr auto TSC_CLOCK_REANCHOR_INTERVAL = std::chrono::seconds(1);
+
+
+class TscClock {
+public:
+    // 一次时钟读数，只在本进程内有意义；跨进程保存时先换成墙上时间
+    struct time_point {
+        uint64_t ticks = 0;
+
+        bool operator==(const time_point&) const = default;
+    };
+
+    static time_point now() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+        if (state().invariant) {
+            return {__rdtsc()};
+        }
+#endif
+        return {static_cast<uint64_t>(steady_ns())};
+    }
+
+    // 周期数与时长互换，按当前标定
+    static std::chrono::nanoseconds to_duration(int64_t ticks) noexcept {
+        return std::chrono::nanoseconds(static_cast<int64_t>(static_cast<double>(ticks) * ns_per_tick()));
+    }
+
+    static int64_t to_ticks(std::chrono::nanoseconds d) noexcept {
+        return static_cast<int64_t>(static_cast<double>(d.count()) / ns_per_tick());
+    }
+
+    static std::chrono::nanoseconds elapsed(time_point since, time_point until = now()) noexcept {
+        return to_duration(static_cast<int64_t>(until.ticks - since.ticks));
+    }
+
+    static long long elapsed_ms(time_point since) noexcept {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(elapsed(since)).count();
+    }
+
+    static time_point minus(time_point t, std::chrono::nanoseconds d) noexcept {
+        return {t.ticks - static_cast<uint64_t>(to_ticks(d))};
+    }
+
+    static std::chrono::system_clock::time_point to_system(time_point t) noexcept {
+        State& s = state();
+        uint64_t anchor_tsc;
+        int64_t anchor_ns;
+        uint32_t seq;
+        do {
+            seq = s.seq.load(std::memory_order_acquire);
+            anchor_tsc = s.anchor_tsc.load(std::memory_order_relaxed);
+            anchor_ns = s.anchor_system_ns.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((seq & 1) != 0 || seq != s.seq.load(std::memory_order_relaxed));
+        int64_t ns = anchor_ns + to_duration(static_cast<int64_t>(t.ticks - anchor_tsc)).count();
+        return std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(ns)));
+    }
+
+    static time_point from_system(std::chrono::system_clock::time_point tp) noexcept {
+        time_point anchor = now();
+        auto delta = std::chrono::duration_cast<std::chrono::nanoseconds>(tp - to_system(anchor));
+        return {anchor.ticks + static_cast<uint64_t>(to_ticks(delta))};
+    }
+
+    // flush 线程每批调用一次；到期时只有一个调用者真正重取锚点
+    static void maybe_reanchor() noexcept {
+        State& s = state();
+        uint64_t current = now().ticks;
+        uint64_t due = s.next_anchor.load(std::memory_order_relaxed);
+        if (current < due || !s.next_anchor.compare_exchange_strong(due, UINT64_MAX, std::memory_order_acquire)) {
+            return;
+        }
+        reanchor(s);
+    }
+
+    static bool invariant_tsc() noexcept {
+        return state().invariant;
+    }
+
+    static double ns_per_tick() noexcept {
+        return state().ns_per_tick.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct State {
+        bool invariant = false;
+        uint64_t base_tsc = 0;          // 标定基线
+        int64_t base_steady_ns = 0;
+        std::atomic<double> ns_per_tick{1.0};
+        std::atomic<uint32_t> seq{0};
+        std::atomic<uint64_t> anchor_tsc{0};
+        std::atomic<int64_t> anchor_system_ns{0};
+        std::atomic<uint64_t> next_anchor{0};
+
+        State() {
+#if defined(__x86_64__) || defined(__i386__)
+            unsigned eax, ebx, ecx, edx;
+            invariant = __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && (edx & (1u << 8)) != 0;
+#endif
+            if (invariant) {
+#if defined(__x86_64__) || defined(__i386__)
+                base_tsc = __rdtsc();
+                base_steady_ns = steady_ns();
+                std::this_thread::sleep_for(TSC_CLOCK_CALIBRATION);
+                uint64_t tsc = __rdtsc();
+                int64_t ns = steady_ns();
+                if (tsc > base_tsc) {
+                    ns_per_tick.store(static_cast<double>(ns - base_steady_ns) / static_cast<double>(tsc - base_tsc),
+                                      std::memory_order_relaxed);
+                } else {
+                    invariant = false;
+                }
+#endif
+            }
+            reanchor(*this);
+        }
+    };
+
+    static State& state() noexcept {
+        static State s;
+        return s;
+    }
+
+    static int64_t steady_ns() noexcept {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // 基线越长标定越准：用启动以来的 TSC 与 steady_clock 增量重算斜率，再取新的墙上时间锚点
+    static void reanchor(State& s) noexcept {
+        uint64_t tsc = 0;
+        int64_t system_ns = 0;
+        if (s.invariant) {
+#if defined(__x86_64__) || defined(__i386__)
+            tsc = __rdtsc();
+            int64_t steady = steady_ns();
+            system_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            if (tsc > s.base_tsc && steady > s.base_steady_ns) {
+                s.ns_per_tick.store(static_cast<double>(steady - s.base_steady_ns) / static_cast<double>(tsc - s.base_tsc),
+                                    std::memory_order_relaxed);
+            }
+#endif
+        } else {
+            tsc = static_cast<uint64_t>(steady_ns());
+            system_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+        uint32_t seq = s.seq.load(std::memory_order_relaxed);
+        s.seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        s.anchor_tsc.store(tsc, std::memory_order_relaxed);
+        s.anchor_system_ns.store(system_ns, std::memory_order_relaxed);
+        s.seq.store(seq + 2, std::memory_order_release);
+
+        uint64_t interval = static_cast<uint64_t>(to_ticks_with(s, TSC_CLOCK_REANCHOR_INTERVAL));
+        s.next_anchor.store(tsc + interval, std::memory_order_release);
+    }
+
+    static int64_t to_ticks_with(State& s, std::chrono::nanoseconds d) noexcept {
+        return static_cast<int64_t>(static_cast<double>(d.count()) / s.ns_per_tick.load(std::memory_order_relaxed));
+    }
+};
@@ -0,0 +1,193 @@
+/*
+    队列阻塞操作的等待策略。队列每个等待方向持有一个策略对象（有界队列两个：not_empty_ / not_full_），
+    策略只暴露两个操作：
+      - wait_until(ready, deadline)：反复调用 ready() 直到它返回 true（返回 true）或到达 deadline（返回 false）；
+        ready() 本身可以是一次 try 操作，成功即表示等待结束；deadline 为 time_point::max() 时不限时，也不读时钟；
+      - notify()：另一方改变了队列状态（放入元素或腾出槽位）之后调用。
+    只有 ParkingWait 真正挂起线程，其余策略的 notify 是空函数，入队出队路径上没有任何额外开销。
+
+    已有的策略：
+      BusySpinWait      一直自旋，唤醒延迟最低，等待期间独占一个核；线程数超过核数时会饿死正在干活的线程
+      SpinYieldWait     自旋 WAIT_SPIN_LIMIT 次后每次让出 CPU，空闲时仍会被反复调度
+      BackoffWait       自旋次数指数增长，之后睡眠时间指数增长到 WAIT_BACKOFF_MAX_SLEEP，空闲时几乎不占 CPU，
+                        代价是唤醒最多晚一个睡眠周期
+      ParkingWait       自旋 WAIT_SPIN_LIMIT 次后挂起在 futex 上，空闲时不占 CPU，被 notify 立即唤醒；
+                        notify 在没有等待者时只是一次 fence 和读取
+*/
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <thread>
+#if !defined(__linux__)
+#include <condition_variable>
+#include <mutex>
+#endif
+
+#include "CacheLine.hpp"
+#include "Parker.hpp"
+
+static constexpr int WAIT_SPIN_LIMIT = 128;                                 // 让出或挂起之前的自旋次数
+static constexpr int WAIT_BACKOFF_MAX_SPINS = 1024;                         // 指数退避的最长一轮自旋
+static constexpr std::chrono::microseconds WAIT_BACKOFF_MAX_SLEEP{1000};    // 指数退避的最长一次睡眠
+
+using WaitDeadline = std::chrono::steady_clock::time_point;
+
+// 超时换算成截止时间；不限时或者过大的超时都得到 time_point::max()
+inline WaitDeadline wait_deadline(std::chrono::nanoseconds timeout) {
+    auto now = std::chrono::steady_clock::now();
+    if (timeout >= WaitDeadline::max() - now) {
+        return WaitDeadline::max();
+    }
+    return now + std::chrono::duration_cast<WaitDeadline::duration>(timeout);
+}
+
+inline bool wait_expired(WaitDeadline deadline) {
+    return deadline != WaitDeadline::max() && std::chrono::steady_clock::now() >= deadline;
+}
+
+template <typename W>
+concept WaitStrategy = requires(W& w, bool (*ready)(), WaitDeadline deadline) {
+    { w.wait_until(ready, deadline) } -> std::same_as<bool>;
+    w.notify();
+};
+
+struct BusySpinWait {
+    template <typename Pred>
+    bool wait_until(Pred&& ready, WaitDeadline deadline) {
+        while (!ready()) {
+            if (wait_expired(deadline)) {
+                return false;
+            }
+            cpu_relax();
+        }
+        return true;
+    }
+
+    void notify() {}
+};
+
+struct SpinYieldWait {
+    template <typename Pred>
+    bool wait_until(Pred&& ready, WaitDeadline deadline) {
+        for (int spins = 0; !ready(); ++spins) {
+            if (wait_expired(deadline)) {
+                return false;
+            }
+            if (spins < WAIT_SPIN_LIMIT) {
+                cpu_relax();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        return true;
+    }
+
+    void notify() {}
+};
+
+struct BackoffWait {
+    template <typename Pred>
+    bool wait_until(Pred&& ready, WaitDeadline deadline) {
+        int spins = 1;
+        std::chrono::microseconds sleep{1};
+        while (!ready()) {
+            if (wait_expired(deadline)) {
+                return false;
+            }
+            if (spins <= WAIT_BACKOFF_MAX_SPINS) {
+                for (int i = 0; i < spins; ++i) {
+                    cpu_relax();
+                }
+                spins *= 2;
+            } else {
+                if (deadline == WaitDeadline::max()) {
+                    std::this_thread::sleep_for(sleep);
+                } else {
+                    std::this_thread::sleep_until(std::min(deadline, std::chrono::steady_clock::now() + sleep));
+                }
+                sleep = std::min(sleep * 2, WAIT_BACKOFF_MAX_SLEEP);
+            }
+        }
+        return true;
+    }
+
+    void notify() {}
+};
+
+/*
+    多个等待者共用一个 futex 字 epoch_。等待者先登记 (waiters_ 加一，seq_cst)，再检查条件，仍不满足时
+    在 epoch_ 上睡眠；notify 方在改变队列状态后执行 seq_cst fence 再读 waiters_，有等待者时推进 epoch_ 并唤醒全部。
+    两边至少有一方能看到对方：要么等待者看到新状态，要么 notify 看到等待者，而等待者睡眠前读到的 epoch
+    已经过期，futex 立即返回，因此不会丢失唤醒。
+*/
+class ParkingWait {
+public:
+    ParkingWait() = default;
+    ParkingWait(const ParkingWait&) = delete;
+    ParkingWait& operator=(const ParkingWait&) = delete;
+
+    template <typename Pred>
+    bool wait_until(Pred&& ready, WaitDeadline deadline) {
+        for (int i = 0; i < WAIT_SPIN_LIMIT; ++i) {
+            if (ready()) {
+                return true;
+            }
+            cpu_relax();
+        }
+        while (true) {
+            uint32_t epoch = epoch_.load(std::memory_order_acquire);
+            waiters_.fetch_add(1, std::memory_order_seq_cst);
+            if (ready()) {
+                waiters_.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+            if (wait_expired(deadline)) {
+                waiters_.fetch_sub(1, std::memory_order_relaxed);
+                return false;
+            }
+            sleep(epoch, deadline);
+            waiters_.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    void notify() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+        epoch_.fetch_add(1, std::memory_order_release);
+#if defined(__linux__)
+        futex_wake_all(epoch_);
+#else
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+        }
+        cv_.notify_all();
+#endif
+    }
+
+private:
+    void sleep(uint32_t epoch, WaitDeadline deadline) {
+#if defined(__linux__)
+        futex_wait(epoch_, epoch, deadline);
+#else
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait_until(lock, deadline, [this, epoch]() {
+            return epoch_.load(std::memory_order_acquire) != epoch;
+        });
+#endif
+    }
+
+    alignas(hardware_destructive_interference_size) std::atomic<uint32_t> epoch_{0};
+    std::atomic<uint32_t> waiters_{0};
+#if !defined(__linux__)
+    std::mutex mutex_;
+    std::condition_variable cv_;
+#endif
+};
+
+static_assert(WaitStrategy<BusySpinWait> && WaitStrategy<SpinYieldWait> &&
+              WaitStrategy<BackoffWait> && WaitStrategy<ParkingWait>);
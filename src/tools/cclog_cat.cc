@@ -0,0 +1,50 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "logger/LogFileReader.hpp"
+
+// 输出日志文件内容，.txt 与 .txt.zst 透明处理
+int main(int argc, char** argv) {
+    uint64_t offset = 0;
+    uint64_t length = UINT64_MAX;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        try {
+            if (arg.rfind("--offset=", 0) == 0) {
+                offset = std::stoull(arg.substr(9));
+            } else if (arg.rfind("--length=", 0) == 0) {
+                length = std::stoull(arg.substr(9));
+            } else {
+                files.push_back(arg);
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Invalid argument '" << arg << "': " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    if (files.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [--offset=<bytes>] [--length=<bytes>] <log_file>...\n"
+                  << "  <log_file> may be a plain <n>.txt or a compressed <n>.txt.zst" << std::endl;
+        return 1;
+    }
+
+    constexpr size_t chunk = 1024 * 1024;
+    for (const auto& file : files) {
+        try {
+            LogFileReader reader(file);
+            uint64_t end = length == UINT64_MAX ? reader.size() : std::min(reader.size(), offset + length);
+            for (uint64_t pos = offset; pos < end; pos += chunk) {
+                std::string data = reader.read_at(pos, static_cast<size_t>(std::min<uint64_t>(chunk, end - pos)));
+                std::cout.write(data.data(), static_cast<std::streamsize>(data.size()));
+            }
+        } catch (const std::exception& e) {
+            std::cerr << file << ": " << e.what() << std::endl;
+            return 2;
+        }
+    }
+    return 0;
+}
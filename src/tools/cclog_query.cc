@@ -0,0 +1,338 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "logger/LogAggregator.hpp"
+#include "logger/LogFileReader.hpp"
+#include "logger/LogIndex.hpp"
+
+namespace fs = std::filesystem;
+
+struct Query {
+    std::string uuid;       // 非空时只输出该请求的记录
+    bool errors = false;    // 只输出 ERROR 记录
+    int64_t from = std::numeric_limits<int64_t>::min();
+    int64_t to = std::numeric_limits<int64_t>::max();
+
+    bool match(std::string_view line) const {
+        if (!uuid.empty() && LogLine::uuid_of(line) != uuid) {
+            return false;
+        }
+        if (errors && !LogLine::is_error(line)) {
+            return false;
+        }
+        if (from != std::numeric_limits<int64_t>::min() || to != std::numeric_limits<int64_t>::max()) {
+            int64_t second;
+            if (!LogLine::time_of(line, second) || second < from || second > to) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+struct Stats {
+    size_t files = 0;
+    size_t files_skipped = 0;   // 布隆过滤器或时间范围排除的文件
+    uint64_t bytes_total = 0;
+    uint64_t bytes_scanned = 0;
+    size_t matches = 0;
+};
+
+// 日志内容：普通文件直接 mmap，压缩文件经 LogFileReader 只解压用到的帧
+class LogContent {
+public:
+    explicit LogContent(const std::string& path) {
+        if (path.size() > 4 && path.compare(path.size() - 4, 4, ".zst") == 0) {
+            reader_ = std::make_unique<LogFileReader>(path);
+            size_ = reader_->size();
+            return;
+        }
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to open log file: " + path);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+            size_ = static_cast<uint64_t>(st.st_size);
+            void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("Failed to mmap log file: " + path);
+            }
+            base_ = static_cast<const char*>(p);
+            ::madvise(p, size_, MADV_RANDOM);
+        }
+        ::close(fd);
+    }
+
+    ~LogContent() {
+        if (base_) {
+            ::munmap(const_cast<char*>(base_), size_);
+        }
+    }
+
+    uint64_t size() const {
+        return size_;
+    }
+
+    // [offset, offset + len) 的内容，压缩文件返回的视图在下一次调用前有效
+    std::string_view range(uint64_t offset, uint64_t len) {
+        len = std::min(len, size_ - std::min(offset, size_));
+        if (!reader_) {
+            return base_ ? std::string_view(base_ + offset, static_cast<size_t>(len)) : std::string_view();
+        }
+        buffer_ = reader_->read_at(offset, static_cast<size_t>(len));
+        return buffer_;
+    }
+
+private:
+    std::unique_ptr<LogFileReader> reader_;
+    const char* base_ = nullptr;
+    uint64_t size_ = 0;
+    std::string buffer_;
+};
+
+struct Range {
+    uint64_t offset;
+    uint64_t length;
+};
+
+// 由索引挑出需要扫描的区间；索引之后尚未建索引的部分总要扫描
+static std::vector<Range> candidate_ranges(const std::string& path, const Query& q, uint64_t size) {
+    std::vector<Range> ranges;
+    LogIndexView index(path);
+    if (!index.valid()) {
+        ranges.push_back({0, size});
+        return ranges;
+    }
+    uint64_t covered = std::min(index.covered_bytes(), size);
+    if (q.uuid.empty() || index.may_contain(q.uuid)) {
+        const LogIndexBucket* buckets = index.buckets();
+        for (size_t i = 0; i < index.bucket_count(); ++i) {
+            const LogIndexBucket& b = buckets[i];
+            if (b.max_second < q.from || b.min_second > q.to || (q.errors && b.errors == 0)) {
+                continue;
+            }
+            if (!ranges.empty() && ranges.back().offset + ranges.back().length == b.offset) {
+                ranges.back().length += b.length;
+            } else {
+                ranges.push_back({b.offset, b.length});
+            }
+        }
+    }
+    if (covered < size) {
+        ranges.push_back({covered, size - covered});
+    }
+    return ranges;
+}
+
+static void scan(std::string_view data, const Query& q, Stats& stats) {
+    if (!q.uuid.empty()) {
+        // 直接查找 uuid 文本，命中后再取整行校验
+        size_t pos = 0;
+        while ((pos = data.find(q.uuid, pos)) != std::string_view::npos) {
+            size_t begin = data.rfind('\n', pos);
+            begin = begin == std::string_view::npos ? 0 : begin + 1;
+            size_t end = data.find('\n', pos);
+            end = end == std::string_view::npos ? data.size() : end;
+            std::string_view line = data.substr(begin, end - begin);
+            if (q.match(line)) {
+                std::cout << line << '\n';
+                stats.matches++;
+            }
+            pos = end;
+        }
+        return;
+    }
+    size_t pos = 0;
+    while (pos < data.size()) {
+        size_t end = data.find('\n', pos);
+        end = end == std::string_view::npos ? data.size() : end;
+        std::string_view line = data.substr(pos, end - pos);
+        if (q.match(line)) {
+            std::cout << line << '\n';
+            stats.matches++;
+        }
+        pos = end + 1;
+    }
+}
+
+static void query_file(const std::string& path, const Query& q, Stats& stats) {
+    LogContent content(path);
+    stats.files++;
+    stats.bytes_total += content.size();
+    std::vector<Range> ranges = candidate_ranges(path, q, content.size());
+    if (ranges.empty()) {
+        stats.files_skipped++;
+        return;
+    }
+    constexpr uint64_t chunk = 16 * 1024 * 1024;   // 压缩文件分块解压；区间都从行首开始
+    for (const auto& r : ranges) {
+        uint64_t offset = r.offset;
+        uint64_t end = r.offset + r.length;
+        while (offset < end) {
+            std::string_view data = content.range(offset, std::min(chunk, end - offset));
+            if (data.empty()) {
+                break;
+            }
+            if (offset + data.size() < end) {
+                size_t last = data.rfind('\n');
+                if (last != std::string_view::npos) {
+                    data = data.substr(0, last + 1);
+                }
+            }
+            scan(data, q, stats);
+            stats.bytes_scanned += data.size();
+            offset += data.size();
+        }
+    }
+}
+
+// 按日期目录剪枝：目录名是日期且与查询时间不相交时跳过
+static bool date_dir_excluded(const fs::path& dir, const Query& q) {
+    int64_t day;
+    std::string name = dir.filename().string();
+    if (!LogLine::parse_time(name, day)) {
+        return false;
+    }
+    return day + 86399 < q.from || day > q.to;
+}
+
+static void collect(const fs::path& path, const Query& q, std::vector<fs::path>& files) {
+    auto is_log = [](const fs::path& p) {
+        std::string name = p.filename().string();
+        return name.ends_with(".txt") || name.ends_with(".txt.zst");
+    };
+    std::error_code ec;
+    if (!fs::is_directory(path, ec)) {
+        files.push_back(path);
+        return;
+    }
+    if (date_dir_excluded(path, q)) {
+        return;
+    }
+    for (const auto& entry : fs::directory_iterator(path, ec)) {
+        if (entry.is_directory()) {
+            collect(entry.path(), q, files);
+        } else if (entry.is_regular_file() && is_log(entry.path())) {
+            files.push_back(entry.path());
+        }
+    }
+}
+
+// 按索引查询日志文件，例如：
+//   cclog_query uuid 3f2a...-... /var/log/cccloud
+//   cclog_query --from=2025-01-01_12:00:00 --to=2025-01-01_12:05:00 errors /var/log/cccloud
+//   cclog_query rollups /var/log/cccloud/rollups/2025-01-01.rollup
+int main(int argc, char** argv) {
+    Query q;
+    bool print_stats = false;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--from=", 0) == 0 || arg.rfind("--to=", 0) == 0) {
+            bool from = arg[2] == 'f';
+            std::string value = arg.substr(from ? 7 : 5);
+            int64_t second;
+            if (!LogLine::parse_time(value, second)) {
+                std::cerr << "Invalid time '" << value << "', expected YYYY-MM-DD[_HH:MM:SS]" << std::endl;
+                return 1;
+            }
+            // 只给日期的 --to 表示当天结束
+            if (from) {
+                q.from = second;
+            } else {
+                q.to = value.size() == 10 ? second + 86399 : second;
+            }
+        } else if (arg == "--stats") {
+            print_stats = true;
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    if (args.size() >= 2 && args[0] == "rollups") {
+        // 按秒聚合的落盘结果 (LogAggregator)，只支持时间过滤
+        for (size_t i = 1; i < args.size(); ++i) {
+            try {
+                for (const auto& row : LogAggregator::read_file(args[i])) {
+                    std::string line = LogAggregator::describe(row);
+                    int64_t second;
+                    if (LogLine::parse_time(std::string_view(line).substr(0, LOG_LINE_TIME_LEN), second) &&
+                        second >= q.from && second <= q.to) {
+                        std::cout << line;
+                    }
+                }
+            } catch (const std::exception& e) {
+                std::cerr << args[i] << ": " << e.what() << std::endl;
+                return 2;
+            }
+        }
+        return 0;
+    }
+
+    size_t first_path = 0;
+    if (args.size() >= 3 && args[0] == "uuid") {
+        q.uuid = args[1];
+        std::transform(q.uuid.begin(), q.uuid.end(), q.uuid.begin(), [](unsigned char c) { return std::tolower(c); });
+        first_path = 2;
+    } else if (args.size() >= 2 && args[0] == "errors") {
+        q.errors = true;
+        first_path = 1;
+    } else {
+        std::cerr << "Usage: " << argv[0] << " [--from=T] [--to=T] [--stats] <query> <log_dir|log_file>...\n"
+                  << "  <query>: uuid <uuid>   all records of one request\n"
+                  << "           errors        ERROR records\n"
+                  << "           rollups       per-second rollups, paths are <date>.rollup files\n"
+                  << "  T: YYYY-MM-DD or YYYY-MM-DD_HH:MM:SS (local time, as printed in the log)" << std::endl;
+        return 1;
+    }
+
+    std::vector<fs::path> files;
+    for (size_t i = first_path; i < args.size(); ++i) {
+        collect(args[i], q, files);
+    }
+    // 同一目录内按文件名长度再按字典序，即 1.txt < 2.txt < 10.txt
+    std::sort(files.begin(), files.end(), [](const fs::path& a, const fs::path& b) {
+        auto key = [](const fs::path& p) {
+            std::string name = p.filename().string();
+            if (name.ends_with(".zst")) {
+                name.resize(name.size() - 4);
+            }
+            return std::make_tuple(p.parent_path().string(), name.size(), name);
+        };
+        return key(a) < key(b);
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    Stats stats;
+    for (const auto& file : files) {
+        try {
+            query_file(file.string(), q, stats);
+        } catch (const std::exception& e) {
+            std::cerr << file.string() << ": " << e.what() << std::endl;
+        }
+    }
+    std::cout.flush();
+    if (print_stats) {
+        auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cerr << stats.matches << " records, " << stats.files << " files (" << stats.files_skipped
+                  << " skipped by index), scanned " << stats.bytes_scanned << " of " << stats.bytes_total
+                  << " bytes in " << ms << " ms" << std::endl;
+    }
+    return 0;
+}
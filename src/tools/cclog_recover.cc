@@ -0,0 +1,43 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "logger/LogFormatter.hpp"
+#include "logger/MmapLogQueue.hpp"
+
+// 导出崩溃安全日志环中尚未写入日志文件的记录，格式与正常日志文件相同。只读，不修改环文件。
+int main(int argc, char** argv) {
+    bool count_only = false;
+    std::vector<std::string> rings;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--count") {
+            count_only = true;
+        } else {
+            rings.push_back(arg);
+        }
+    }
+
+    if (rings.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [--count] <ring_file>...\n"
+                  << "  <ring_file> is the file passed to MmapLogQueue (access.ring, access.ring.shard<k>, ...)" << std::endl;
+        return 1;
+    }
+
+    for (const auto& ring : rings) {
+        try {
+            std::vector<LogEntry> entries;
+            size_t n = MmapLogQueue::read_unflushed(ring, entries);
+            if (count_only) {
+                std::cout << ring << ": " << n << " unflushed entries" << std::endl;
+            } else {
+                std::cout << LogFormatter::format(entries);
+            }
+        } catch (const std::exception& e) {
+            std::cerr << ring << ": " << e.what() << std::endl;
+            return 2;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,529 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <new>
+#include <sys/resource.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "tools/EBRQueue.hpp"
+#include "tools/RingBuffer.hpp"
+#include "tools/SegmentQueue.hpp"
+
+constinit int seconds = 5;
+constinit int producers = 4;
+constinit int consumers = 4;
+constinit long memory_cap_mb = 2048;   // 停住线程的场景下 RSS 增长超过此值时提前结束
+constinit size_t ring_capacity = 65536;
+constinit int latency_sample = 16;      // 争用测试中每个生产者每隔这么多次入队测一次耗时
+
+// 统计测量期间的堆分配次数，payload 是 uint64_t，分配几乎都来自队列节点
+static std::atomic<uint64_t> allocations{0};
+
+// 替换后的 new/delete 本来就是 malloc/free 配对，GCC 在 -O2 内联之后仍会误报 -Wmismatched-new-delete
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+#pragma GCC diagnostic pop
+
+static long rss_kb() {
+    long pages = 0;
+    long resident = 0;
+    FILE* f = std::fopen("/proc/self/statm", "r");
+    if (f) {
+        if (std::fscanf(f, "%ld %ld", &pages, &resident) != 2) {
+            resident = 0;
+        }
+        std::fclose(f);
+    }
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+struct Result {
+    double mops = 0;
+    double allocs_per_op = 0;
+    long growth_mb = 0;
+    bool capped = false;
+};
+
+// 生产者和消费者并发跑 seconds 秒；stall 为 true 时另有一个线程进入临界区后一直不出来
+template <typename Reclaimer>
+static Result run(bool stall) {
+    MPMCQueue<uint64_t, Reclaimer> queue;
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> produced{0};
+    std::atomic<uint64_t> consumed{0};
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < producers; ++i) {
+        threads.emplace_back([&, i]() {
+            uint64_t n = static_cast<uint64_t>(i) << 48;
+            while (running.load(std::memory_order_relaxed)) {
+                // 积压过多时让出，测量的是回收而不是积压
+                if (produced.load(std::memory_order_relaxed) - consumed.load(std::memory_order_relaxed) > 10000) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                queue.enqueue(n++);
+                produced.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    for (int i = 0; i < consumers; ++i) {
+        threads.emplace_back([&]() {
+            uint64_t value;
+            while (running.load(std::memory_order_relaxed)) {
+                if (queue.dequeue(value)) {
+                    consumed.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::seconds(1));  // 预热
+    long baseline = rss_kb();
+    uint64_t start_count = consumed.load();
+    uint64_t start_allocations = allocations.load();
+    auto start = std::chrono::steady_clock::now();
+    if (stall) {
+        // 模拟一次操作中途被抢占的线程：持有 guard，保护一个节点后不再前进
+        threads.emplace_back([&]() {
+            struct Anchor : Reclaimer::node_base {};
+            static Anchor anchor;
+            std::atomic<Anchor*> src{&anchor};
+            typename Reclaimer::guard guard;
+            guard.protect(0, src);
+            while (running.load(std::memory_order_relaxed)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        });
+    }
+
+    Result result;
+    long peak = baseline;
+    auto deadline = start + std::chrono::seconds(seconds);
+    while (std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        peak = std::max(peak, rss_kb());
+        if ((peak - baseline) / 1024 > memory_cap_mb) {
+            result.capped = true;
+            break;
+        }
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t ops = consumed.load() - start_count;
+    uint64_t allocated = allocations.load() - start_allocations;
+    running = false;
+    for (auto& t : threads) {
+        t.join();
+    }
+    result.mops = static_cast<double>(ops) / elapsed / 1e6;
+    result.allocs_per_op = ops ? static_cast<double>(allocated) / static_cast<double>(ops) : 0;
+    result.growth_mb = (peak - baseline) / 1024;
+    return result;
+}
+
+// 每个场景在子进程里跑，RSS 不受前一个场景已分配内存的影响
+template <typename Reclaimer>
+static void bench(const char* name) {
+    for (bool stall : {false, true}) {
+        std::cout.flush();
+        pid_t pid = fork();
+        if (pid == 0) {
+            Result r = run<Reclaimer>(stall);
+            std::cout << std::left << std::setw(8) << name << std::setw(10) << (stall ? "stalled" : "normal")
+                      << std::right << std::setw(10) << std::fixed << std::setprecision(2) << r.mops
+                      << std::setw(12) << r.growth_mb << std::setw(12) << std::setprecision(4) << r.allocs_per_op
+                      << (r.capped ? "  (capped)" : "") << std::endl;
+            _exit(0);
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+    }
+}
+
+struct ContentionResult {
+    double mops = 0;
+    long growth_mb = 0;
+    bool capped = false;
+    uint64_t p50_ns = 0;
+    uint64_t p99_ns = 0;
+    uint64_t p999_ns = 0;
+    uint64_t max_ns = 0;
+};
+
+// 大量生产者不加节流地入队：有界队列满时生产者等待，无界队列积压增长
+template <typename Queue>
+static ContentionResult run_contention(Queue& queue) {
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> consumed{0};
+    // 样本缓冲区预先分配并写过一遍，不计入 RSS 增长；写满后循环覆盖
+    std::vector<std::vector<uint64_t>> samples(producers, std::vector<uint64_t>(1 << 14, UINT64_MAX));
+    std::vector<std::thread> threads;
+
+    long baseline = rss_kb();
+    for (int i = 0; i < producers; ++i) {
+        threads.emplace_back([&, i]() {
+            auto& mine = samples[i];
+            size_t next = 0;
+            uint64_t n = 0;
+            while (running.load(std::memory_order_relaxed)) {
+                if (++n % latency_sample == 0) {
+                    auto t0 = std::chrono::steady_clock::now();
+                    queue.enqueue(n);
+                    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0);
+                    mine[next++ % mine.size()] = static_cast<uint64_t>(ns.count());
+                } else {
+                    queue.enqueue(n);
+                }
+            }
+        });
+    }
+    for (int i = 0; i < consumers; ++i) {
+        threads.emplace_back([&]() {
+            uint64_t value;
+            while (running.load(std::memory_order_relaxed)) {
+                if (queue.dequeue(value)) {
+                    consumed.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+
+    ContentionResult result;
+    long peak = baseline;
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::seconds(seconds);
+    while (std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        peak = std::max(peak, rss_kb());
+        if ((peak - baseline) / 1024 > memory_cap_mb) {
+            result.capped = true;
+            break;
+        }
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t ops = consumed.load();
+    running = false;
+    // 有界队列满时生产者在 enqueue 里等待，先把队列取空让它们退出
+    std::thread drainer([&]() {
+        uint64_t value;
+        for (int i = 0; i < 100; ++i) {
+            while (queue.dequeue(value));
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    for (auto& t : threads) {
+        t.join();
+    }
+    drainer.join();
+
+    std::vector<uint64_t> all;
+    for (auto& v : samples) {
+        std::copy_if(v.begin(), v.end(), std::back_inserter(all), [](uint64_t ns) { return ns != UINT64_MAX; });
+    }
+    std::sort(all.begin(), all.end());
+    auto pct = [&](double q) { return all.empty() ? 0 : all[std::min(all.size() - 1, static_cast<size_t>(q * all.size()))]; };
+    result.mops = static_cast<double>(ops) / elapsed / 1e6;
+    result.growth_mb = (peak - baseline) / 1024;
+    result.p50_ns = pct(0.5);
+    result.p99_ns = pct(0.99);
+    result.p999_ns = pct(0.999);
+    result.max_ns = all.empty() ? 0 : all.back();
+    return result;
+}
+
+template <typename Queue, typename... Args>
+static void contend(const char* name, Args... args) {
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid == 0) {
+        Queue queue(args...);
+        ContentionResult r = run_contention(queue);
+        std::cout << std::left << std::setw(12) << name << std::right << std::setw(10) << std::fixed
+                  << std::setprecision(2) << r.mops << std::setw(10) << r.growth_mb << std::setw(10) << r.p50_ns
+                  << std::setw(10) << r.p99_ns << std::setw(10) << r.p999_ns << std::setw(12) << r.max_ns
+                  << (r.capped ? "  (capped)" : "") << std::endl;
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+}
+
+// 生产者每次入队 batch 个、消费者每次最多取 batch 个，batch 为 1 时走单元素接口
+template <typename Queue>
+static double run_bulk(Queue& queue, size_t batch) {
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> produced{0};
+    std::atomic<uint64_t> consumed{0};
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < producers; ++i) {
+        threads.emplace_back([&]() {
+            std::vector<uint64_t> values(batch);
+            uint64_t n = 0;
+            while (running.load(std::memory_order_relaxed)) {
+                if (produced.load(std::memory_order_relaxed) - consumed.load(std::memory_order_relaxed) > 10000) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                if (batch == 1) {
+                    queue.enqueue(n++);
+                } else {
+                    for (auto& v : values) {
+                        v = n++;
+                    }
+                    queue.enqueue_bulk(values.begin(), values.end());
+                }
+                produced.fetch_add(batch, std::memory_order_relaxed);
+            }
+        });
+    }
+    for (int i = 0; i < consumers; ++i) {
+        threads.emplace_back([&]() {
+            std::vector<uint64_t> values(batch);
+            while (running.load(std::memory_order_relaxed)) {
+                size_t n = 0;
+                if (batch == 1) {
+                    n = queue.dequeue(values[0]) ? 1 : 0;
+                } else {
+                    n = queue.dequeue_bulk(values.begin(), batch);
+                }
+                consumed.fetch_add(n, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::seconds(1));  // 预热
+    uint64_t start_count = consumed.load();
+    auto start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t ops = consumed.load() - start_count;
+    running = false;
+    // 有界队列满时生产者在 enqueue 里等待，先把队列取空让它们退出
+    std::thread drainer([&]() {
+        uint64_t value;
+        for (int i = 0; i < 100; ++i) {
+            while (queue.dequeue(value));
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    for (auto& t : threads) {
+        t.join();
+    }
+    drainer.join();
+    return static_cast<double>(ops) / elapsed / 1e6;
+}
+
+template <typename Queue, typename... Args>
+static void bulk(const char* name, Args... args) {
+    for (size_t batch : {size_t{1}, size_t{32}}) {
+        std::cout.flush();
+        pid_t pid = fork();
+        if (pid == 0) {
+            Queue queue(args...);
+            double mops = run_bulk(queue, batch);
+            std::cout << std::left << std::setw(12) << name << std::right << std::setw(8) << batch
+                      << std::setw(10) << std::fixed << std::setprecision(2) << mops << std::endl;
+            _exit(0);
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+    }
+}
+
+static double cpu_seconds() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+           static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+struct WaitResult {
+    double idle_cpu = 0;    // 空闲的一秒里整个进程占用的 CPU 比例
+    uint64_t p50_us = 0;
+    uint64_t p99_us = 0;
+    double mops = 0;
+};
+
+// 同一个等待策略下：消费者阻塞在空队列上的 CPU 占用、每毫秒一条时的唤醒延迟，以及小容量环满载时的吞吐
+template <typename Wait>
+static WaitResult run_wait() {
+    using Clock = std::chrono::steady_clock;
+    WaitResult result;
+    {
+        LockFreeMPMCQueue<int64_t, Wait> queue(1024);
+        std::vector<uint64_t> latencies;
+        std::thread consumer([&]() {
+            int64_t sent;
+            while (true) {
+                queue.wait_dequeue(sent);
+                if (sent < 0) {
+                    break;
+                }
+                latencies.push_back(static_cast<uint64_t>((Clock::now().time_since_epoch().count() - sent) / 1000));
+            }
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        double cpu = cpu_seconds();
+        auto start = Clock::now();
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        result.idle_cpu = (cpu_seconds() - cpu) / std::chrono::duration<double>(Clock::now() - start).count();
+        for (int i = 0; i < 200; ++i) {
+            queue.enqueue(Clock::now().time_since_epoch().count());
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        queue.enqueue(-1);
+        consumer.join();
+        std::sort(latencies.begin(), latencies.end());
+        result.p50_us = latencies[latencies.size() / 2];
+        result.p99_us = latencies[latencies.size() * 99 / 100];
+    }
+
+    LockFreeMPMCQueue<int64_t, Wait> queue(1024);
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> consumed{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < producers; ++i) {
+        threads.emplace_back([&]() {
+            int64_t n = 0;
+            while (running.load(std::memory_order_relaxed)) {
+                queue.enqueue_for(n++, std::chrono::milliseconds(10));
+            }
+        });
+    }
+    for (int i = 0; i < consumers; ++i) {
+        threads.emplace_back([&]() {
+            int64_t value;
+            while (running.load(std::memory_order_relaxed)) {
+                if (queue.wait_dequeue_for(value, std::chrono::milliseconds(10))) {
+                    consumed.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+    auto start = Clock::now();
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    result.mops = static_cast<double>(consumed.load()) / std::chrono::duration<double>(Clock::now() - start).count() / 1e6;
+    running = false;
+    for (auto& t : threads) {
+        t.join();
+    }
+    return result;
+}
+
+template <typename Wait>
+static void wait_bench(const char* name) {
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid == 0) {
+        WaitResult r = run_wait<Wait>();
+        std::cout << std::left << std::setw(10) << name << std::right << std::setw(10) << std::fixed
+                  << std::setprecision(1) << r.idle_cpu * 100 << std::setw(12) << r.p50_us << std::setw(12)
+                  << r.p99_us << std::setw(10) << std::setprecision(2) << r.mops << std::endl;
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+}
+
+// 比较 MPMCQueue 在不同回收策略下的吞吐、每次出队的堆分配次数，以及一个线程停在临界区里时的内存增长，例如：
+//   bench_queue 5 4 4
+// contention 模式比较有界环形队列、MPMCQueue 与分段 FAA 队列 SegmentQueue 在大量生产者下的吞吐、内存与入队延迟：
+//   bench_queue contention 5 128 4
+// bulk 模式比较单元素接口与 enqueue_bulk / dequeue_bulk（每批 32 个）的吞吐：
+//   bench_queue bulk 5 4 4
+// wait 模式比较环形队列在各等待策略下的空闲 CPU、唤醒延迟与满载吞吐（忙等策略需要线程数不超过核数）：
+//   bench_queue wait 5 4 4
+int main(int argc, char* argv[]) {
+    std::string mode = argc >= 2 ? argv[1] : "";
+    bool contention = mode == "contention";
+    bool batched = mode == "bulk";
+    bool waiting = mode == "wait";
+    int first = contention || batched || waiting ? 2 : 1;
+    if (contention) {
+        producers = 128;
+    }
+    if (argc >= first + 1) {
+        seconds = std::stoi(argv[first]);
+    }
+    if (argc >= first + 3) {
+        producers = std::stoi(argv[first + 1]);
+        consumers = std::stoi(argv[first + 2]);
+    }
+
+    if (contention) {
+        std::cout << "================ Queue Contention Benchmark ================" << std::endl;
+        std::cout << "Seconds: " << seconds << ", producers: " << producers << ", consumers: " << consumers
+                  << ", ring capacity: " << ring_capacity << std::endl;
+        std::cout << std::left << std::setw(12) << "queue" << std::right << std::setw(10) << "Mops/s"
+                  << std::setw(10) << "RSS +MB" << std::setw(10) << "p50 ns" << std::setw(10) << "p99 ns"
+                  << std::setw(10) << "p99.9 ns" << std::setw(12) << "max ns" << std::endl;
+        contend<LockFreeMPMCQueue<uint64_t>>("ring", ring_capacity);
+        contend<MPMCQueue<uint64_t>>("mpmc-ebr");
+        contend<MPMCQueue<uint64_t, HazardPointerReclaimer>>("mpmc-hp");
+        contend<SegmentQueue<uint64_t>>("segment");
+        std::cout << "============================================================" << std::endl;
+        return 0;
+    }
+
+    if (waiting) {
+        std::cout << "================ Queue Wait Strategy Benchmark ================" << std::endl;
+        std::cout << "Seconds: " << seconds << ", producers: " << producers << ", consumers: " << consumers << std::endl;
+        std::cout << std::left << std::setw(10) << "strategy" << std::right << std::setw(10) << "idle CPU%"
+                  << std::setw(12) << "wake p50 us" << std::setw(12) << "wake p99 us" << std::setw(10) << "Mops/s"
+                  << std::endl;
+        wait_bench<ParkingWait>("parking");
+        wait_bench<BackoffWait>("backoff");
+        wait_bench<SpinYieldWait>("yield");
+        wait_bench<BusySpinWait>("spin");
+        std::cout << "===============================================================" << std::endl;
+        return 0;
+    }
+
+    if (batched) {
+        std::cout << "================ Queue Bulk Benchmark ================" << std::endl;
+        std::cout << "Seconds: " << seconds << ", producers: " << producers << ", consumers: " << consumers << std::endl;
+        std::cout << std::left << std::setw(12) << "queue" << std::right << std::setw(8) << "batch"
+                  << std::setw(10) << "Mops/s" << std::endl;
+        bulk<LockFreeMPMCQueue<uint64_t>>("ring", ring_capacity);
+        bulk<MPMCQueue<uint64_t>>("mpmc-ebr");
+        bulk<MPMCQueue<uint64_t, HazardPointerReclaimer>>("mpmc-hp");
+        bulk<SegmentQueue<uint64_t>>("segment");
+        std::cout << "======================================================" << std::endl;
+        return 0;
+    }
+
+    std::cout << "================ MPMCQueue Reclamation Benchmark ================" << std::endl;
+    std::cout << "Seconds: " << seconds << ", producers: " << producers << ", consumers: " << consumers << std::endl;
+    std::cout << std::left << std::setw(8) << "policy" << std::setw(10) << "scenario" << std::right
+              << std::setw(10) << "Mops/s" << std::setw(12) << "RSS +MB" << std::setw(12) << "allocs/op" << std::endl;
+    bench<EBRReclaimer>("ebr");
+    bench<HazardPointerReclaimer>("hp");
+    bench<HazardEraReclaimer>("he");
+    std::cout << "=================================================================" << std::endl;
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <future>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "logger/async_logger.hpp"
+
+constinit int producers = 4;
+constinit int rounds = 5;
+constinit int timeout_ms = 3000;
+constinit int backlog = 4 * LOGENTRY_BATCH_THRESHOLD;
+
+// 每批多花一点时间，flush 线程取不空队列
+class SlowSink : public LogSink {
+public:
+    bool write(std::string_view) override {
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+        return true;
+    }
+};
+
+// 生产者持续写入、队列一直非空时，WRITTEN / SYNCED 的完成句柄仍要在超时前完成
+int main(int argc, char* argv[]) {
+    if (argc >= 2) {
+        producers = std::stoi(argv[1]);
+    }
+    if (argc >= 3) {
+        rounds = std::stoi(argv[2]);
+    }
+
+    std::string dir = (std::filesystem::temp_directory_path() / "cccloud_test_durability").string();
+    std::filesystem::remove_all(dir);
+    bool ok = true;
+    {
+        auto& logger = AsyncLogger<MPMCQueue<LogEntry>>::named("durability", LoggerOptions{dir, 1});
+        logger.add_sink(std::make_shared<SlowSink>(), false);
+
+        std::cout << "================ Durability Test ================" << std::endl;
+        std::cout << "Producers: " << producers << ", rounds: " << rounds << ", timeout: " << timeout_ms << " ms"
+                  << std::endl;
+        std::atomic<bool> running{true};
+        std::vector<std::thread> threads;
+        for (int i = 0; i < producers; ++i) {
+            threads.emplace_back([&, i]() {
+                for (int j = 0; running.load(std::memory_order_relaxed); ++j) {
+                    // 积压保持在 backlog 条左右：flush 线程每批都取不空队列，积压也不会无限增长
+                    while (j % 64 == 0 && logger.stats().depth > static_cast<uint64_t>(backlog) &&
+                           running.load(std::memory_order_relaxed)) {
+                        std::this_thread::yield();
+                    }
+                    LogEntry le;
+                    le.set_params("load " + std::to_string(i) + " " + std::to_string(j));
+                    logger.append(std::move(le));
+                }
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));    // 让积压建立起来
+
+        for (int r = 0; r < rounds; ++r) {
+            for (Durability level : {Durability::WRITTEN, Durability::SYNCED}) {
+                LogEntry le;
+                le.set_params("durable " + std::to_string(r));
+                auto start = std::chrono::steady_clock::now();
+                LogCompletion completion = logger.append(std::move(le), level);
+                bool done = completion.wait_for(std::chrono::milliseconds(timeout_ms));
+                auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+                std::cout << (level == Durability::WRITTEN ? "WRITTEN" : "SYNCED ") << " round " << r << ": "
+                          << (!done ? "TIMED OUT" : completion.failed() ? "FAILED" :
+                              "completed in " + std::to_string(ms.count()) + " ms") << std::endl;
+                ok = ok && done && !completion.failed();
+            }
+        }
+
+        running = false;
+        for (auto& t : threads) {
+            t.join();
+        }
+        logger.stop();
+    }
+    {
+        // 经 QueueAdapter 包装的队列同样可以作为 logger 的队列
+        auto& logger = AsyncLogger<QueueAdapter<MPMCQueue<LogEntry>>>::named("durability-adapter", LoggerOptions{dir, 2});
+        LogEntry le;
+        le.set_params("durable through adapter");
+        LogCompletion completion = logger.append(std::move(le), Durability::SYNCED);
+        bool done = completion.wait_for(std::chrono::milliseconds(timeout_ms)) && !completion.failed();
+        std::cout << "SYNCED  through QueueAdapter: " << (done ? "completed" : "FAILED") << std::endl;
+        ok = ok && done;
+        logger.stop();
+    }
+    {
+        // 没有日志文件时不能报告已写出 / 已落盘
+        auto& logger = AsyncLogger<MPMCQueue<LogEntry>>::named("durability-nofile", LoggerOptions{dir, 1, false});
+        for (Durability level : {Durability::WRITTEN, Durability::SYNCED}) {
+            LogEntry le;
+            le.set_params("durable without file");
+            LogCompletion completion = logger.append(std::move(le), level);
+            bool failed = completion.wait_for(std::chrono::milliseconds(timeout_ms)) && completion.failed();
+            std::promise<bool> durable;
+            LogEntry cb;
+            cb.set_params("durable callback without file");
+            logger.append(std::move(cb), level, [&](bool done) { durable.set_value(done); });
+            auto result = durable.get_future();
+            bool reported = result.wait_for(std::chrono::milliseconds(timeout_ms)) == std::future_status::ready &&
+                            !result.get();
+            std::cout << (level == Durability::WRITTEN ? "WRITTEN" : "SYNCED ") << " without file: "
+                      << (failed && reported ? "failed as expected" : "NOT REPORTED AS FAILED") << std::endl;
+            ok = ok && failed && reported;
+        }
+        logger.stop();
+    }
+    std::filesystem::remove_all(dir);
+    std::cout << (ok ? "Test passed." : "Test FAILED.") << std::endl;
+    std::cout << "=================================================" << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include "tools/EBRQueue.hpp"
+
+constinit int seconds = 30;
+constinit int producers = 8;
+constinit int consumers = 2;
+constinit long max_growth_mb = 64;    // 预热之后允许的 RSS 增长
+
+static long rss_kb() {
+    long pages = 0;
+    long resident = 0;
+    FILE* f = std::fopen("/proc/self/statm", "r");
+    if (f) {
+        if (std::fscanf(f, "%ld %ld", &pages, &resident) != 2) {
+            resident = 0;
+        }
+        std::fclose(f);
+    }
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// 长时间并发入队/出队，检查 EBR 能持续回收节点、RSS 保持平稳
+int main(int argc, char* argv[]) {
+    if (argc >= 2) {
+        seconds = std::stoi(argv[1]);
+    }
+    if (argc >= 4) {
+        producers = std::stoi(argv[2]);
+        consumers = std::stoi(argv[3]);
+    }
+
+    MPMCQueue<std::string> queue;
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> produced{0};
+    std::atomic<uint64_t> consumed{0};
+    std::vector<std::thread> threads;
+
+    std::cout << "================ EBR Soak Test ================" << std::endl;
+    std::cout << "Seconds: " << seconds << ", producers: " << producers << ", consumers: " << consumers << std::endl;
+    for (int i = 0; i < producers; ++i) {
+        threads.emplace_back([&, i]() {
+            std::string payload(48, static_cast<char>('a' + i % 26));   // 超出 SSO，节点和数据都在堆上
+            while (running.load(std::memory_order_relaxed)) {
+                // 队列积压过多时让出，测量的是回收而不是积压
+                if (produced.load(std::memory_order_relaxed) - consumed.load(std::memory_order_relaxed) > 100000) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                queue.enqueue(payload);
+                produced.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    for (int i = 0; i < consumers; ++i) {
+        threads.emplace_back([&]() {
+            std::string value;
+            while (running.load(std::memory_order_relaxed)) {
+                if (queue.dequeue(value)) {
+                    consumed.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+
+    long baseline = 0;
+    long peak = 0;
+    for (int s = 1; s <= seconds; ++s) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        long rss = rss_kb();
+        if (s == std::min(3, seconds)) {
+            baseline = rss;
+        }
+        peak = std::max(peak, rss);
+        std::cout << "t=" << s << "s rss=" << rss / 1024 << "MB epoch=" << EBRManager::instance().epoch()
+                  << " dequeued=" << consumed.load() << std::endl;
+    }
+    running = false;
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    long growth_mb = (peak - baseline) / 1024;
+    std::cout << "RSS growth after warm-up: " << growth_mb << " MB (limit " << max_growth_mb << " MB)" << std::endl;
+
+    // 线程反复创建退出：退出的线程归还槽位，槽位数不随线程总数增长
+    constexpr int churn_rounds = 200;
+    const int churn_threads = producers + consumers;
+    for (int round = 0; round < churn_rounds; ++round) {
+        std::vector<std::thread> batch;
+        for (int i = 0; i < churn_threads; ++i) {
+            batch.emplace_back([&]() {
+                std::string value;
+                for (int j = 0; j < 1000; ++j) {
+                    queue.enqueue(std::string(48, 'c'));
+                    queue.dequeue(value);
+                }
+            });
+        }
+        for (auto& t : batch) {
+            t.join();
+        }
+    }
+    size_t capacity = EBRManager::instance().slot_capacity();
+    size_t capacity_limit = static_cast<size_t>(producers + consumers + churn_threads + 1) + RECLAIM_SLOTS_PER_CHUNK;
+    std::cout << "Thread churn: " << churn_rounds * churn_threads << " threads, slots in use "
+              << EBRManager::instance().slots_in_use() << ", capacity " << capacity << " (limit " << capacity_limit
+              << ")" << std::endl;
+
+    bool ok = growth_mb <= max_growth_mb && capacity <= capacity_limit;
+    std::cout << (ok ? "Test completed." : "Test FAILED: memory keeps growing.") << std::endl;
+    std::cout << "===============================================" << std::endl;
+    return ok ? 0 : 1;
+}
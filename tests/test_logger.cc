@@ -9,6 +9,7 @@
 
 constinit int thread_count = 12;
 constinit int logs_per_thread = 100000;
+constinit int flush_threads = 0;    // 大于 0 时使用具名实例并按此数量分片
 
 int main(int argc, char* argv[]) {
     {
@@ -17,14 +18,21 @@ int main(int argc, char* argv[]) {
         } else if (argc == 3) {
             thread_count = std::stoi(argv[1]);
             logs_per_thread = std::stoi(argv[2]);
+        } else if (argc == 4) {
+            thread_count = std::stoi(argv[1]);
+            logs_per_thread = std::stoi(argv[2]);
+            flush_threads = std::stoi(argv[3]);
         }
 
-        AsyncLogger<MPMCQueue<LogEntry>>& logger = AsyncLogger<MPMCQueue<LogEntry>>::instance("/home/olivercai/personal/CCcloud/logs/");
+        AsyncLogger<MPMCQueue<LogEntry>>& logger = flush_threads > 0
+            ? AsyncLogger<MPMCQueue<LogEntry>>::named("test", LoggerOptions{"/home/olivercai/personal/CCcloud/logs/", static_cast<size_t>(flush_threads)})
+            : AsyncLogger<MPMCQueue<LogEntry>>::instance("/home/olivercai/personal/CCcloud/logs/");
 
         std::vector<std::thread> threads;
         std::cout << "================ Logger Test ================" << std::endl;
         std::cout << "Start logger test..." << std::endl;
-        std::cout << "Thread count: " << thread_count << ", Logs per thread: " << logs_per_thread << std::endl;
+        std::cout << "Thread count: " << thread_count << ", Logs per thread: " << logs_per_thread
+                  << ", Flush threads: " << std::max(flush_threads, 1) << std::endl;
         auto start = std::chrono::high_resolution_clock::now();
 
         for (int i = 0; i < thread_count; ++i) {
@@ -33,7 +41,7 @@ int main(int argc, char* argv[]) {
                     std::ostringstream oss;
                     oss << "Hahaha! *** Thread " << i << " log " << j << " ***";
                     LogEntry le;
-                    le.params = oss.str();
+                    le.set_params(oss.str());
                     logger.append(std::move(le));
                 }
             });
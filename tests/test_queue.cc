@@ -0,0 +1,160 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tools/EBRQueue.hpp"
+#include "tools/HazardPointers.hpp"
+#include "tools/RingBuffer.hpp"
+#include "tools/SegmentQueue.hpp"
+
+constinit int producers = 4;
+constinit int consumers = 3;
+constinit uint64_t items = 200000;      // 每个生产者
+constinit int timeout_sec = 60;
+constinit size_t ring_capacity = 1024;  // 取小一些，生产者会遇到队列满
+
+// 元素为 (生产者序号 << 32) | 序号，序号从 1 开始
+static uint64_t encode(uint64_t producer, uint64_t seq) {
+    return (producer << 32) | seq;
+}
+
+/*
+    生产者交替使用 enqueue / try_enqueue / enqueue_bulk（批大小 1~37 变化），
+    消费者交替使用 wait_dequeue_for / dequeue / dequeue_bulk。
+    检查每个元素恰好被取出一次，且同一消费者看到的同一生产者的元素保持入队顺序。
+*/
+template <BlockingQueue Q, typename... Args>
+bool check(const char* name, Args&&... args) {
+    Q queue(std::forward<Args>(args)...);
+    const uint64_t total = static_cast<uint64_t>(producers) * items;
+    std::vector<std::atomic<uint8_t>> seen(total);
+    std::atomic<uint64_t> consumed{0};
+    std::atomic<uint64_t> duplicates{0};
+    std::atomic<uint64_t> reordered{0};
+    std::atomic<uint64_t> invalid{0};
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeout_sec);
+    std::vector<std::thread> threads;
+
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p]() {
+            std::vector<uint64_t> batch;
+            uint64_t seq = 1;
+            for (int round = 0; seq <= items; ++round) {
+                switch ((round + p) % 3) {
+                    case 0: {
+                        uint64_t v = encode(p, seq++);
+                        queue.enqueue(std::move(v));
+                        break;
+                    }
+                    case 1: {
+                        uint64_t v = encode(p, seq);
+                        while (!queue.try_enqueue(std::move(v))) {
+                            std::this_thread::yield();  // 有界队列满
+                        }
+                        ++seq;
+                        break;
+                    }
+                    default: {
+                        batch.clear();
+                        size_t n = 1 + static_cast<size_t>(round % 37);
+                        for (; batch.size() < n && seq <= items; ++seq) {
+                            batch.push_back(encode(p, seq));
+                        }
+                        queue.enqueue_bulk(std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()));
+                        break;
+                    }
+                }
+            }
+        });
+    }
+
+    for (int c = 0; c < consumers; ++c) {
+        threads.emplace_back([&, c]() {
+            std::vector<uint64_t> last(producers, 0);
+            std::vector<uint64_t> out;
+            for (int round = 0; consumed.load(std::memory_order_relaxed) < total; ++round) {
+                if (std::chrono::steady_clock::now() > deadline) {
+                    return;
+                }
+                out.clear();
+                uint64_t v = 0;
+                switch ((round + c) % 3) {
+                    case 0:
+                        if (queue.wait_dequeue_for(v, std::chrono::milliseconds(1))) {
+                            out.push_back(v);
+                        }
+                        break;
+                    case 1:
+                        if (queue.dequeue(v)) {
+                            out.push_back(v);
+                        }
+                        break;
+                    default:
+                        queue.dequeue_bulk(std::back_inserter(out), 1 + static_cast<size_t>(round % 50));
+                        break;
+                }
+                for (uint64_t item : out) {
+                    uint64_t p = item >> 32;
+                    uint64_t seq = item & 0xffffffffu;
+                    if (p >= static_cast<uint64_t>(producers) || seq == 0 || seq > items) {
+                        invalid.fetch_add(1, std::memory_order_relaxed);
+                        continue;
+                    }
+                    if (seen[p * items + seq - 1].fetch_add(1, std::memory_order_relaxed) != 0) {
+                        duplicates.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    if (seq <= last[p]) {
+                        reordered.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    last[p] = seq;
+                }
+                consumed.fetch_add(out.size(), std::memory_order_relaxed);
+            }
+        });
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    uint64_t missing = 0;
+    for (const auto& s : seen) {
+        missing += s.load(std::memory_order_relaxed) == 0;
+    }
+    bool ok = missing == 0 && duplicates == 0 && reordered == 0 && invalid == 0 && queue.empty() && queue.size() == 0;
+    std::cout << (ok ? "ok      " : "FAILED  ") << name << ": consumed " << consumed.load() << "/" << total
+              << ", missing " << missing << ", duplicates " << duplicates.load() << ", reordered " << reordered.load()
+              << ", invalid " << invalid.load() << (queue.empty() ? "" : ", queue not empty") << std::endl;
+    return ok;
+}
+
+// 多生产者、多消费者下每个元素恰好出队一次，且保持每个生产者内的顺序；覆盖各队列与各回收器，单个与批量操作混用
+int main(int argc, char* argv[]) {
+    if (argc >= 2) {
+        items = std::stoull(argv[1]);
+    }
+    if (argc >= 4) {
+        producers = std::stoi(argv[2]);
+        consumers = std::stoi(argv[3]);
+    }
+
+    std::cout << "================ Queue Test ================" << std::endl;
+    std::cout << "Producers: " << producers << ", consumers: " << consumers << ", items per producer: " << items
+              << std::endl;
+    bool ok = true;
+    ok &= check<LockFreeMPMCQueue<uint64_t>>("ring", ring_capacity);
+    ok &= check<MPMCQueue<uint64_t>>("mpmc-ebr");
+    ok &= check<MPMCQueue<uint64_t, HazardPointerReclaimer>>("mpmc-hp");
+    ok &= check<MPMCQueue<uint64_t, HazardEraReclaimer>>("mpmc-he");
+    ok &= check<SegmentQueue<uint64_t>>("segment-ebr");
+    ok &= check<SegmentQueue<uint64_t, HazardPointerReclaimer>>("segment-hp");
+    ok &= check<SegmentQueue<uint64_t, HazardEraReclaimer>>("segment-he");
+    std::cout << (ok ? "Test passed." : "Test FAILED.") << std::endl;
+    std::cout << "============================================" << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,87 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "logger/LogAggregator.hpp"
+#include "logger/LogFilter.hpp"
+
+static LogEntry request(OperationType op, grpc::StatusCode code, const std::string& ip) {
+    LogEntry e;
+    e.log_type = LogType::COMMIT;
+    e.operation = op;
+    e.status_code = code;
+    e.duration_ms = 3;
+    e.client.parse_ip(ip);
+    return e;
+}
+
+static bool expect(bool cond, const std::string& what) {
+    std::cout << (cond ? "ok      " : "FAILED  ") << what << std::endl;
+    return cond;
+}
+
+// 按 LogFilter 的判断采样后，返回 query 得到的总数
+static uint64_t sampled_total(int requests, int failed) {
+    LogAggregator aggregator;
+    std::vector<LogEntry> batch;
+    std::mt19937 rng(42);
+    for (int i = 0; i < requests; ++i) {
+        LogEntry e = request(OperationType::DOWNLOAD, i < failed ? grpc::StatusCode::NOT_FOUND : grpc::StatusCode::OK,
+                             "10.0.3.1");
+        for (auto& b : e.uuid.bytes) {
+            b = static_cast<uint8_t>(rng());
+        }
+        bool with_prepare = false;
+        if (LogFilter::instance().keep_commit(e.operation, e.uuid, e.status_code, e.duration_ms, with_prepare, e.sample_ppm)) {
+            batch.push_back(e);
+        }
+    }
+    aggregator.observe(batch);
+    std::string out, error;
+    aggregator.query("last=10 group=", out, error);
+    size_t pos = out.find("count=");
+    return pos == std::string::npos ? 0 : std::stoull(out.substr(pos + 6));
+}
+
+// 同一秒内的组合超过 LOG_ROLLUP_KEYS 时，超出的请求要合并而不是写出槽位，总数保持不变；
+// 采样保留的记录按 1 / 采样率计数，总数仍接近真实请求数
+int main() {
+    LogAggregator aggregator;
+    std::vector<LogEntry> batch;
+    for (int i = 0; i < 70; ++i) {
+        batch.push_back(request(OperationType::UPLOAD, grpc::StatusCode::OK, "10.0.0." + std::to_string(i)));
+    }
+    // client=other 的行占满剩余位置之后，不同 (操作, 状态码) 的请求也要有地方放
+    batch.push_back(request(OperationType::DOWNLOAD, grpc::StatusCode::OK, "10.0.1.1"));
+    batch.push_back(request(OperationType::DELETE, grpc::StatusCode::NOT_FOUND, "10.0.1.2"));
+    for (int code = 1; code < 16; ++code) {
+        batch.push_back(request(OperationType::DOWNLOAD, static_cast<grpc::StatusCode>(code), "10.0.2.1"));
+    }
+    aggregator.observe(batch);
+
+    std::cout << "================ Rollup Test ================" << std::endl;
+    bool ok = true;
+    std::string out, error;
+    ok &= expect(aggregator.query("last=10 group=", out, error), "query without grouping");
+    ok &= expect(out.find("count=" + std::to_string(batch.size()) + " ") != std::string::npos,
+                 "total count is " + std::to_string(batch.size()));
+
+    out.clear();
+    ok &= expect(aggregator.query("last=10", out, error), "query by op, code and client");
+    size_t rows = 0;
+    for (size_t pos = 0; (pos = out.find('\n', pos)) != std::string::npos; ++pos) {
+        ++rows;
+    }
+    ok &= expect(rows <= LOG_ROLLUP_KEYS, "at most " + std::to_string(LOG_ROLLUP_KEYS) + " rows in one second");
+    ok &= expect(out.find("op=other code=other client=other") != std::string::npos, "overflow row present");
+
+    std::string filter_error;
+    ok &= expect(LogFilter::instance().apply("download.sample=0.1", filter_error), "sample downloads at 10%");
+    uint64_t total = sampled_total(20000, 1000);
+    ok &= expect(total > 19000 && total < 21000, "sampled total " + std::to_string(total) + " within 5% of 20000");
+
+    std::cout << (ok ? "Test passed." : "Test FAILED.") << std::endl;
+    std::cout << "=============================================" << std::endl;
+    return ok ? 0 : 1;
+}